@@ -0,0 +1,103 @@
+#include "rt_clock.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef RT_CLOCK_HAVE_TSC
+#include <cpuid.h>
+#endif
+
+#define CALIBRATION_NS 50000000LL
+#define PAIR_TRIES 5
+#define OVERHEAD_SAMPLES 10000
+
+// Минимальная стоимость пары start/end в тиках текущего источника
+static uint64_t measure_overhead(const RtClock* clock) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < OVERHEAD_SAMPLES; ++i) {
+        uint64_t start = rt_clock_start(clock);
+        uint64_t end = rt_clock_end(clock);
+        if (end - start < best) best = end - start;
+    }
+    return best;
+}
+
+#ifdef RT_CLOCK_HAVE_TSC
+// Ядро переключается с tsc на другой clocksource, когда считает TSC
+// нестабильным: такому TSC не доверяем и мы
+static int kernel_trusts_tsc(void) {
+    FILE* f = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+    if (!f) return 1; // нет sysfs — решаем только по CPUID
+    char name[64] = "";
+    int trusted = fgets(name, sizeof(name), f) && strncmp(name, "tsc", 3) == 0;
+    fclose(f);
+    return trusted;
+}
+
+static const char* tsc_unusable_reason(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) || !(edx & (1u << 27))) return "no RDTSCP";
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1u << 8))) return "TSC is not invariant";
+    if (!kernel_trusts_tsc()) return "kernel clocksource is not tsc";
+    return NULL;
+}
+
+// Пара (TSC, CLOCK_MONOTONIC), снятая в самом узком окне из нескольких попыток
+static void sample_pair(uint64_t* ticks, uint64_t* ns) {
+    uint64_t best_window = UINT64_MAX;
+    for (int i = 0; i < PAIR_TRIES; ++i) {
+        uint64_t before = __rdtsc();
+        uint64_t now = rt_clock_monotonic_ns();
+        uint64_t after = __rdtsc();
+        if (after - before < best_window) {
+            best_window = after - before;
+            *ticks = before + (after - before) / 2;
+            *ns = now;
+        }
+    }
+}
+
+static int calibrate_tsc(RtClock* clock) {
+    uint64_t ticks0, ns0, ticks1, ns1;
+    sample_pair(&ticks0, &ns0);
+    struct timespec pause = {.tv_sec = 0, .tv_nsec = CALIBRATION_NS};
+    nanosleep(&pause, NULL);
+    sample_pair(&ticks1, &ns1);
+    if (ticks1 <= ticks0 || ns1 <= ns0) return -1;
+
+    clock->ns_per_tick = (double)(ns1 - ns0) / (double)(ticks1 - ticks0);
+    // 100 МГц .. 10 ГГц: иначе калибровку испортило что-то постороннее
+    return clock->ns_per_tick < 0.1 || clock->ns_per_tick > 10.0 ? -1 : 0;
+}
+#endif
+
+int rt_clock_init(RtClock* clock, unsigned flags) {
+    memset(clock, 0, sizeof(*clock));
+    clock->ns_per_tick = 1.0;
+#ifdef RT_CLOCK_HAVE_TSC
+    clock->reason = (flags & RT_CLOCK_FORCE_MONOTONIC) ? "forced" : tsc_unusable_reason();
+    if (!clock->reason) {
+        if (calibrate_tsc(clock) == 0) {
+            clock->use_tsc = 1;
+        } else {
+            clock->ns_per_tick = 1.0;
+            clock->reason = "TSC calibration failed";
+        }
+    }
+#else
+    (void)flags;
+    clock->reason = "no TSC on this architecture";
+#endif
+    clock->overhead_ticks = measure_overhead(clock);
+    return clock->use_tsc;
+}
+
+void rt_clock_print(const RtClock* clock) {
+    if (clock->use_tsc) {
+        printf("clock: TSC %.3f GHz, start/end overhead %llu ticks (%.1f ns)\n",
+               1.0 / clock->ns_per_tick, (unsigned long long)clock->overhead_ticks,
+               (double)clock->overhead_ticks * clock->ns_per_tick);
+    } else {
+        printf("clock: CLOCK_MONOTONIC (%s), start/end overhead %llu ns\n", clock->reason,
+               (unsigned long long)clock->overhead_ticks);
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef RT_CLOCK_H
+#define RT_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define RT_CLOCK_HAVE_TSC 1
+#endif
+
+/*
+ * Дешевые метки времени для замеров коротких операций.
+ *
+ * Пара clock_gettime через vDSO стоит 40-60 нс — столько же, сколько
+ * pool_alloc, который ею измеряют. Чтение TSC стоит единицы наносекунд,
+ * но пригодно только если TSC инвариантный (не зависит от частоты и
+ * C-состояний, CPUID 0x80000007 EDX[8]) и ядро само ему доверяет
+ * (текущий clocksource — tsc). В виртуальных машинах это часто не так,
+ * и модуль переходит на CLOCK_MONOTONIC через vDSO.
+ *
+ * rt_clock_init() калибрует частоту TSC по CLOCK_MONOTONIC и измеряет
+ * собственную стоимость пары rt_clock_start()/rt_clock_end() — ее можно
+ * вычесть из каждого замера (rt_clock_corrected_ns).
+ *
+ * Барьеры: start — lfence; rdtsc; lfence (предыдущий код завершен,
+ * измеряемый еще не начат), end — rdtscp; lfence (измеряемый код
+ * завершен, следующий еще не начат).
+ */
+
+/** Не использовать TSC, даже если он пригоден */
+#define RT_CLOCK_FORCE_MONOTONIC 0x1
+
+typedef struct {
+    int use_tsc;             /**< 1 — TSC, 0 — CLOCK_MONOTONIC */
+    double ns_per_tick;      /**< 1.0 для CLOCK_MONOTONIC */
+    uint64_t overhead_ticks; /**< минимальная стоимость пары start/end */
+    const char* reason;      /**< почему не TSC (NULL, если TSC) */
+} RtClock;
+
+/**
+ * @brief Выбирает источник времени, калибрует TSC и измеряет накладные расходы.
+ *
+ * Занимает около 50 мс.
+ *
+ * @param clock Куда записать параметры.
+ * @param flags RT_CLOCK_FORCE_MONOTONIC или 0.
+ * @return 1, если используется TSC, 0 — CLOCK_MONOTONIC.
+ */
+int rt_clock_init(RtClock* clock, unsigned flags);
+
+/**
+ * @brief Печатает источник времени, частоту и накладные расходы.
+ */
+void rt_clock_print(const RtClock* clock);
+
+static inline uint64_t rt_clock_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/** Метка перед измеряемым кодом (тики) */
+static inline uint64_t rt_clock_start(const RtClock* clock) {
+#ifdef RT_CLOCK_HAVE_TSC
+    if (clock->use_tsc) {
+        _mm_lfence();
+        uint64_t ticks = __rdtsc();
+        _mm_lfence();
+        return ticks;
+    }
+#endif
+    (void)clock;
+    return rt_clock_monotonic_ns();
+}
+
+/** Метка после измеряемого кода (тики) */
+static inline uint64_t rt_clock_end(const RtClock* clock) {
+#ifdef RT_CLOCK_HAVE_TSC
+    if (clock->use_tsc) {
+        unsigned int aux;
+        uint64_t ticks = __rdtscp(&aux);
+        _mm_lfence();
+        return ticks;
+    }
+#endif
+    (void)clock;
+    return rt_clock_monotonic_ns();
+}
+
+/** Интервал в наносекундах вместе со стоимостью самого замера */
+static inline int64_t rt_clock_raw_ns(const RtClock* clock, uint64_t start, uint64_t end) {
+    return (int64_t)((double)(end - start) * clock->ns_per_tick);
+}
+
+/** Интервал в наносекундах за вычетом стоимости замера (не меньше 0) */
+static inline int64_t rt_clock_corrected_ns(const RtClock* clock, uint64_t start, uint64_t end) {
+    uint64_t ticks = end - start;
+    ticks = ticks > clock->overhead_ticks ? ticks - clock->overhead_ticks : 0;
+    return (int64_t)((double)ticks * clock->ns_per_tick);
+}
+
+#endif // RT_CLOCK_H
@@ -0,0 +1,181 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // RUSAGE_THREAD, sched_getcpu
+#endif
+#include "rt_flight.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define NAME_MAX_LEN 64
+#define MARKER_MAX_LEN 256
+
+static const char* const tracefs_dirs[] = {"/sys/kernel/tracing", "/sys/kernel/debug/tracing"};
+
+struct RtFlight {
+    RtFlightRecord* records;
+    size_t capacity;
+    size_t next;          // следующий слот для записи
+    size_t filled;        // записей в окне (<= capacity)
+    int64_t threshold_ns;
+    const RtTrace* trace;
+    char name[NAME_MAX_LEN];
+    int frozen;           // пишет владелец (1), сбрасывает читатель (0)
+    size_t trigger;       // слот записи, заморозившей кольцо
+    uint64_t events;
+    int primed;           // last снят в потоке-владельце
+    struct rusage last;   // счетчики на прошлом цикле
+};
+
+int rt_trace_open(RtTrace* trace, int stop_on_event) {
+    trace->marker_fd = -1;
+    trace->on_fd = -1;
+    char path[128];
+    for (size_t i = 0; i < sizeof(tracefs_dirs) / sizeof(tracefs_dirs[0]); ++i) {
+        snprintf(path, sizeof(path), "%s/trace_marker", tracefs_dirs[i]);
+        trace->marker_fd = open(path, O_WRONLY | O_CLOEXEC);
+        if (trace->marker_fd < 0) continue;
+        if (stop_on_event) {
+            snprintf(path, sizeof(path), "%s/tracing_on", tracefs_dirs[i]);
+            trace->on_fd = open(path, O_WRONLY | O_CLOEXEC);
+        }
+        return 0;
+    }
+    return -1;
+}
+
+void rt_trace_close(RtTrace* trace) {
+    if (trace->marker_fd >= 0) close(trace->marker_fd);
+    if (trace->on_fd >= 0) close(trace->on_fd);
+    trace->marker_fd = -1;
+    trace->on_fd = -1;
+}
+
+void rt_trace_mark(const RtTrace* trace, const char* fmt, ...) {
+    if (!trace || trace->marker_fd < 0) return;
+    char buf[MARKER_MAX_LEN];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n < 0) return;
+    if ((size_t)n >= sizeof(buf)) n = sizeof(buf) - 1;
+    // Одна запись — одно событие в буфере ftrace
+    ssize_t written = write(trace->marker_fd, buf, (size_t)n);
+    (void)written;
+}
+
+RtFlight* rt_flight_create(const RtFlightConfig* config) {
+    if (!config || config->capacity == 0) return NULL;
+    RtFlight* flight = (RtFlight*)calloc(1, sizeof(RtFlight));
+    if (!flight) return NULL;
+    flight->records = (RtFlightRecord*)malloc(config->capacity * sizeof(RtFlightRecord));
+    if (!flight->records) {
+        free(flight);
+        return NULL;
+    }
+    // Прогрев: запись цикла не должна давать page fault
+    memset(flight->records, 0, config->capacity * sizeof(RtFlightRecord));
+    flight->capacity = config->capacity;
+    flight->threshold_ns = config->threshold_ns;
+    flight->trace = config->trace;
+    snprintf(flight->name, sizeof(flight->name), "%s", config->name ? config->name : "rt_flight");
+    return flight;
+}
+
+void rt_flight_destroy(RtFlight* flight) {
+    if (!flight) return;
+    free(flight->records);
+    free(flight);
+}
+
+int rt_flight_record(RtFlight* flight, uint64_t cycle, int64_t time_ns, int64_t latency_ns) {
+    struct rusage now;
+    getrusage(RUSAGE_THREAD, &now);
+    // Самописец обычно создается другим потоком: первый цикл — без разностей
+    struct rusage last = flight->primed ? flight->last : now;
+    flight->primed = 1;
+    flight->last = now;
+    if (__atomic_load_n(&flight->frozen, __ATOMIC_ACQUIRE)) return 0;
+
+    RtFlightRecord* r = &flight->records[flight->next];
+    r->cycle = cycle;
+    r->time_ns = time_ns;
+    r->latency_ns = latency_ns;
+    r->cpu = sched_getcpu();
+    r->nivcsw = (uint32_t)(now.ru_nivcsw - last.ru_nivcsw);
+    r->minflt = (uint32_t)(now.ru_minflt - last.ru_minflt);
+    r->majflt = (uint32_t)(now.ru_majflt - last.ru_majflt);
+
+    size_t slot = flight->next;
+    flight->next = (flight->next + 1) % flight->capacity;
+    if (flight->filled < flight->capacity) ++flight->filled;
+    if (latency_ns <= flight->threshold_ns) return 0;
+
+    // ftrace останавливается сразу, в RT-потоке: иначе события ядра вокруг
+    // выброса вытеснятся из буфера, пока обычный поток доберется до дампа
+    rt_trace_mark(flight->trace, "rt_flight: %s latency %" PRId64 " ns > %" PRId64 " ns, cycle %" PRIu64
+                  ", cpu %d\n", flight->name, latency_ns, flight->threshold_ns, cycle, r->cpu);
+    if (flight->trace && flight->trace->on_fd >= 0) {
+        ssize_t written = write(flight->trace->on_fd, "0", 1);
+        (void)written;
+    }
+    flight->trigger = slot;
+    __atomic_fetch_add(&flight->events, 1, __ATOMIC_RELAXED);
+    // release: читатель увидит окно целиком
+    __atomic_store_n(&flight->frozen, 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+int rt_flight_frozen(const RtFlight* flight) {
+    return __atomic_load_n(&flight->frozen, __ATOMIC_ACQUIRE);
+}
+
+int rt_flight_trigger(const RtFlight* flight, RtFlightRecord* record) {
+    if (!rt_flight_frozen(flight)) return -1;
+    *record = flight->records[flight->trigger];
+    return 0;
+}
+
+uint64_t rt_flight_events(const RtFlight* flight) {
+    return __atomic_load_n(&flight->events, __ATOMIC_RELAXED);
+}
+
+int rt_flight_dump(const RtFlight* flight, const char* path) {
+    if (!rt_flight_frozen(flight)) {
+        errno = EAGAIN;
+        return -1;
+    }
+    FILE* out = fopen(path, "w");
+    if (!out) return -1;
+
+    const RtFlightRecord* trigger = &flight->records[flight->trigger];
+    fprintf(out, "# %s: latency %" PRId64 " ns > threshold %" PRId64 " ns at cycle %" PRIu64 "\n",
+            flight->name, trigger->latency_ns, flight->threshold_ns, trigger->cycle);
+    fprintf(out, "# %zu cycles, time relative to the spike\n", flight->filled);
+    fprintf(out, "#   %12s %14s %12s %4s %7s %7s %7s\n", "cycle", "time_ns", "latency_ns", "cpu", "nivcsw",
+            "minflt", "majflt");
+    // Окно заканчивается на выбросе: кольцо заморожено сразу после него
+    size_t first = (flight->trigger + flight->capacity + 1 - flight->filled) % flight->capacity;
+    for (size_t i = 0; i < flight->filled; ++i) {
+        size_t slot = (first + i) % flight->capacity;
+        const RtFlightRecord* r = &flight->records[slot];
+        fprintf(out, "%s   %12" PRIu64 " %14" PRId64 " %12" PRId64 " %4d %7u %7u %7u\n",
+                slot == flight->trigger ? "*" : " ", r->cycle, r->time_ns - trigger->time_ns, r->latency_ns,
+                r->cpu, r->nivcsw, r->minflt, r->majflt);
+    }
+    if (fclose(out) != 0) return -1;
+    return 0;
+}
+
+void rt_flight_rearm(RtFlight* flight) {
+    flight->next = 0;
+    flight->filled = 0;
+    __atomic_store_n(&flight->frozen, 0, __ATOMIC_RELEASE);
+}
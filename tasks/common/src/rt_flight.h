@@ -0,0 +1,129 @@
+#ifndef RT_FLIGHT_H
+#define RT_FLIGHT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * "Бортовой самописец" для разбора выбросов задержки.
+ *
+ * Итоговый максимум говорит, что выброс был, но не почему. Самописец
+ * держит на каждый RT-поток кольцо из последних N циклов: время
+ * пробуждения, задержку, CPU, число вынужденных переключений контекста
+ * и page faults за цикл. Когда задержка превышает порог, кольцо
+ * замораживается (дальнейшие циклы не пишутся), в tracefs/trace_marker
+ * пишется метка, и, по желанию, трассировка ядра останавливается
+ * (tracing_on = 0), чтобы буфер ftrace сохранил события вокруг выброса.
+ * Обычный поток сбрасывает окно в файл (rt_flight_dump) и снова
+ * взводит самописец (rt_flight_rearm).
+ *
+ * Запись цикла — getrusage(RUSAGE_THREAD) и sched_getcpu(): один
+ * системный вызов (0.3-1 мкс), без блокировок и выделения памяти.
+ * Кольцо выделяется и прогревается в rt_flight_create(). Пишет в
+ * самописец только его поток; rt_flight_frozen/dump/rearm вызываются
+ * из любого другого, пока кольцо заморожено.
+ */
+
+/** Одна запись кольца */
+typedef struct {
+    uint64_t cycle;       /**< номер цикла */
+    int64_t time_ns;      /**< время пробуждения по часам измерения */
+    int64_t latency_ns;   /**< задержка пробуждения */
+    int32_t cpu;          /**< CPU, на котором проснулся поток */
+    uint32_t nivcsw;      /**< вынужденные переключения контекста за цикл */
+    uint32_t minflt;      /**< minor faults за цикл */
+    uint32_t majflt;      /**< major faults за цикл */
+} RtFlightRecord;
+
+/** Доступ к ftrace (tracefs) */
+typedef struct {
+    int marker_fd;   /**< trace_marker или -1 */
+    int on_fd;       /**< tracing_on или -1 (не останавливать трассировку) */
+} RtTrace;
+
+/** Параметры самописца */
+typedef struct {
+    size_t capacity;        /**< число циклов в окне */
+    int64_t threshold_ns;   /**< порог задержки, при превышении — заморозка */
+    const char* name;       /**< имя в метке и дампе, например "T:0 CPU 3" */
+    const RtTrace* trace;   /**< куда писать метку (NULL — без ftrace) */
+} RtFlightConfig;
+
+typedef struct RtFlight RtFlight;
+
+/**
+ * @brief Открывает trace_marker (и tracing_on, если stop_on_event).
+ *
+ * Ищет tracefs в /sys/kernel/tracing и /sys/kernel/debug/tracing.
+ *
+ * @return 0, если метки доступны, -1 — нет (trace остается пригодным,
+ *         метки просто не пишутся).
+ */
+int rt_trace_open(RtTrace* trace, int stop_on_event);
+
+/**
+ * @brief Закрывает файлы tracefs.
+ */
+void rt_trace_close(RtTrace* trace);
+
+/**
+ * @brief Пишет строку в trace_marker (одна запись write).
+ */
+void rt_trace_mark(const RtTrace* trace, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Создает самописец.
+ *
+ * @return Указатель на самописец или NULL при ошибке.
+ */
+RtFlight* rt_flight_create(const RtFlightConfig* config);
+
+/**
+ * @brief Освобождает самописец.
+ */
+void rt_flight_destroy(RtFlight* flight);
+
+/**
+ * @brief Записывает цикл (только поток-владелец).
+ *
+ * Счетчики и CPU снимаются внутри. Пока кольцо заморожено, циклы не
+ * записываются, но счетчики продолжают сниматься, чтобы разности
+ * после rt_flight_rearm() были верными.
+ *
+ * @return 1, если этот цикл превысил порог и заморозил кольцо, иначе 0.
+ */
+int rt_flight_record(RtFlight* flight, uint64_t cycle, int64_t time_ns, int64_t latency_ns);
+
+/**
+ * @brief Возвращает 1, если кольцо заморожено и ждет сброса.
+ */
+int rt_flight_frozen(const RtFlight* flight);
+
+/**
+ * @brief Запись, заморозившая кольцо.
+ *
+ * @return 0 при успехе, -1, если кольцо не заморожено.
+ */
+int rt_flight_trigger(const RtFlight* flight, RtFlightRecord* record);
+
+/**
+ * @brief Число заморозок с момента создания.
+ */
+uint64_t rt_flight_events(const RtFlight* flight);
+
+/**
+ * @brief Сбрасывает замороженное окно в текстовый файл.
+ *
+ * Строки от старых к новым; время — относительно выброса, выброс
+ * отмечен "*".
+ *
+ * @return 0 при успехе, -1 при ошибке (errno установлен).
+ */
+int rt_flight_dump(const RtFlight* flight, const char* path);
+
+/**
+ * @brief Очищает окно и снова включает запись.
+ */
+void rt_flight_rearm(RtFlight* flight);
+
+#endif // RT_FLIGHT_H
@@ -0,0 +1,287 @@
+#include "rt_hist.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RT_HIST_MAGIC "RTH1"
+#define RT_HIST_MAX_PRECISION 14
+#define VARINT_MAX_BYTES 10
+
+struct RtHist {
+    int64_t max_value;
+    int precision;
+    int bucket_count;
+    uint64_t count;
+    int64_t sum;
+    int64_t min;
+    int64_t max;
+    uint64_t counts[];
+};
+
+static const double print_percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99, 99.999};
+
+// Индекс корзины: точные значения до 2^(p+1), дальше 2^p корзин на октаву
+static inline int bucket_index(int precision, int64_t value) {
+    uint64_t v = (uint64_t)value;
+    if (v < (1ULL << precision)) return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - precision;
+    return (int)(((uint64_t)shift << precision) + (v >> shift));
+}
+
+static inline int64_t bucket_lowest(int precision, int index) {
+    int shift = (index >> precision) - 1;
+    if (shift <= 0) return index;
+    uint64_t sub = ((uint64_t)index & ((1ULL << precision) - 1)) | (1ULL << precision);
+    return (int64_t)(sub << shift);
+}
+
+static inline int64_t bucket_highest(int precision, int index) {
+    return bucket_lowest(precision, index + 1) - 1;
+}
+
+RtHist* rt_hist_create(int64_t max_value, int precision_bits) {
+    if (max_value < 1 || precision_bits < 1 || precision_bits > RT_HIST_MAX_PRECISION) return NULL;
+    int bucket_count = bucket_index(precision_bits, max_value) + 1;
+    RtHist* hist = (RtHist*)malloc(sizeof(RtHist) + (size_t)bucket_count * sizeof(uint64_t));
+    if (!hist) return NULL;
+    hist->max_value = max_value;
+    hist->precision = precision_bits;
+    hist->bucket_count = bucket_count;
+    // memset, а не calloc: страницы счетчиков должны быть заполнены до записи
+    rt_hist_reset(hist);
+    return hist;
+}
+
+void rt_hist_destroy(RtHist* hist) {
+    free(hist);
+}
+
+void rt_hist_reset(RtHist* hist) {
+    memset(hist->counts, 0, (size_t)hist->bucket_count * sizeof(uint64_t));
+    hist->count = 0;
+    hist->sum = 0;
+    hist->min = INT64_MAX;
+    hist->max = INT64_MIN;
+}
+
+void rt_hist_record_n(RtHist* hist, int64_t value, uint64_t count) {
+    if (count == 0) return;
+    if (value < 0) value = 0;
+    int index = value > hist->max_value ? hist->bucket_count - 1 : bucket_index(hist->precision, value);
+    __atomic_fetch_add(&hist->counts[index], count, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->count, count, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->sum, value * (int64_t)count, __ATOMIC_RELAXED);
+
+    int64_t seen = __atomic_load_n(&hist->min, __ATOMIC_RELAXED);
+    while (value < seen && !__atomic_compare_exchange_n(&hist->min, &seen, value, 1,
+                                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    seen = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+    while (value > seen && !__atomic_compare_exchange_n(&hist->max, &seen, value, 1,
+                                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void rt_hist_record(RtHist* hist, int64_t value) {
+    rt_hist_record_n(hist, value, 1);
+}
+
+int rt_hist_merge(RtHist* dst, const RtHist* src) {
+    if (dst->max_value != src->max_value || dst->precision != src->precision) return -1;
+    for (int i = 0; i < src->bucket_count; ++i) {
+        uint64_t n = __atomic_load_n(&src->counts[i], __ATOMIC_RELAXED);
+        if (n) __atomic_fetch_add(&dst->counts[i], n, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&dst->count, __atomic_load_n(&src->count, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_fetch_add(&dst->sum, __atomic_load_n(&src->sum, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+    return 0;
+}
+
+uint64_t rt_hist_count(const RtHist* hist) {
+    return __atomic_load_n(&hist->count, __ATOMIC_RELAXED);
+}
+
+int64_t rt_hist_min(const RtHist* hist) {
+    return rt_hist_count(hist) ? hist->min : 0;
+}
+
+int64_t rt_hist_max(const RtHist* hist) {
+    return rt_hist_count(hist) ? hist->max : 0;
+}
+
+double rt_hist_mean(const RtHist* hist) {
+    uint64_t count = rt_hist_count(hist);
+    return count ? (double)hist->sum / (double)count : 0.0;
+}
+
+double rt_hist_stddev(const RtHist* hist) {
+    uint64_t count = rt_hist_count(hist);
+    if (count == 0) return 0.0;
+    double mean = rt_hist_mean(hist);
+    double sum_sq = 0.0;
+    for (int i = 0; i < hist->bucket_count; ++i) {
+        if (!hist->counts[i]) continue;
+        double mid = ((double)bucket_lowest(hist->precision, i) +
+                      (double)bucket_highest(hist->precision, i)) / 2.0;
+        sum_sq += (double)hist->counts[i] * (mid - mean) * (mid - mean);
+    }
+    return sqrt(sum_sq / (double)count);
+}
+
+int64_t rt_hist_percentile(const RtHist* hist, double percentile) {
+    uint64_t count = rt_hist_count(hist);
+    if (count == 0) return 0;
+    if (percentile <= 0.0) return hist->min;
+    if (percentile > 100.0) percentile = 100.0;
+
+    uint64_t target = (uint64_t)ceil(percentile / 100.0 * (double)count);
+    if (target == 0) target = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < hist->bucket_count; ++i) {
+        seen += hist->counts[i];
+        if (seen >= target) {
+            int64_t value = bucket_highest(hist->precision, i);
+            if (value > hist->max) value = hist->max;
+            if (value < hist->min) value = hist->min;
+            return value;
+        }
+    }
+    return hist->max;
+}
+
+uint64_t rt_hist_count_at_or_below(const RtHist* hist, int64_t value) {
+    if (value < 0) return 0;
+    int last = value > hist->max_value ? hist->bucket_count - 1 : bucket_index(hist->precision, value);
+    uint64_t total = 0;
+    for (int i = 0; i <= last; ++i) total += hist->counts[i];
+    return total;
+}
+
+// Беззнаковый LEB128; отрицательные значения — через zigzag
+static size_t put_varint(uint8_t* out, uint64_t value) {
+    size_t n = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out[n++] = byte | (value ? 0x80 : 0);
+    } while (value);
+    return n;
+}
+
+static int get_varint(const uint8_t** in, const uint8_t* end, uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && *in < end; shift += 7) {
+        uint8_t byte = *(*in)++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static inline uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+size_t rt_hist_serialized_max(const RtHist* hist) {
+    return 4 + 7 * VARINT_MAX_BYTES + (size_t)hist->bucket_count * VARINT_MAX_BYTES;
+}
+
+size_t rt_hist_serialize(const RtHist* hist, void* buffer, size_t capacity) {
+    if (capacity < rt_hist_serialized_max(hist)) return 0;
+    uint8_t* out = (uint8_t*)buffer;
+    size_t n = 0;
+    memcpy(out, RT_HIST_MAGIC, 4);
+    n += 4;
+    n += put_varint(out + n, (uint64_t)hist->precision);
+    n += put_varint(out + n, (uint64_t)hist->max_value);
+    n += put_varint(out + n, (uint64_t)hist->bucket_count);
+    n += put_varint(out + n, hist->count);
+    n += put_varint(out + n, zigzag(hist->sum));
+    n += put_varint(out + n, zigzag(rt_hist_min(hist)));
+    n += put_varint(out + n, zigzag(rt_hist_max(hist)));
+
+    // Счетчик > 0 пишется как есть, серия из k пустых корзин — как -k
+    for (int i = 0; i < hist->bucket_count;) {
+        if (hist->counts[i]) {
+            n += put_varint(out + n, zigzag((int64_t)hist->counts[i]));
+            ++i;
+            continue;
+        }
+        int run = 0;
+        while (i < hist->bucket_count && hist->counts[i] == 0) {
+            ++run;
+            ++i;
+        }
+        // Хвост из пустых корзин не пишется
+        if (i < hist->bucket_count) n += put_varint(out + n, zigzag(-(int64_t)run));
+    }
+    return n;
+}
+
+RtHist* rt_hist_deserialize(const void* buffer, size_t size) {
+    const uint8_t* in = (const uint8_t*)buffer;
+    const uint8_t* end = in + size;
+    if (size < 4 || memcmp(in, RT_HIST_MAGIC, 4) != 0) return NULL;
+    in += 4;
+
+    uint64_t header[7];
+    for (int i = 0; i < 7; ++i) {
+        if (get_varint(&in, end, &header[i]) != 0) return NULL;
+    }
+    if (header[0] > RT_HIST_MAX_PRECISION || header[1] > INT64_MAX) return NULL;
+    RtHist* hist = rt_hist_create((int64_t)header[1], (int)header[0]);
+    if (!hist) return NULL;
+    if ((uint64_t)hist->bucket_count != header[2]) goto corrupt;
+
+    uint64_t total = 0;
+    int index = 0;
+    while (in < end) {
+        uint64_t raw;
+        if (get_varint(&in, end, &raw) != 0) goto corrupt;
+        int64_t entry = unzigzag(raw);
+        if (entry < 0) {
+            if (-entry > hist->bucket_count - index) goto corrupt;
+            index += (int)-entry;
+            continue;
+        }
+        if (index >= hist->bucket_count) goto corrupt;
+        hist->counts[index++] = (uint64_t)entry;
+        total += (uint64_t)entry;
+    }
+    if (total != header[3]) goto corrupt;
+    hist->count = header[3];
+    hist->sum = unzigzag(header[4]);
+    if (total) {
+        hist->min = unzigzag(header[5]);
+        hist->max = unzigzag(header[6]);
+    }
+    return hist;
+
+corrupt:
+    rt_hist_destroy(hist);
+    return NULL;
+}
+
+void rt_hist_print(const RtHist* hist, const char* title, const char* unit) {
+    if (title) printf("%s\n", title);
+    printf("  count %" PRIu64 ", min %" PRId64 " %s, avg %.1f %s, max %" PRId64 " %s, stddev %.1f %s\n",
+           rt_hist_count(hist), rt_hist_min(hist), unit, rt_hist_mean(hist), unit, rt_hist_max(hist),
+           unit, rt_hist_stddev(hist), unit);
+    printf(" ");
+    for (size_t i = 0; i < sizeof(print_percentiles) / sizeof(print_percentiles[0]); ++i) {
+        printf(" p%g %" PRId64, print_percentiles[i], rt_hist_percentile(hist, print_percentiles[i]));
+    }
+    printf(" %s\n", unit);
+}
@@ -0,0 +1,135 @@
+#ifndef RT_HIST_H
+#define RT_HIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Лог-линейная гистограмма задержек (в духе HdrHistogram) постоянного размера.
+ *
+ * Диапазон [0, max_value] делится на интервалы [2^k, 2^(k+1)), каждый из
+ * которых разбит на 2^precision_bits равных корзин; значения меньше
+ * 2^(precision_bits+1) хранятся точно. Относительная ошибка любого
+ * значения не больше 2^-precision_bits (7 бит — 0.8%, 10 бит — 0.1%),
+ * а память зависит только от max_value и точности, но не от длины
+ * прогона: для 10 с в наносекундах и 7 бит это около 28 КБ.
+ *
+ * Запись — O(1) и без блокировок: индекс корзины считается через clz,
+ * счетчики увеличиваются атомарно, поэтому один экземпляр можно
+ * заполнять из нескольких потоков. Для RT-потоков дешевле своя
+ * гистограмма на поток и rt_hist_merge() в конце.
+ *
+ * Отрицательные значения записываются как 0, значения больше max_value —
+ * в последнюю корзину (min/max/среднее при этом остаются точными).
+ */
+
+typedef struct RtHist RtHist;
+
+/** Точность по умолчанию: относительная ошибка меньше 1% */
+#define RT_HIST_DEFAULT_PRECISION 7
+
+/**
+ * @brief Создает гистограмму.
+ *
+ * Память счетчиков выделяется и прогревается сразу: запись в
+ * гистограмму не дает page faults.
+ *
+ * @param max_value Наибольшее различимое значение (>= 1).
+ * @param precision_bits Точность, 1..14 бит.
+ * @return Указатель на гистограмму или NULL при ошибке.
+ */
+RtHist* rt_hist_create(int64_t max_value, int precision_bits);
+
+/**
+ * @brief Освобождает гистограмму.
+ */
+void rt_hist_destroy(RtHist* hist);
+
+/**
+ * @brief Записывает одно значение.
+ */
+void rt_hist_record(RtHist* hist, int64_t value);
+
+/**
+ * @brief Записывает значение count раз.
+ */
+void rt_hist_record_n(RtHist* hist, int64_t value, uint64_t count);
+
+/**
+ * @brief Обнуляет все счетчики.
+ */
+void rt_hist_reset(RtHist* hist);
+
+/**
+ * @brief Добавляет к dst все значения src.
+ *
+ * Вызывается после того, как потоки перестали писать в src и dst.
+ *
+ * @return 0 при успехе, -1, если у гистограмм разные max_value или точность.
+ */
+int rt_hist_merge(RtHist* dst, const RtHist* src);
+
+/** @brief Число записанных значений. */
+uint64_t rt_hist_count(const RtHist* hist);
+
+/** @brief Точный минимум (0 для пустой гистограммы). */
+int64_t rt_hist_min(const RtHist* hist);
+
+/** @brief Точный максимум (0 для пустой гистограммы). */
+int64_t rt_hist_max(const RtHist* hist);
+
+/** @brief Точное среднее. */
+double rt_hist_mean(const RtHist* hist);
+
+/** @brief Стандартное отклонение по серединам корзин. */
+double rt_hist_stddev(const RtHist* hist);
+
+/**
+ * @brief Значение, не меньше которого percentile процентов записей.
+ *
+ * Возвращается верхняя граница корзины (не больше точного максимума),
+ * т.е. оценка никогда не занижает хвост.
+ *
+ * @param percentile 0..100, например 99.999.
+ */
+int64_t rt_hist_percentile(const RtHist* hist, double percentile);
+
+/**
+ * @brief Число записей, не больших value (с точностью до корзины).
+ *
+ * Нужна для вывода гистограммы с собственными границами интервалов.
+ */
+uint64_t rt_hist_count_at_or_below(const RtHist* hist, int64_t value);
+
+/**
+ * @brief Наибольший размер сериализованной гистограммы в байтах.
+ */
+size_t rt_hist_serialized_max(const RtHist* hist);
+
+/**
+ * @brief Сериализует гистограмму в компактный двоичный формат.
+ *
+ * Формат: заголовок (магическое число, параметры, count/min/max/sum),
+ * затем счетчики корзин в виде varint, где серии пустых корзин
+ * сжаты в одну запись.
+ *
+ * @return Число записанных байт или 0, если буфер мал.
+ */
+size_t rt_hist_serialize(const RtHist* hist, void* buffer, size_t capacity);
+
+/**
+ * @brief Восстанавливает гистограмму из rt_hist_serialize().
+ *
+ * @return Новая гистограмма или NULL, если данные повреждены.
+ */
+RtHist* rt_hist_deserialize(const void* buffer, size_t size);
+
+/**
+ * @brief Печатает count/min/mean/max и перцентили p50..p99.999.
+ *
+ * @param title Заголовок (может быть NULL).
+ * @param unit Подпись единиц измерения, например "ns".
+ */
+void rt_hist_print(const RtHist* hist, const char* title, const char* unit);
+
+#endif // RT_HIST_H
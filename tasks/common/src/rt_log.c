@@ -0,0 +1,204 @@
+#include "rt_log.h"
+#include "rt_prefault.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef TMPFS_MAGIC
+#define TMPFS_MAGIC 0x01021994
+#endif
+
+_Static_assert(sizeof(RtLogHeader) <= RT_LOG_HEADER_SIZE, "RtLogHeader does not fit RT_LOG_HEADER_SIZE");
+
+static int64_t realtime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void copy_text(char* dst, size_t size, const char* src) {
+    snprintf(dst, size, "%s", src ? src : "");
+}
+
+static void read_cpu_model(char* dst, size_t size) {
+    copy_text(dst, size, "unknown");
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (!f) return;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "model name", 10) != 0) continue;
+        char* value = strchr(line, ':');
+        if (!value) break;
+        value += strspn(value + 1, " \t") + 1;
+        value[strcspn(value, "\n")] = '\0';
+        copy_text(dst, size, value);
+        break;
+    }
+    fclose(f);
+}
+
+static void describe_policy(char* dst, size_t size) {
+    struct sched_param param;
+    int policy = sched_getscheduler(0);
+    sched_getparam(0, &param);
+    const char* name = policy == SCHED_FIFO ? "SCHED_FIFO" : policy == SCHED_RR ? "SCHED_RR" : "SCHED_OTHER";
+    snprintf(dst, size, "%s %d", name, param.sched_priority);
+}
+
+static void fill_header(RtLogHeader* h, const RtLogConfig* config) {
+    memcpy(h->magic, RT_LOG_MAGIC, sizeof(h->magic));
+    h->version = RT_LOG_VERSION;
+    h->header_size = RT_LOG_HEADER_SIZE;
+    h->field_count = (uint32_t)config->field_count;
+    h->record_size = (uint32_t)(config->field_count * sizeof(int64_t));
+    h->capacity = config->capacity;
+    h->start_realtime_ns = realtime_ns();
+    h->pid = (int32_t)getpid();
+    h->cpu_count = (int32_t)sysconf(_SC_NPROCESSORS_CONF);
+
+    copy_text(h->title, sizeof(h->title), config->title);
+    if (gethostname(h->host, sizeof(h->host) - 1) != 0) copy_text(h->host, sizeof(h->host), "unknown");
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        // version нужна целиком: в ней видно PREEMPT_RT
+        snprintf(h->kernel, sizeof(h->kernel), "%.40s %.70s %.12s", uts.release, uts.version, uts.machine);
+    }
+    read_cpu_model(h->cpu_model, sizeof(h->cpu_model));
+    if (config->policy) copy_text(h->policy, sizeof(h->policy), config->policy);
+    else describe_policy(h->policy, sizeof(h->policy));
+    copy_text(h->clock, sizeof(h->clock), config->clock ? config->clock : "CLOCK_MONOTONIC");
+    for (int i = 0; i < config->field_count; ++i) {
+        copy_text(h->fields[i], sizeof(h->fields[i]), config->fields[i]);
+        copy_text(h->units[i], sizeof(h->units[i]), config->units ? config->units[i] : "");
+    }
+}
+
+int rt_log_create(RtLog* log, const char* path, const RtLogConfig* config) {
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+    if (!config || config->field_count < 1 || config->field_count > RT_LOG_MAX_FIELDS || config->capacity == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    size_t record_size = (size_t)config->field_count * sizeof(int64_t);
+    if (config->capacity > (SIZE_MAX - RT_LOG_HEADER_SIZE) / record_size) {
+        errno = EINVAL;
+        return -1;
+    }
+    size_t map_size = RT_LOG_HEADER_SIZE + config->capacity * record_size;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    // Место под все записи выделяется сразу: запись в отображение за
+    // концом файла дала бы SIGBUS, а дырявый файл — выделение блоков в цикле
+    int rc = posix_fallocate(fd, 0, (off_t)map_size);
+    if (rc == EOPNOTSUPP || rc == EINVAL) rc = ftruncate(fd, (off_t)map_size) == 0 ? 0 : errno;
+    if (rc != 0) {
+        close(fd);
+        errno = rc;
+        return -1;
+    }
+    void* map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+
+    // Прогрев всех записей: rt_log_append не должен давать page faults
+    RtPrefaultConfig prefault = {.lock = config->lock, .numa_node = -1};
+    if (rt_prefault(map, map_size, &prefault, NULL) != 0) {
+        int saved = errno;
+        munmap(map, map_size);
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+
+    log->header = (RtLogHeader*)map;
+    log->records = (int64_t*)((char*)map + RT_LOG_HEADER_SIZE);
+    log->field_count = (uint32_t)config->field_count;
+    log->capacity = config->capacity;
+    log->map_size = map_size;
+    log->fd = fd;
+    log->writable = 1;
+    fill_header(log->header, config);
+    return 0;
+}
+
+int rt_log_on_tmpfs(const RtLog* log) {
+    struct statfs st;
+    if (fstatfs(log->fd, &st) != 0) return -1;
+    return st.f_type == TMPFS_MAGIC ? 1 : 0;
+}
+
+int rt_log_close(RtLog* log) {
+    if (!log->header) return 0;
+    int rc = 0;
+    if (log->writable) {
+        log->header->end_realtime_ns = realtime_ns();
+        size_t used = RT_LOG_HEADER_SIZE + log->count * log->field_count * sizeof(int64_t);
+        if (msync(log->header, log->map_size, MS_SYNC) != 0) rc = -1;
+        munmap(log->header, log->map_size);
+        // Неиспользованный хвост не нужен читателю
+        if (ftruncate(log->fd, (off_t)used) != 0) rc = -1;
+    } else {
+        munmap(log->header, log->map_size);
+    }
+    close(log->fd);
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+    return rc;
+}
+
+int rt_log_open(RtLog* log, const char* path) {
+    memset(log, 0, sizeof(*log));
+    log->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (log->fd < 0) return -1;
+    struct stat st;
+    if (fstat(log->fd, &st) != 0 || (size_t)st.st_size < RT_LOG_HEADER_SIZE) goto invalid;
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, log->fd, 0);
+    if (map == MAP_FAILED) goto invalid;
+    log->header = (RtLogHeader*)map;
+    log->map_size = (size_t)st.st_size;
+
+    const RtLogHeader* h = log->header;
+    if (memcmp(h->magic, RT_LOG_MAGIC, sizeof(h->magic)) != 0 || h->version != RT_LOG_VERSION ||
+        h->header_size != RT_LOG_HEADER_SIZE || h->field_count < 1 || h->field_count > RT_LOG_MAX_FIELDS ||
+        h->record_size != h->field_count * sizeof(int64_t)) {
+        munmap(map, log->map_size);
+        goto invalid;
+    }
+    log->records = (int64_t*)((char*)map + RT_LOG_HEADER_SIZE);
+    log->field_count = h->field_count;
+    // Файл пишущего процесса может быть еще открыт или оборван: верим
+    // только записям, которые целиком есть в файле
+    uint64_t in_file = (log->map_size - RT_LOG_HEADER_SIZE) / h->record_size;
+    uint64_t count = __atomic_load_n(&h->count, __ATOMIC_ACQUIRE);
+    log->count = count < in_file ? count : in_file;
+    log->capacity = log->count;
+    return 0;
+
+invalid:
+    close(log->fd);
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+    errno = EINVAL;
+    return -1;
+}
+
+int rt_log_field(const RtLog* log, const char* name) {
+    for (uint32_t i = 0; i < log->field_count; ++i) {
+        if (strncmp(log->header->fields[i], name, RT_LOG_NAME_LEN) == 0) return (int)i;
+    }
+    return -1;
+}
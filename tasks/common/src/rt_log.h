@@ -0,0 +1,156 @@
+#ifndef RT_LOG_H
+#define RT_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Двоичный журнал замеров в отображенном в память файле.
+ *
+ * Печать результатов в конце прогона теряет сами замеры, а печать в
+ * цикле сама вносит задержки. Журнал пишет каждый замер как запись
+ * фиксированного размера — field_count значений int64_t — прямо в
+ * отображение файла (MAP_SHARED): rt_log_append() — это копирование
+ * нескольких слов и одна запись счетчика в заголовок, без системных
+ * вызовов. Файл создается сразу на capacity записей, отображение
+ * прогревается (rt_prefault) и по желанию блокируется, поэтому в цикле
+ * нет page faults на выделение страниц (но см. ниже про tmpfs); при
+ * переполнении записи отбрасываются и считаются.
+ *
+ * Заголовок (RT_LOG_HEADER_SIZE байт) описывает прогон: имена и единицы
+ * полей, хост, ядро, модель CPU, политику планирования, источник
+ * времени. Счетчик записей в заголовке обновляется после каждой
+ * записи, так что файл читается и после аварийного завершения
+ * процесса. Порядок байт — порядок хоста.
+ *
+ * Без системных вызовов и page faults запись идет только в tmpfs
+ * (/dev/shm). Отображение обычного файла сбрасывается на диск фоновой
+ * записью ядра, и после каждого сброса страница снова защищена от
+ * записи: следующая запись в нее (в том числе в счетчик заголовка) дает
+ * page fault (page_mkwrite), а на дисках со стабильными страницами еще
+ * и ждет окончания записи. rt_log_on_tmpfs() позволяет предупредить об
+ * этом.
+ *
+ * Читает журналы утилита rtanalyze (common/tools) через rt_log_open().
+ */
+
+#define RT_LOG_MAGIC "RTLOG001"
+#define RT_LOG_VERSION 1
+#define RT_LOG_HEADER_SIZE 4096
+#define RT_LOG_MAX_FIELDS 16
+#define RT_LOG_NAME_LEN 32
+#define RT_LOG_UNIT_LEN 16
+#define RT_LOG_TEXT_LEN 128
+
+/** Заголовок файла, RT_LOG_HEADER_SIZE байт */
+typedef struct {
+    char magic[8];                /**< RT_LOG_MAGIC */
+    uint32_t version;             /**< RT_LOG_VERSION */
+    uint32_t header_size;         /**< смещение первой записи */
+    uint32_t field_count;         /**< значений int64_t в записи */
+    uint32_t record_size;         /**< байт на запись */
+    uint64_t capacity;            /**< мест под записи в файле */
+    uint64_t count;               /**< записано */
+    uint64_t dropped;             /**< отброшено из-за переполнения */
+    int64_t start_realtime_ns;    /**< CLOCK_REALTIME при создании */
+    int64_t end_realtime_ns;      /**< CLOCK_REALTIME при закрытии (0 — не закрыт) */
+    int32_t pid;
+    int32_t cpu_count;            /**< CPU в системе */
+    char title[RT_LOG_TEXT_LEN];  /**< что измерялось */
+    char host[RT_LOG_TEXT_LEN];
+    char kernel[RT_LOG_TEXT_LEN]; /**< uname: release и version */
+    char cpu_model[RT_LOG_TEXT_LEN];
+    char policy[RT_LOG_TEXT_LEN]; /**< например "SCHED_FIFO 80, CPU 3" */
+    char clock[RT_LOG_TEXT_LEN];  /**< например "TSC 2.100 GHz" */
+    char fields[RT_LOG_MAX_FIELDS][RT_LOG_NAME_LEN];
+    char units[RT_LOG_MAX_FIELDS][RT_LOG_UNIT_LEN];
+} RtLogHeader;
+
+/** Параметры нового журнала */
+typedef struct {
+    const char* title;
+    const char* policy;          /**< NULL — политика вызывающего потока */
+    const char* clock;           /**< NULL — "CLOCK_MONOTONIC" */
+    const char* const* fields;   /**< имена полей */
+    const char* const* units;    /**< единицы полей (может быть NULL) */
+    int field_count;             /**< 1..RT_LOG_MAX_FIELDS */
+    size_t capacity;             /**< мест под записи */
+    int lock;                    /**< заблокировать отображение в памяти (неудача mlock — ошибка) */
+} RtLogConfig;
+
+/** Журнал, открытый на запись или на чтение */
+typedef struct {
+    RtLogHeader* header;     /**< начало отображения */
+    int64_t* records;        /**< первая запись */
+    uint32_t field_count;
+    uint64_t capacity;
+    uint64_t count;          /**< копия header->count (пишет только владелец) */
+    size_t map_size;
+    int fd;
+    int writable;
+} RtLog;
+
+/**
+ * @brief Создает файл журнала и отображает его в память.
+ *
+ * Существующий файл перезаписывается.
+ *
+ * @return 0 при успехе, -1 при ошибке (errno установлен).
+ */
+int rt_log_create(RtLog* log, const char* path, const RtLogConfig* config);
+
+/**
+ * @brief Добавляет запись из field_count значений (только один поток).
+ *
+ * @return 0 при успехе, -1, если журнал полон (запись учтена в dropped).
+ */
+static inline int rt_log_append(RtLog* log, const int64_t* values) {
+    if (log->count == log->capacity) {
+        __atomic_store_n(&log->header->dropped, log->header->dropped + 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+    int64_t* slot = log->records + log->count * log->field_count;
+    for (uint32_t i = 0; i < log->field_count; ++i) slot[i] = values[i];
+    // release: читатель, увидевший count, видит и запись
+    __atomic_store_n(&log->header->count, ++log->count, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief Лежит ли файл журнала в tmpfs.
+ *
+ * @return 1 — tmpfs, 0 — другая файловая система (запись может давать
+ *         page faults), -1 — ошибка.
+ */
+int rt_log_on_tmpfs(const RtLog* log);
+
+/**
+ * @brief Закрывает журнал.
+ *
+ * Для журнала на запись записывает время окончания и обрезает файл
+ * до фактического числа записей.
+ *
+ * @return 0 при успехе, -1 при ошибке.
+ */
+int rt_log_close(RtLog* log);
+
+/**
+ * @brief Открывает журнал на чтение и проверяет заголовок.
+ *
+ * @return 0 при успехе, -1, если файл не читается или не журнал.
+ */
+int rt_log_open(RtLog* log, const char* path);
+
+/**
+ * @brief Индекс поля по имени или -1.
+ */
+int rt_log_field(const RtLog* log, const char* name);
+
+/**
+ * @brief Значение поля field записи index.
+ */
+static inline int64_t rt_log_value(const RtLog* log, uint64_t index, int field) {
+    return log->records[index * log->field_count + (uint64_t)field];
+}
+
+#endif // RT_LOG_H
@@ -0,0 +1,78 @@
+#ifndef RT_MEM_H
+#define RT_MEM_H
+
+#include <stddef.h>
+
+/*
+ * Подготовка памяти процесса реального времени одним вызовом.
+ *
+ * rt_mem_prepare():
+ *   1. mlockall(MCL_CURRENT | MCL_FUTURE) — ни одна страница процесса
+ *      не будет вытеснена, новые отображения сразу заполняются (с on_fault —
+ *      MCL_ONFAULT: заполняются при первом касании, см. rt_prefault.h);
+ *   2. mallopt(M_MMAP_MAX, 0) и mallopt(M_TRIM_THRESHOLD, -1) — malloc
+ *      берет память только из кучи (brk) и никогда не возвращает ее ядру;
+ *   3. прогревает резерв кучи: выделяет heap_reserve байт, пишет в каждую
+ *      страницу и освобождает — страницы остаются в куче процесса;
+ *   4. прогревает stack_reserve байт стека вызывающего потока;
+ *   5. читает VmLck/VmRSS из /proc/self/status для отчета.
+ *
+ * Каждый RT-поток, созданный позже, должен в начале работы вызвать
+ * rt_mem_prefault_stack() со своим рабочим объемом стека.
+ */
+
+/** Параметры подготовки памяти */
+typedef struct {
+    size_t heap_reserve;   /**< байт кучи, которые нужно прогреть */
+    size_t stack_reserve;  /**< байт стека вызывающего потока, которые нужно прогреть */
+    int on_fault;          /**< добавить MCL_ONFAULT: новые отображения блокируются по мере
+                                заполнения, большие регионы прогреваются rt_prefault() */
+} RtMemConfig;
+
+/** Результат подготовки памяти */
+typedef struct {
+    int locked;               /**< mlockall выполнен успешно */
+    int malloc_tuned;         /**< оба вызова mallopt выполнены успешно */
+    size_t heap_prefaulted;   /**< прогрето байт кучи */
+    size_t stack_prefaulted;  /**< прогрето байт стека */
+    size_t vm_locked;         /**< VmLck, байт */
+    size_t vm_rss;            /**< VmRSS, байт */
+    long minor_faults;        /**< minor faults, которые произошли во время подготовки */
+    long long elapsed_ns;     /**< время подготовки */
+} RtMemReport;
+
+/**
+ * @brief Блокирует и прогревает память процесса.
+ * 
+ * @param config Параметры (NULL — без резервов кучи и стека).
+ * @param report Куда записать отчет (может быть NULL).
+ * @return 0 при успехе, -1, если mlockall не удался (остальные шаги
+ *         все равно выполняются, отчет заполняется).
+ */
+int rt_mem_prepare(const RtMemConfig* config, RtMemReport* report);
+
+/**
+ * @brief Прогревает bytes байт стека текущего потока.
+ * 
+ * Вызывается в начале каждого RT-потока, до входа в рабочий цикл.
+ * 
+ * @param bytes Объем стека (меньше размера стека потока).
+ * @return Число прогретых байт.
+ */
+size_t rt_mem_prefault_stack(size_t bytes);
+
+/**
+ * @brief Читает VmLck и VmRSS из /proc/self/status.
+ * 
+ * @param vm_locked Куда записать VmLck в байтах.
+ * @param vm_rss Куда записать VmRSS в байтах.
+ * @return 0 при успехе, -1, если файл недоступен.
+ */
+int rt_mem_read_status(size_t* vm_locked, size_t* vm_rss);
+
+/**
+ * @brief Печатает отчет rt_mem_prepare() в stdout.
+ */
+void rt_mem_print_report(const RtMemReport* report);
+
+#endif // RT_MEM_H
@@ -0,0 +1,295 @@
+#include "rt_prefault.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23 // Linux 5.14+
+#endif
+#ifndef MLOCK_ONFAULT
+#define MLOCK_ONFAULT 0x01
+#endif
+#define RT_MPOL_PREFERRED 1 // из linux/mempolicy.h, без зависимости от libnuma
+
+#define WORKER_STACK_SIZE (64 * 1024)
+
+struct RtPrefaultJob {
+    char* addr;
+    size_t length;
+    size_t chunk_size;
+    size_t chunk_count;
+    atomic_size_t next_chunk;
+    atomic_size_t done_bytes;
+    atomic_int use_populate;  // сбрасывается, если ядро не знает MADV_POPULATE_WRITE
+
+    int thread_count;
+    int cpus[RT_PREFAULT_MAX_THREADS];
+    pthread_t threads[RT_PREFAULT_MAX_THREADS];
+
+    RtPrefaultProgress progress;
+    void* progress_ctx;
+
+    // Барьер готовности
+    pthread_mutex_t lock;
+    pthread_cond_t ready_cond;
+    int workers_left;
+    int ready;
+    int error;
+
+    long long start_ns;
+    long long elapsed_ns;
+};
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static size_t page_size(void) {
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (size_t)size : 4096;
+}
+
+// Разбирает список CPU вида "0-3,8,10-11" в маску
+static void parse_cpu_list(const char* list, cpu_set_t* set) {
+    CPU_ZERO(set);
+    const char* p = list;
+    while (*p) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) CPU_SET((int)cpu, set);
+        if (*p != ',') break;
+        ++p;
+    }
+}
+
+int rt_prefault_housekeeping_cpus(int* cpus, int max) {
+    cpu_set_t allowed, isolated;
+    CPU_ZERO(&isolated);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        CPU_SET(0, &allowed);
+    }
+    FILE* f = fopen("/sys/devices/system/cpu/isolated", "r");
+    if (f) {
+        char line[1024] = "";
+        if (fgets(line, sizeof(line), f)) parse_cpu_list(line, &isolated);
+        fclose(f);
+    }
+
+    int count = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && count < max; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed) && !CPU_ISSET(cpu, &isolated)) cpus[count++] = cpu;
+    }
+    // Все разрешенные CPU изолированы: работаем там, где разрешено
+    for (int cpu = 0; cpu < CPU_SETSIZE && count == 0; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) cpus[count++] = cpu;
+    }
+    if (count == 0) cpus[count++] = 0;
+    return count;
+}
+
+static void touch_range(char* start, size_t length) {
+    volatile char* p = start;
+    size_t step = page_size();
+    for (size_t offset = 0; offset < length; offset += step) p[offset] = 0;
+}
+
+static int populate_chunk(RtPrefaultJob* job, char* start, size_t length) {
+    if (atomic_load_explicit(&job->use_populate, memory_order_relaxed)) {
+        if (madvise(start, length, MADV_POPULATE_WRITE) == 0) return 0;
+        if (errno != EINVAL) return -1;
+        atomic_store_explicit(&job->use_populate, 0, memory_order_relaxed);
+    }
+    touch_range(start, length);
+    return 0;
+}
+
+static void* prefault_worker(void* arg) {
+    RtPrefaultJob* job = (RtPrefaultJob*)arg;
+    int error = 0;
+
+    for (;;) {
+        size_t index = atomic_fetch_add_explicit(&job->next_chunk, 1, memory_order_relaxed);
+        if (index >= job->chunk_count) break;
+        size_t offset = index * job->chunk_size;
+        size_t length = job->length - offset < job->chunk_size ? job->length - offset : job->chunk_size;
+        if (populate_chunk(job, job->addr + offset, length) != 0) {
+            error = errno;
+            // Остальные куски никто не возьмет: прогрев все равно провален
+            atomic_store_explicit(&job->next_chunk, job->chunk_count, memory_order_relaxed);
+            break;
+        }
+        size_t done = atomic_fetch_add_explicit(&job->done_bytes, length, memory_order_relaxed) + length;
+        if (job->progress) {
+            pthread_mutex_lock(&job->lock);
+            job->progress(done, job->length, job->progress_ctx);
+            pthread_mutex_unlock(&job->lock);
+        }
+    }
+
+    pthread_mutex_lock(&job->lock);
+    if (error && !job->error) job->error = error;
+    if (--job->workers_left == 0) {
+        job->elapsed_ns = now_ns() - job->start_ns;
+        job->ready = 1;
+        pthread_cond_broadcast(&job->ready_cond);
+    }
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+static int bind_to_node(void* addr, size_t length, int node) {
+    unsigned long nodemask[16] = {0};
+    if (node < 0 || (size_t)node >= sizeof(nodemask) * 8) {
+        errno = EINVAL;
+        return -1;
+    }
+    nodemask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    return (int)syscall(SYS_mbind, addr, length, RT_MPOL_PREFERRED, nodemask,
+                        sizeof(nodemask) * 8, 0);
+}
+
+RtPrefaultJob* rt_prefault_start(void* addr, size_t length, const RtPrefaultConfig* config) {
+    RtPrefaultConfig defaults = {.numa_node = -1};
+    if (!config) config = &defaults;
+    if (!addr || length == 0 || ((size_t)addr & (page_size() - 1)) != 0 ||
+        config->threads < 0 || config->threads > RT_PREFAULT_MAX_THREADS) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    RtPrefaultJob* job = (RtPrefaultJob*)calloc(1, sizeof(RtPrefaultJob));
+    if (!job) return NULL;
+    job->addr = (char*)addr;
+    job->length = length;
+    job->chunk_size = config->chunk_size ? config->chunk_size : RT_PREFAULT_DEFAULT_CHUNK;
+    job->chunk_size = (job->chunk_size + page_size() - 1) & ~(page_size() - 1);
+    job->chunk_count = (length + job->chunk_size - 1) / job->chunk_size;
+    atomic_init(&job->next_chunk, 0);
+    atomic_init(&job->done_bytes, 0);
+    atomic_init(&job->use_populate, 1);
+    job->progress = config->progress;
+    job->progress_ctx = config->progress_ctx;
+    pthread_mutex_init(&job->lock, NULL);
+    pthread_cond_init(&job->ready_cond, NULL);
+
+    int cpu_count = rt_prefault_housekeeping_cpus(job->cpus, RT_PREFAULT_MAX_THREADS);
+    job->thread_count = config->threads ? config->threads : cpu_count;
+    if ((size_t)job->thread_count > job->chunk_count) job->thread_count = (int)job->chunk_count;
+    // Потоков больше, чем ядер: раздаем ядра по кругу
+    for (int i = cpu_count; i < job->thread_count; ++i) job->cpus[i] = job->cpus[i % cpu_count];
+
+    // Политика NUMA и блокировка ставятся до первого касания страниц
+    if (config->numa_node >= 0 && bind_to_node(addr, length, config->numa_node) != 0) goto fail;
+    if (config->lock && mlock2(addr, length, MLOCK_ONFAULT) != 0) goto fail;
+
+    // Рабочие потоки — обычные (SCHED_OTHER), даже если их запускает RT-поток
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, WORKER_STACK_SIZE);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    struct sched_param sp = {.sched_priority = 0};
+    pthread_attr_setschedparam(&attr, &sp);
+
+    job->workers_left = job->thread_count;
+    job->start_ns = now_ns();
+    for (int i = 0; i < job->thread_count; ++i) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(job->cpus[i], &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        int rc = pthread_create(&job->threads[i], &attr, prefault_worker, job);
+        if (rc != 0) {
+            // Уже запущенные потоки доделают работу за всех
+            pthread_mutex_lock(&job->lock);
+            job->workers_left -= job->thread_count - i;
+            job->thread_count = i;
+            if (i > 0 && job->workers_left == 0) {
+                job->elapsed_ns = now_ns() - job->start_ns;
+                job->ready = 1;
+                pthread_cond_broadcast(&job->ready_cond);
+            }
+            pthread_mutex_unlock(&job->lock);
+            if (i == 0) {
+                pthread_attr_destroy(&attr);
+                errno = rc;
+                goto fail;
+            }
+            break;
+        }
+    }
+    pthread_attr_destroy(&attr);
+    return job;
+
+fail:
+    pthread_mutex_destroy(&job->lock);
+    pthread_cond_destroy(&job->ready_cond);
+    free(job);
+    return NULL;
+}
+
+int rt_prefault_wait(RtPrefaultJob* job) {
+    pthread_mutex_lock(&job->lock);
+    while (!job->ready) pthread_cond_wait(&job->ready_cond, &job->lock);
+    int error = job->error;
+    pthread_mutex_unlock(&job->lock);
+    if (error) {
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
+
+int rt_prefault_ready(RtPrefaultJob* job) {
+    pthread_mutex_lock(&job->lock);
+    int ready = job->ready;
+    pthread_mutex_unlock(&job->lock);
+    return ready;
+}
+
+size_t rt_prefault_done_bytes(RtPrefaultJob* job) {
+    return atomic_load_explicit(&job->done_bytes, memory_order_relaxed);
+}
+
+int rt_prefault_finish(RtPrefaultJob* job, RtPrefaultStats* stats) {
+    for (int i = 0; i < job->thread_count; ++i) pthread_join(job->threads[i], NULL);
+    if (stats) {
+        stats->threads = job->thread_count;
+        stats->bytes = atomic_load_explicit(&job->done_bytes, memory_order_relaxed);
+        stats->used_populate = atomic_load_explicit(&job->use_populate, memory_order_relaxed);
+        stats->elapsed_ns = job->elapsed_ns;
+    }
+    int error = job->error;
+    pthread_mutex_destroy(&job->lock);
+    pthread_cond_destroy(&job->ready_cond);
+    free(job);
+    if (error) {
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
+
+int rt_prefault(void* addr, size_t length, const RtPrefaultConfig* config, RtPrefaultStats* stats) {
+    RtPrefaultJob* job = rt_prefault_start(addr, length, config);
+    if (!job) return -1;
+    return rt_prefault_finish(job, stats);
+}
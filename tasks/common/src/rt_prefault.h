@@ -0,0 +1,126 @@
+#ifndef RT_PREFAULT_H
+#define RT_PREFAULT_H
+
+#include <stddef.h>
+
+/*
+ * Параллельный прогрев больших регионов памяти.
+ *
+ * Последовательный цикл записи по байту в страницу прогревает около
+ * 1 ГБ/с: регион в несколько гигабайт держит процесс вне работы секунды.
+ * Здесь регион делится на куски (по умолчанию 4 МБ), которые разбирают
+ * рабочие потоки на housekeeping-ядрах — CPU из маски процесса, не
+ * входящих в /sys/devices/system/cpu/isolated. Кусок заполняется одним
+ * madvise(MADV_POPULATE_WRITE), без исключения на каждую страницу; на
+ * ядрах до 5.14 — циклом записи.
+ *
+ * Два режима:
+ *   - rt_prefault() — блокирующий: возвращается, когда регион прогрет;
+ *   - rt_prefault_start() — ленивый: регион блокируется через
+ *     mlock2(MLOCK_ONFAULT) (страницы блокируются по мере заполнения),
+ *     прогрев идет в фоне, а RT-потоки перед входом в рабочий цикл ждут
+ *     готовности в rt_prefault_wait().
+ *
+ * Регионы, отображенные после mlockall(MCL_FUTURE) без MCL_ONFAULT, ядро
+ * заполняет прямо в mmap; для параллельного прогрева таких регионов
+ * процесс блокируется с RtMemConfig.on_fault = 1 (см. rt_mem.h).
+ *
+ * Рабочие потоки создаются с SCHED_OTHER независимо от политики
+ * вызывающего потока, чтобы не конкурировать с RT-потоками.
+ */
+
+#define RT_PREFAULT_MAX_THREADS 64
+#define RT_PREFAULT_DEFAULT_CHUNK (4 * 1024 * 1024)
+
+/**
+ * @brief Обратный вызов прогресса.
+ *
+ * Вызывается из рабочих потоков после каждого куска, вызовы
+ * сериализованы.
+ */
+typedef void (*RtPrefaultProgress)(size_t done_bytes, size_t total_bytes, void* ctx);
+
+/** Параметры прогрева */
+typedef struct {
+    int threads;          /**< число потоков (0 — по одному на housekeeping-ядро) */
+    int lock;             /**< заблокировать регион (mlock2 с MLOCK_ONFAULT) */
+    int numa_node;        /**< >= 0: предпочитать страницы этого узла NUMA (mbind);
+                               -1: первое касание, т.е. узел рабочего потока */
+    size_t chunk_size;    /**< размер куска (0 — RT_PREFAULT_DEFAULT_CHUNK) */
+    RtPrefaultProgress progress;  /**< обратный вызов прогресса (может быть NULL) */
+    void* progress_ctx;           /**< аргумент обратного вызова */
+} RtPrefaultConfig;
+
+/** Итоги прогрева */
+typedef struct {
+    int threads;             /**< сколько потоков работало */
+    size_t bytes;            /**< прогрето байт */
+    int used_populate;       /**< 1 — MADV_POPULATE_WRITE, 0 — цикл записи */
+    long long elapsed_ns;    /**< от старта до готовности региона */
+} RtPrefaultStats;
+
+typedef struct RtPrefaultJob RtPrefaultJob;
+
+/**
+ * @brief Прогревает регион параллельно и ждет окончания.
+ *
+ * @param addr Начало региона (выровнено по странице).
+ * @param length Длина региона в байтах.
+ * @param config Параметры (NULL — по умолчанию, без блокировки).
+ * @param stats Куда записать итоги (может быть NULL).
+ * @return 0 при успехе, -1 при ошибке (errno установлен).
+ */
+int rt_prefault(void* addr, size_t length, const RtPrefaultConfig* config, RtPrefaultStats* stats);
+
+/**
+ * @brief Запускает фоновый прогрев региона.
+ *
+ * @param addr Начало региона (выровнено по странице).
+ * @param length Длина региона в байтах.
+ * @param config Параметры (NULL — по умолчанию, без блокировки).
+ * @return Указатель на задачу или NULL при ошибке (errno установлен).
+ */
+RtPrefaultJob* rt_prefault_start(void* addr, size_t length, const RtPrefaultConfig* config);
+
+/**
+ * @brief Барьер готовности: ждет, пока весь регион будет прогрет.
+ *
+ * Может вызываться из любого числа потоков одновременно.
+ *
+ * @param job Задача прогрева.
+ * @return 0, если регион прогрет, -1, если прогрев завершился ошибкой.
+ */
+int rt_prefault_wait(RtPrefaultJob* job);
+
+/**
+ * @brief Возвращает 1, если регион уже прогрет (без ожидания).
+ */
+int rt_prefault_ready(RtPrefaultJob* job);
+
+/**
+ * @brief Сколько байт уже прогрето.
+ */
+size_t rt_prefault_done_bytes(RtPrefaultJob* job);
+
+/**
+ * @brief Дожидается рабочих потоков и освобождает задачу.
+ *
+ * Вызывается один раз, когда ни один поток больше не ждет в
+ * rt_prefault_wait().
+ *
+ * @param job Задача прогрева.
+ * @param stats Куда записать итоги (может быть NULL).
+ * @return 0 при успехе, -1, если прогрев завершился ошибкой.
+ */
+int rt_prefault_finish(RtPrefaultJob* job, RtPrefaultStats* stats);
+
+/**
+ * @brief Заполняет cpus номерами housekeeping-ядер.
+ *
+ * @param cpus Массив для номеров CPU.
+ * @param max Размер массива.
+ * @return Число найденных ядер (не меньше 1).
+ */
+int rt_prefault_housekeeping_cpus(int* cpus, int max);
+
+#endif // RT_PREFAULT_H
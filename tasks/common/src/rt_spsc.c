@@ -0,0 +1,82 @@
+#include "rt_spsc.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_LINE 64
+
+struct RtSpsc {
+    // Сторона писателя
+    _Alignas(CACHE_LINE) size_t head;
+    size_t cached_tail;
+    // Сторона читателя
+    _Alignas(CACHE_LINE) size_t tail;
+    size_t cached_head;
+    // Неизменяемые параметры
+    _Alignas(CACHE_LINE) size_t mask;
+    size_t record_size;
+    unsigned char* records;
+};
+
+RtSpsc* rt_spsc_create(size_t capacity, size_t record_size) {
+    if (capacity == 0 || record_size == 0 || capacity > SIZE_MAX / 2) return NULL;
+    size_t slots = 1;
+    while (slots < capacity) slots <<= 1;
+    if (record_size > SIZE_MAX / slots) return NULL;
+
+    RtSpsc* channel = (RtSpsc*)aligned_alloc(CACHE_LINE, sizeof(RtSpsc));
+    if (!channel) return NULL;
+    memset(channel, 0, sizeof(*channel));
+    channel->mask = slots - 1;
+    channel->record_size = record_size;
+    channel->records = (unsigned char*)malloc(slots * record_size);
+    if (!channel->records) {
+        free(channel);
+        return NULL;
+    }
+    // Прогрев: первая запись в канал не должна давать page fault
+    memset(channel->records, 0, slots * record_size);
+    return channel;
+}
+
+void rt_spsc_destroy(RtSpsc* channel) {
+    if (!channel) return;
+    free(channel->records);
+    free(channel);
+}
+
+int rt_spsc_push(RtSpsc* channel, const void* record) {
+    size_t head = channel->head;
+    if (head - channel->cached_tail > channel->mask) {
+        channel->cached_tail = __atomic_load_n(&channel->tail, __ATOMIC_ACQUIRE);
+        if (head - channel->cached_tail > channel->mask) return -1;
+    }
+    memcpy(channel->records + (head & channel->mask) * channel->record_size, record,
+           channel->record_size);
+    // release: читатель увидит запись не раньше нового head
+    __atomic_store_n(&channel->head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int rt_spsc_pop(RtSpsc* channel, void* record) {
+    size_t tail = channel->tail;
+    if (tail == channel->cached_head) {
+        channel->cached_head = __atomic_load_n(&channel->head, __ATOMIC_ACQUIRE);
+        if (tail == channel->cached_head) return -1;
+    }
+    memcpy(record, channel->records + (tail & channel->mask) * channel->record_size,
+           channel->record_size);
+    // release: писатель переиспользует ячейку только после копирования
+    __atomic_store_n(&channel->tail, tail + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+size_t rt_spsc_size(RtSpsc* channel) {
+    size_t head = __atomic_load_n(&channel->head, __ATOMIC_ACQUIRE);
+    size_t tail = __atomic_load_n(&channel->tail, __ATOMIC_ACQUIRE);
+    return head - tail;
+}
+
+size_t rt_spsc_capacity(const RtSpsc* channel) {
+    return channel->mask + 1;
+}
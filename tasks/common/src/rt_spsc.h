@@ -0,0 +1,59 @@
+#ifndef RT_SPSC_H
+#define RT_SPSC_H
+
+#include <stddef.h>
+
+/*
+ * Неблокирующий канал "один писатель — один читатель" (SPSC) для передачи
+ * записей фиксированного размера из RT-потока в обычный поток и обратно.
+ *
+ * Кольцевой буфер на 2^k записей; индексы писателя и читателя лежат в
+ * разных кэш-линиях, каждая сторона держит копию чужого индекса и
+ * перечитывает его, только когда буфер кажется полным (пустым). push и
+ * pop — O(1), без блокировок и системных вызовов; при полном буфере
+ * push сразу возвращает -1, и RT-поток решает, что делать с записью.
+ *
+ * Память буфера выделяется и прогревается в rt_spsc_create().
+ */
+
+typedef struct RtSpsc RtSpsc;
+
+/**
+ * @brief Создает канал.
+ *
+ * @param capacity Число записей (округляется вверх до степени двойки).
+ * @param record_size Размер записи в байтах.
+ * @return Указатель на канал или NULL при ошибке.
+ */
+RtSpsc* rt_spsc_create(size_t capacity, size_t record_size);
+
+/**
+ * @brief Освобождает канал.
+ */
+void rt_spsc_destroy(RtSpsc* channel);
+
+/**
+ * @brief Кладет копию записи в канал (только поток-писатель).
+ *
+ * @return 0 при успехе, -1, если канал полон.
+ */
+int rt_spsc_push(RtSpsc* channel, const void* record);
+
+/**
+ * @brief Забирает самую старую запись (только поток-читатель).
+ *
+ * @return 0 при успехе, -1, если канал пуст.
+ */
+int rt_spsc_pop(RtSpsc* channel, void* record);
+
+/**
+ * @brief Число записей в канале (приблизительно, если стороны работают).
+ */
+size_t rt_spsc_size(RtSpsc* channel);
+
+/**
+ * @brief Емкость канала в записях.
+ */
+size_t rt_spsc_capacity(const RtSpsc* channel);
+
+#endif // RT_SPSC_H
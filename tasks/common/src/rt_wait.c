@@ -0,0 +1,130 @@
+#include "rt_wait.h"
+#include <errno.h>
+#include <string.h>
+
+#define NSEC_PER_SEC 1000000000LL
+
+// Опрос часов вежлив к соседнему гиперпотоку
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define CPU_RELAX() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define CPU_RELAX() ((void)0)
+#endif
+
+static inline int64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void apply_defaults(RtWaitConfig* c) {
+    if (c->clock == 0) c->clock = CLOCK_MONOTONIC;
+    if (c->percentile <= 0.0 || c->percentile > 100.0) c->percentile = RT_WAIT_DEFAULT_PERCENTILE;
+    if (c->spin_budget == 0.0) c->spin_budget = RT_WAIT_DEFAULT_BUDGET;
+    if (c->spin_budget > 1.0) c->spin_budget = 1.0;
+    if (c->window < 2) c->window = RT_WAIT_DEFAULT_WINDOW;
+    if (c->max_margin_ns <= 0) c->max_margin_ns = RT_WAIT_DEFAULT_MAX_MARGIN;
+    if (c->min_margin_ns < 0) c->min_margin_ns = 0;
+    if (c->min_margin_ns > c->max_margin_ns) c->min_margin_ns = c->max_margin_ns;
+    if (c->initial_margin_ns <= 0) c->initial_margin_ns = RT_WAIT_DEFAULT_INITIAL_MARGIN;
+}
+
+static int64_t clamp_margin(const RtWaitConfig* c, int64_t margin) {
+    if (c->spin_budget < 0.0) return 0;
+    if (margin < c->min_margin_ns) return c->min_margin_ns;
+    if (margin > c->max_margin_ns) return c->max_margin_ns;
+    return margin;
+}
+
+int rt_waiter_init(RtWaiter* waiter, const RtWaitConfig* config) {
+    memset(waiter, 0, sizeof(*waiter));
+    if (config) waiter->config = *config;
+    apply_defaults(&waiter->config);
+    // Запоздания сна больше нескольких δ уже не влияют на выбор δ
+    waiter->overshoot = rt_hist_create(waiter->config.max_margin_ns * 4, RT_HIST_DEFAULT_PRECISION);
+    if (!waiter->overshoot) {
+        errno = ENOMEM;
+        return -1;
+    }
+    waiter->margin_ns = clamp_margin(&waiter->config, waiter->config.initial_margin_ns);
+    waiter->stats.margin_ns = waiter->margin_ns;
+    return 0;
+}
+
+void rt_waiter_destroy(RtWaiter* waiter) {
+    rt_hist_destroy(waiter->overshoot);
+    waiter->overshoot = NULL;
+}
+
+/*
+ * Пересчет δ в конце окна.
+ *
+ * Хвост: δ = перцентиль запоздания сна. Бюджет: опрос за ожидание
+ * s(δ) = E[max(δ - o, 0)], где o — запоздание сна; допустимо
+ * allowed = spin_budget * период. Оценка s(δ) — средний опрос окна.
+ * - δ <= allowed безопасна всегда: опрос не длиннее δ.
+ * - Рост δ на d увеличивает опрос не больше чем на d, поэтому при
+ *   s(δ) <= allowed допустима δ + (allowed - s(δ)).
+ * - s выпукла и s(0) = 0, поэтому уменьшение δ в k раз уменьшает опрос
+ *   не меньше чем в k раз: при s(δ) > allowed хватает δ * allowed / s(δ).
+ */
+static void adapt(RtWaiter* waiter) {
+    const RtWaitConfig* c = &waiter->config;
+    int64_t span = waiter->last_deadline_ns - waiter->window_first_ns;
+    if (rt_hist_count(waiter->overshoot) > 0 && span > 0) {
+        int64_t margin = rt_hist_percentile(waiter->overshoot, c->percentile);
+        double allowed = c->spin_budget * (double)span / (double)(waiter->window_waits - 1);
+        double spin = (double)waiter->window_spin_ns / (double)waiter->window_waits;
+        double limit = spin > allowed ? (double)waiter->margin_ns * allowed / spin
+                                      : (double)waiter->margin_ns + (allowed - spin);
+        if (limit < allowed) limit = allowed;
+        if ((double)margin > limit) margin = (int64_t)limit;
+        waiter->margin_ns = clamp_margin(c, margin);
+        waiter->stats.adjustments++;
+    }
+    waiter->stats.margin_ns = waiter->margin_ns;
+    rt_hist_reset(waiter->overshoot);
+    waiter->window_spin_ns = 0;
+    waiter->window_waits = 0;
+}
+
+int64_t rt_wait_until(RtWaiter* waiter, int64_t deadline_ns) {
+    clockid_t clock = waiter->config.clock;
+    int64_t wake_ns = deadline_ns - waiter->margin_ns;
+    int64_t now = clock_ns(clock);
+
+    if (now < wake_ns) {
+        struct timespec ts = {.tv_sec = wake_ns / NSEC_PER_SEC, .tv_nsec = wake_ns % NSEC_PER_SEC};
+        int rc;
+        while ((rc = clock_nanosleep(clock, TIMER_ABSTIME, &ts, NULL)) == EINTR) {
+        }
+        if (rc != 0) {
+            errno = rc;
+            return -1;
+        }
+        now = clock_ns(clock);
+        rt_hist_record(waiter->overshoot, now - wake_ns);
+        waiter->stats.sleeps++;
+        if (now >= deadline_ns) waiter->stats.late_sleeps++;
+    }
+
+    int64_t spin_start = now;
+    while (now < deadline_ns) {
+        CPU_RELAX();
+        now = clock_ns(clock);
+    }
+    waiter->stats.spin_ns += now - spin_start;
+    waiter->window_spin_ns += now - spin_start;
+    waiter->stats.waits++;
+
+    if (waiter->window_waits++ == 0) waiter->window_first_ns = deadline_ns;
+    waiter->last_deadline_ns = deadline_ns;
+    if (waiter->window_waits >= waiter->config.window) adapt(waiter);
+    return now;
+}
+
+void rt_waiter_stats(const RtWaiter* waiter, RtWaitStats* stats) {
+    *stats = waiter->stats;
+}
@@ -0,0 +1,97 @@
+#ifndef RT_WAIT_H
+#define RT_WAIT_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include "rt_hist.h"
+
+/*
+ * Точное ожидание абсолютного момента: сон до T - δ, затем опрос часов
+ * до T.
+ *
+ * Абсолютный clock_nanosleep просыпается позже цели на время выхода из
+ * таймера и планирования — десятки микросекунд, с длинным хвостом. Здесь
+ * поток засыпает с запасом δ, а остаток дожидается в цикле опроса
+ * clock_gettime (vDSO, без системных вызовов): джиттер пробуждения
+ * становится джиттером чтения часов, пока запоздание сна меньше δ.
+ *
+ * δ подбирается на ходу. Для каждого сна записывается его запоздание
+ * относительно T - δ; раз в window ожиданий δ становится перцентилем
+ * percentile этих запозданий (т.е. доля ожиданий, где сна не хватило,
+ * около 100 - percentile процентов), но не больше, чем позволяет бюджет
+ * CPU: опрос не должен занимать больше spin_budget от времени окна.
+ * Предел считается по опросу прошлого окна, так что он соблюдается,
+ * пока распределение запоздания сна не меняется; если сон резко стал
+ * точнее, одно окно может выйти за бюджет. δ всегда в [min_margin_ns,
+ * max_margin_ns].
+ *
+ * Память выделяется в rt_waiter_init(); rt_wait_until() не выделяет
+ * память и делает один системный вызов (сон). Ожидатель принадлежит
+ * одному потоку.
+ */
+
+#define RT_WAIT_DEFAULT_PERCENTILE 99.0
+#define RT_WAIT_DEFAULT_BUDGET 0.1
+#define RT_WAIT_DEFAULT_WINDOW 200
+#define RT_WAIT_DEFAULT_MAX_MARGIN (1000 * 1000LL)  /**< 1 мс */
+#define RT_WAIT_DEFAULT_INITIAL_MARGIN (50 * 1000LL) /**< 50 мкс */
+
+/** Параметры ожидателя; нули заменяются значениями по умолчанию */
+typedef struct {
+    clockid_t clock;           /**< часы сна и опроса (0 — CLOCK_MONOTONIC, CLOCK_REALTIME не выбрать) */
+    double percentile;         /**< какой хвост запоздания сна покрывает δ */
+    double spin_budget;        /**< доля CPU на опрос, 0..1 (< 0 — без опроса) */
+    int window;                /**< ожиданий между пересчетами δ */
+    int64_t initial_margin_ns; /**< δ до первого пересчета */
+    int64_t min_margin_ns;     /**< нижняя граница δ */
+    int64_t max_margin_ns;     /**< верхняя граница δ */
+} RtWaitConfig;
+
+/** Накопленная статистика */
+typedef struct {
+    uint64_t waits;          /**< вызовов rt_wait_until */
+    uint64_t sleeps;         /**< из них со сном */
+    uint64_t late_sleeps;    /**< сон закончился после T: δ не хватило */
+    uint64_t adjustments;    /**< пересчетов δ */
+    int64_t margin_ns;       /**< текущая δ */
+    int64_t spin_ns;         /**< суммарное время опроса */
+} RtWaitStats;
+
+typedef struct {
+    RtWaitConfig config;
+    RtHist* overshoot;       /**< запоздания сна в текущем окне */
+    int64_t margin_ns;
+    int64_t window_spin_ns;  /**< опрос в текущем окне */
+    int64_t window_first_ns; /**< первый дедлайн окна */
+    int64_t last_deadline_ns;
+    int window_waits;
+    RtWaitStats stats;
+} RtWaiter;
+
+/**
+ * @brief Создает ожидатель.
+ *
+ * @param config Параметры (NULL — по умолчанию).
+ * @return 0 при успехе, -1 при нехватке памяти.
+ */
+int rt_waiter_init(RtWaiter* waiter, const RtWaitConfig* config);
+
+/**
+ * @brief Освобождает память ожидателя.
+ */
+void rt_waiter_destroy(RtWaiter* waiter);
+
+/**
+ * @brief Ждет момента deadline_ns по часам ожидателя.
+ *
+ * @return Время пробуждения (нс) или -1 при ошибке сна (errno установлен).
+ */
+int64_t rt_wait_until(RtWaiter* waiter, int64_t deadline_ns);
+
+/**
+ * @brief Копирует накопленную статистику.
+ */
+void rt_waiter_stats(const RtWaiter* waiter, RtWaitStats* stats);
+
+#endif // RT_WAIT_H
@@ -0,0 +1,45 @@
+#!/bin/sh
+set -eu
+
+ROOT_DIR=$(CDPATH= cd -- "$(dirname -- "$0")/.." && pwd)
+BIN_DIR="$ROOT_DIR/bin"
+
+printf "[tests] building...\n"
+make -C "$ROOT_DIR" all >/dev/null
+
+fail() { printf "[tests] FAIL: %s\n" "$1"; exit 1; }
+pass() { printf "[tests] PASS: %s\n" "$1"; }
+
+# rt_mem: zero minor faults after rt_mem_prepare()
+"$BIN_DIR/test_rt_mem" || fail "rt_mem"
+pass "rt_mem"
+
+# rt_prefault: parallel and lazy prefault leave no faults behind
+"$BIN_DIR/test_rt_prefault" || fail "rt_prefault"
+pass "rt_prefault"
+
+# rt_hist: percentiles, merge and serialization
+"$BIN_DIR/test_rt_hist" || fail "rt_hist"
+pass "rt_hist"
+
+# rt_clock: TSC calibration and overhead correction
+"$BIN_DIR/test_rt_clock" || fail "rt_clock"
+pass "rt_clock"
+
+# rt_spsc: ordered lossless single-producer/single-consumer channel
+"$BIN_DIR/test_rt_spsc" || fail "rt_spsc"
+pass "rt_spsc"
+
+# rt_flight: ring freezes on a spike and keeps the cycles before it
+"$BIN_DIR/test_rt_flight" || fail "rt_flight"
+pass "rt_flight"
+
+# rt_log: mmap'd sample log round trip without page faults in the writer
+"$BIN_DIR/test_rt_log" || fail "rt_log"
+pass "rt_log"
+
+# rt_wait: hybrid sleep-then-spin never wakes early and stays within budget
+"$BIN_DIR/test_rt_wait" || fail "rt_wait"
+pass "rt_wait"
+
+printf "[tests] all tests passed\n"
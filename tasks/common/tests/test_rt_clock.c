@@ -0,0 +1,90 @@
+/*
+ * rt_clock: откалиброванный источник согласуется с CLOCK_MONOTONIC, а
+ * оценка накладных расходов согласуется с пустыми замерами: не больше
+ * самого дешевого из них и не меньше половины типичного.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "rt_clock.h"
+
+#define SLEEP_NS 20000000LL
+#define EMPTY_SAMPLES 100000
+
+#define MIN_SLACK_TICKS 2
+
+static int64_t empty_ticks[EMPTY_SAMPLES];
+
+static int compare_i64(const void* a, const void* b) {
+    int64_t va = *(const int64_t*)a;
+    int64_t vb = *(const int64_t*)b;
+    return (va > vb) - (va < vb);
+}
+
+static int check_clock(const RtClock* clock) {
+    rt_clock_print(clock);
+
+    // Интервал со сном: расхождение с CLOCK_MONOTONIC меньше 1%
+    uint64_t mono_start = rt_clock_monotonic_ns();
+    uint64_t start = rt_clock_start(clock);
+    struct timespec pause = {.tv_sec = 0, .tv_nsec = SLEEP_NS};
+    nanosleep(&pause, NULL);
+    uint64_t end = rt_clock_end(clock);
+    uint64_t mono_end = rt_clock_monotonic_ns();
+    double measured = (double)rt_clock_raw_ns(clock, start, end);
+    double reference = (double)(mono_end - mono_start);
+    printf("  sleep: clock %.0f ns, CLOCK_MONOTONIC %.0f ns\n", measured, reference);
+    if (measured > reference * 1.01 || measured < reference * 0.99 - 1000) {
+        printf("FAIL: calibrated clock disagrees with CLOCK_MONOTONIC\n");
+        return 1;
+    }
+
+    // Оценка накладных расходов против пустых замеров этого прогона, в тиках:
+    // - оценка — минимум калибровки, поэтому минимум 100000 пустых пар не
+    //   может быть заметно меньше нее (иначе вычет съедает реальную работу);
+    // - медиана пустой пары не больше двух оценок: вычет убирает хотя бы
+    //   половину типичной стоимости замера
+    for (int i = 0; i < EMPTY_SAMPLES; ++i) {
+        uint64_t s = rt_clock_start(clock);
+        uint64_t e = rt_clock_end(clock);
+        empty_ticks[i] = (int64_t)(e - s);
+    }
+    qsort(empty_ticks, EMPTY_SAMPLES, sizeof(int64_t), compare_i64);
+    int64_t overhead = (int64_t)clock->overhead_ticks;
+    int64_t min_ticks = empty_ticks[0];
+    int64_t median_ticks = empty_ticks[EMPTY_SAMPLES / 2];
+    int64_t slack = overhead / 8 > MIN_SLACK_TICKS ? overhead / 8 : MIN_SLACK_TICKS;
+    printf("  empty measurement: overhead %lld, min %lld, median %lld ticks (corrected median %lld)\n",
+           (long long)overhead, (long long)min_ticks, (long long)median_ticks, (long long)(median_ticks - overhead));
+    if (overhead <= 0) {
+        printf("FAIL: start/end overhead is not measured\n");
+        return 1;
+    }
+    if (min_ticks < overhead - slack) {
+        printf("FAIL: overhead estimate exceeds the cheapest empty measurement\n");
+        return 1;
+    }
+    if (rt_clock_corrected_ns(clock, 0, (uint64_t)overhead) != 0) {
+        printf("FAIL: corrected time of an empty measurement is not 0\n");
+        return 1;
+    }
+    if (median_ticks - overhead > overhead) {
+        printf("FAIL: overhead estimate removes less than half of a typical empty measurement\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    RtClock clock;
+    rt_clock_init(&clock, 0);
+    int failed = check_clock(&clock);
+
+    rt_clock_init(&clock, RT_CLOCK_FORCE_MONOTONIC);
+    if (clock.use_tsc) {
+        printf("FAIL: RT_CLOCK_FORCE_MONOTONIC ignored\n");
+        return 1;
+    }
+    failed |= check_clock(&clock);
+    return failed;
+}
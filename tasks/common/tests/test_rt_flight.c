@@ -0,0 +1,95 @@
+/*
+ * rt_flight: кольцо замораживается на выбросе и хранит последние N
+ * циклов, page fault попадает в счетчик своего цикла, после rearm
+ * запись продолжается.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "rt_flight.h"
+
+#define CAPACITY 16
+#define THRESHOLD_NS 100000
+#define FAULT_CYCLE 95
+#define SPIKE_CYCLE 100
+
+static int count_lines(const char* path, int* marked, int* faulted) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    char line[256];
+    int lines = 0;
+    *marked = 0;
+    *faulted = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') continue;
+        ++lines;
+        unsigned long long cycle;
+        long long time_ns, latency;
+        int cpu;
+        unsigned nivcsw, minflt, majflt;
+        if (sscanf(line + 1, "%llu %lld %lld %d %u %u %u", &cycle, &time_ns, &latency, &cpu, &nivcsw, &minflt,
+                   &majflt) != 7)
+            return -1;
+        if (line[0] == '*') *marked = (int)cycle;
+        if (minflt > 0 && cycle == FAULT_CYCLE) *faulted = 1;
+    }
+    fclose(f);
+    return lines;
+}
+
+int main(void) {
+    RtFlightConfig config = {.capacity = CAPACITY, .threshold_ns = THRESHOLD_NS, .name = "test"};
+    RtFlight* flight = rt_flight_create(&config);
+    if (!flight) {
+        printf("FAIL: rt_flight_create\n");
+        return 1;
+    }
+
+    long page = sysconf(_SC_PAGESIZE);
+    char* fresh = mmap(NULL, (size_t)page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (fresh == MAP_FAILED) return 1;
+
+    int failed = 0;
+    for (uint64_t cycle = 0; cycle < 200; ++cycle) {
+        if (cycle == FAULT_CYCLE) fresh[0] = 1; // ровно один minor fault в этом цикле
+        int64_t latency = cycle == SPIKE_CYCLE ? 5 * THRESHOLD_NS : 1000;
+        int froze = rt_flight_record(flight, cycle, (int64_t)cycle * 1000000, latency);
+        failed |= froze != (cycle == SPIKE_CYCLE);
+    }
+    RtFlightRecord trigger;
+    if (!rt_flight_frozen(flight) || rt_flight_trigger(flight, &trigger) != 0 || trigger.cycle != SPIKE_CYCLE ||
+        rt_flight_events(flight) != 1) {
+        printf("FAIL: ring is not frozen on the spike\n");
+        failed = 1;
+    }
+
+    char path[] = "/tmp/test_rt_flight_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return 1;
+    close(fd);
+    int marked, faulted;
+    if (rt_flight_dump(flight, path) != 0) {
+        printf("FAIL: rt_flight_dump\n");
+        failed = 1;
+    } else {
+        int lines = count_lines(path, &marked, &faulted);
+        printf("dump: %d cycles, spike at %d, fault seen %d\n", lines, marked, faulted);
+        // Окно — CAPACITY циклов, последний из них — выброс
+        failed |= lines != CAPACITY || marked != SPIKE_CYCLE || !faulted;
+    }
+
+    rt_flight_rearm(flight);
+    failed |= rt_flight_frozen(flight);
+    failed |= rt_flight_record(flight, 300, 0, 2 * THRESHOLD_NS) != 1;
+    failed |= rt_flight_dump(flight, path) != 0 || count_lines(path, &marked, &faulted) != 1;
+    failed |= rt_flight_events(flight) != 2;
+
+    unlink(path);
+    munmap(fresh, (size_t)page);
+    rt_flight_destroy(flight);
+    if (failed) printf("FAIL: rt_flight\n");
+    return failed;
+}
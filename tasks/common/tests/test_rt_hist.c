@@ -0,0 +1,100 @@
+/*
+ * rt_hist: перцентили в пределах заявленной точности, слияние
+ * гистограмм из нескольких потоков, сериализация туда и обратно.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "rt_hist.h"
+
+#define MAX_VALUE 10000000000LL // 10 с в наносекундах
+#define PRECISION 10
+#define VALUES 1000000
+#define THREADS 4
+#define PER_THREAD 250000
+
+static RtHist* shared;
+
+static int check_close(const char* what, int64_t got, double expected) {
+    double tolerance = expected / (1 << PRECISION) + 1;
+    if (fabs((double)got - expected) > tolerance) {
+        printf("FAIL: %s = %lld, expected %.0f +- %.0f\n", what, (long long)got, expected, tolerance);
+        return 1;
+    }
+    return 0;
+}
+
+static void* writer(void* arg) {
+    RtHist* local = (RtHist*)arg;
+    for (int i = 1; i <= PER_THREAD; ++i) {
+        rt_hist_record(local, i);
+        rt_hist_record(shared, i);
+    }
+    return NULL;
+}
+
+int main(void) {
+    RtHist* hist = rt_hist_create(MAX_VALUE, PRECISION);
+    if (!hist) {
+        printf("FAIL: rt_hist_create\n");
+        return 1;
+    }
+    // Равномерное распределение 1..VALUES: p-й перцентиль равен p% от VALUES
+    for (int i = 1; i <= VALUES; ++i) rt_hist_record(hist, i);
+    rt_hist_record(hist, 2 * MAX_VALUE); // за пределами диапазона: max остается точным
+    int failed = 0;
+    failed |= check_close("p50", rt_hist_percentile(hist, 50.0), VALUES * 0.5);
+    failed |= check_close("p99", rt_hist_percentile(hist, 99.0), VALUES * 0.99);
+    failed |= check_close("p99.9", rt_hist_percentile(hist, 99.9), VALUES * 0.999);
+    failed |= rt_hist_min(hist) != 1 || rt_hist_max(hist) != 2 * MAX_VALUE;
+    failed |= rt_hist_count(hist) != VALUES + 1;
+    rt_hist_print(hist, "uniform 1..1e6 + one overflow:", "ns");
+
+    // Сериализация: восстановленная гистограмма дает те же ответы
+    size_t capacity = rt_hist_serialized_max(hist);
+    unsigned char* buffer = malloc(capacity);
+    size_t size = rt_hist_serialize(hist, buffer, capacity);
+    RtHist* copy = size ? rt_hist_deserialize(buffer, size) : NULL;
+    if (!copy) {
+        printf("FAIL: serialize/deserialize\n");
+        return 1;
+    }
+    printf("serialized %zu bytes (max %zu)\n", size, capacity);
+    for (double p = 0.0; p <= 100.0; p += 0.5) {
+        failed |= rt_hist_percentile(copy, p) != rt_hist_percentile(hist, p);
+    }
+    failed |= rt_hist_count(copy) != rt_hist_count(hist) || rt_hist_max(copy) != rt_hist_max(hist);
+    failed |= rt_hist_deserialize(buffer, size - 1) != NULL;
+    free(buffer);
+
+    // Несколько писателей: общая гистограмма и слияние локальных совпадают
+    shared = rt_hist_create(MAX_VALUE, PRECISION);
+    RtHist* merged = rt_hist_create(MAX_VALUE, PRECISION);
+    RtHist* locals[THREADS];
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; ++t) {
+        locals[t] = rt_hist_create(MAX_VALUE, PRECISION);
+        pthread_create(&threads[t], NULL, writer, locals[t]);
+    }
+    for (int t = 0; t < THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+        failed |= rt_hist_merge(merged, locals[t]) != 0;
+        rt_hist_destroy(locals[t]);
+    }
+    failed |= rt_hist_count(merged) != THREADS * PER_THREAD || rt_hist_count(shared) != THREADS * PER_THREAD;
+    for (double p = 0.0; p <= 100.0; p += 0.5) {
+        failed |= rt_hist_percentile(merged, p) != rt_hist_percentile(shared, p);
+    }
+    RtHist* other = rt_hist_create(MAX_VALUE, PRECISION - 1);
+    failed |= rt_hist_merge(merged, other) != -1;
+
+    rt_hist_destroy(other);
+    rt_hist_destroy(merged);
+    rt_hist_destroy(shared);
+    rt_hist_destroy(copy);
+    rt_hist_destroy(hist);
+    if (failed) printf("FAIL: rt_hist\n");
+    return failed;
+}
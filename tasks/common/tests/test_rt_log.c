@@ -0,0 +1,76 @@
+/*
+ * rt_log: записи доходят до читателя вместе с заголовком, переполнение
+ * считается, запись в журнал не дает page faults.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "rt_log.h"
+
+#define CAPACITY 100000
+#define EXTRA 10
+
+static long minor_faults(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+int main(void) {
+    char path[] = "/tmp/test_rt_log_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return 1;
+    close(fd);
+
+    static const char* const fields[] = {"cycle", "latency_ns", "delta"};
+    static const char* const units[] = {"", "ns", ""};
+    RtLogConfig config = {.title = "test", .policy = "SCHED_OTHER 0", .fields = fields, .units = units,
+                          .field_count = 3, .capacity = CAPACITY};
+    RtLog log;
+    if (rt_log_create(&log, path, &config) != 0) {
+        perror("FAIL: rt_log_create");
+        return 1;
+    }
+
+    int failed = 0;
+    long faults_before = minor_faults();
+    for (int64_t i = 0; i < CAPACITY + EXTRA; ++i) {
+        int64_t values[3] = {i, 1000 + i % 97, -i};
+        failed |= rt_log_append(&log, values) != (i < CAPACITY ? 0 : -1);
+    }
+    long faults = minor_faults() - faults_before;
+    printf("%d records written, %ld minor faults\n", CAPACITY, faults);
+    failed |= faults != 0;
+    failed |= rt_log_close(&log) != 0;
+
+    RtLog reader;
+    if (rt_log_open(&reader, path) != 0) {
+        printf("FAIL: rt_log_open\n");
+        unlink(path);
+        return 1;
+    }
+    failed |= reader.count != CAPACITY || reader.header->dropped != EXTRA;
+    failed |= strcmp(reader.header->title, "test") != 0 || strcmp(reader.header->units[1], "ns") != 0;
+    failed |= reader.header->end_realtime_ns < reader.header->start_realtime_ns;
+    int latency = rt_log_field(&reader, "latency_ns");
+    failed |= latency != 1 || rt_log_field(&reader, "missing") != -1;
+    for (uint64_t i = 0; i < reader.count && !failed; ++i) {
+        failed |= rt_log_value(&reader, i, 0) != (int64_t)i;
+        failed |= rt_log_value(&reader, i, latency) != 1000 + (int64_t)(i % 97);
+        failed |= rt_log_value(&reader, i, 2) != -(int64_t)i;
+    }
+    rt_log_close(&reader);
+
+    // Не журнал
+    FILE* f = fopen(path, "w");
+    fputs("not a log", f);
+    fclose(f);
+    failed |= rt_log_open(&reader, path) != -1;
+
+    unlink(path);
+    if (failed) printf("FAIL: rt_log\n");
+    return failed;
+}
@@ -0,0 +1,86 @@
+/*
+ * После rt_mem_prepare() рабочая нагрузка в пределах резервов кучи
+ * и стека не должна давать ни одного minor fault.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include "rt_mem.h"
+
+#define HEAP_RESERVE (32 * 1024 * 1024)
+#define STACK_RESERVE (256 * 1024)
+#define LIVE_BLOCKS 64
+#define MAX_BLOCK (128 * 1024) // больше порога mmap по умолчанию
+#define ROUNDS 2000
+
+static void* blocks[LIVE_BLOCKS];
+
+static long thread_minor_faults(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_minflt;
+}
+
+// Использует заметную часть прогретого стека
+__attribute__((noinline)) static unsigned stack_work(void) {
+    volatile unsigned char buffer[STACK_RESERVE / 2];
+    for (size_t i = 0; i < sizeof(buffer); i += 512) buffer[i] = (unsigned char)i;
+    return buffer[sizeof(buffer) - 512];
+}
+
+static long heap_and_stack_workload(void) {
+    unsigned rng = 12345;
+    long before = thread_minor_faults();
+    for (int round = 0; round < ROUNDS; ++round) {
+        rng = rng * 1103515245u + 12345u;
+        int slot = (int)((rng >> 8) % LIVE_BLOCKS);
+        free(blocks[slot]);
+        size_t size = 1 + (rng >> 4) % MAX_BLOCK;
+        blocks[slot] = malloc(size);
+        if (blocks[slot]) memset(blocks[slot], round, size);
+    }
+    stack_work();
+    return thread_minor_faults() - before;
+}
+
+static void* rt_thread(void* arg) {
+    long* faults = (long*)arg;
+    rt_mem_prefault_stack(STACK_RESERVE);
+    long before = thread_minor_faults();
+    stack_work();
+    *faults = thread_minor_faults() - before;
+    return NULL;
+}
+
+int main(void) {
+    RtMemConfig config = {.heap_reserve = HEAP_RESERVE, .stack_reserve = STACK_RESERVE};
+    RtMemReport report;
+    if (rt_mem_prepare(&config, &report) != 0) {
+        printf("SKIP: mlockall failed (needs root or CAP_IPC_LOCK)\n");
+        return 0;
+    }
+
+    long main_faults = heap_and_stack_workload();
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 2 * STACK_RESERVE);
+    pthread_t thread;
+    long thread_faults = -1;
+    if (pthread_create(&thread, &attr, rt_thread, &thread_faults) != 0) {
+        printf("FAIL: pthread_create\n");
+        return 1;
+    }
+    pthread_join(thread, NULL);
+
+    rt_mem_print_report(&report);
+    printf("minor faults after prepare: main thread %ld, RT thread %ld\n", main_faults, thread_faults);
+    if (report.vm_locked == 0 || report.heap_prefaulted != HEAP_RESERVE) {
+        printf("FAIL: nothing locked or heap not prefaulted\n");
+        return 1;
+    }
+    return main_faults == 0 && thread_faults == 0 ? 0 : 1;
+}
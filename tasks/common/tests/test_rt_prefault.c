@@ -0,0 +1,111 @@
+/*
+ * Регион, прогретый rt_prefault() (блокирующим или ленивым), не дает
+ * minor faults при проходе по всем страницам; прогресс доходит до конца.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "rt_prefault.h"
+
+#define REGION_SIZE (64 * 1024 * 1024)
+#define PAGE 4096
+#define RT_THREADS 3
+
+static size_t last_progress;
+
+static long thread_minor_faults(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_minflt;
+}
+
+static long touch_all(char* region) {
+    long before = thread_minor_faults();
+    for (size_t offset = 0; offset < REGION_SIZE; offset += PAGE) ((volatile char*)region)[offset] = 1;
+    return thread_minor_faults() - before;
+}
+
+static void on_progress(size_t done, size_t total, void* ctx) {
+    (void)ctx;
+    (void)total;
+    last_progress = done;
+}
+
+typedef struct {
+    RtPrefaultJob* job;
+    char* region;
+    long faults;
+    int status;
+} RtThreadArg;
+
+static void* rt_thread(void* arg) {
+    RtThreadArg* a = (RtThreadArg*)arg;
+    a->status = rt_prefault_wait(a->job);
+    a->faults = touch_all(a->region);
+    return NULL;
+}
+
+static char* map_region(void) {
+    void* region = mmap(NULL, REGION_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return region == MAP_FAILED ? NULL : (char*)region;
+}
+
+int main(void) {
+    char* region = map_region();
+    if (!region) {
+        printf("FAIL: mmap\n");
+        return 1;
+    }
+    RtPrefaultConfig config = {.threads = 2, .numa_node = -1, .progress = on_progress};
+    RtPrefaultStats stats;
+    if (rt_prefault(region, REGION_SIZE, &config, &stats) != 0) {
+        printf("FAIL: rt_prefault\n");
+        return 1;
+    }
+    long eager_faults = touch_all(region);
+    printf("eager: %d threads, %zu MB in %.1f ms (%s), faults after %ld\n", stats.threads,
+           stats.bytes >> 20, stats.elapsed_ns / 1e6,
+           stats.used_populate ? "MADV_POPULATE_WRITE" : "touch", eager_faults);
+    if (eager_faults != 0 || stats.bytes != REGION_SIZE || last_progress != REGION_SIZE) {
+        printf("FAIL: eager prefault incomplete\n");
+        return 1;
+    }
+    munmap(region, REGION_SIZE);
+
+    // Ленивый режим: RT-потоки ждут барьера готовности
+    region = map_region();
+    if (!region) {
+        printf("FAIL: mmap\n");
+        return 1;
+    }
+    config.lock = 1;
+    RtPrefaultJob* job = rt_prefault_start(region, REGION_SIZE, &config);
+    if (!job) {
+        printf("SKIP: rt_prefault_start with lock failed (needs root or CAP_IPC_LOCK)\n");
+        return 0;
+    }
+    pthread_t threads[RT_THREADS];
+    RtThreadArg args[RT_THREADS];
+    for (int i = 0; i < RT_THREADS; ++i) {
+        args[i] = (RtThreadArg){.job = job, .region = region, .faults = -1, .status = -1};
+        pthread_create(&threads[i], NULL, rt_thread, &args[i]);
+    }
+    int failed = 0;
+    for (int i = 0; i < RT_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+        failed |= args[i].status != 0 || args[i].faults != 0;
+    }
+    int ready = rt_prefault_ready(job);
+    size_t done = rt_prefault_done_bytes(job);
+    rt_prefault_finish(job, &stats);
+    printf("lazy: %zu MB ready in %.1f ms, RT thread faults %ld/%ld/%ld\n", done >> 20,
+           stats.elapsed_ns / 1e6, args[0].faults, args[1].faults, args[2].faults);
+    munmap(region, REGION_SIZE);
+    if (failed || !ready || done != REGION_SIZE) {
+        printf("FAIL: lazy prefault\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * rt_spsc: все записи доходят до читателя по порядку и без потерь,
+ * полный и пустой канал корректно отказывают.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "rt_spsc.h"
+
+#define RECORDS 2000000
+
+typedef struct {
+    uint64_t sequence;
+    uint64_t check;
+} Record;
+
+static void* producer(void* arg) {
+    RtSpsc* channel = (RtSpsc*)arg;
+    for (uint64_t i = 0; i < RECORDS; ++i) {
+        Record r = {.sequence = i, .check = ~i};
+        while (rt_spsc_push(channel, &r) != 0) sched_yield();
+    }
+    return NULL;
+}
+
+int main(void) {
+    RtSpsc* channel = rt_spsc_create(5, sizeof(Record));
+    if (!channel || rt_spsc_capacity(channel) != 8) {
+        printf("FAIL: rt_spsc_create\n");
+        return 1;
+    }
+    Record r = {0};
+    int failed = rt_spsc_pop(channel, &r) != -1;
+    for (int i = 0; i < 8; ++i) failed |= rt_spsc_push(channel, &r) != 0;
+    failed |= rt_spsc_push(channel, &r) != -1 || rt_spsc_size(channel) != 8;
+    for (int i = 0; i < 8; ++i) failed |= rt_spsc_pop(channel, &r) != 0;
+    rt_spsc_destroy(channel);
+
+    channel = rt_spsc_create(64, sizeof(Record));
+    pthread_t thread;
+    pthread_create(&thread, NULL, producer, channel);
+    uint64_t expected = 0;
+    while (expected < RECORDS) {
+        if (rt_spsc_pop(channel, &r) != 0) {
+            sched_yield();
+            continue;
+        }
+        if (r.sequence != expected || r.check != ~expected) {
+            printf("FAIL: got record %llu, expected %llu\n", (unsigned long long)r.sequence,
+                   (unsigned long long)expected);
+            failed = 1;
+            break;
+        }
+        ++expected;
+    }
+    pthread_join(thread, NULL);
+    rt_spsc_destroy(channel);
+    printf("%llu records passed in order\n", (unsigned long long)expected);
+    return failed;
+}
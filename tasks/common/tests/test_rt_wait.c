@@ -0,0 +1,95 @@
+/*
+ * rt_wait: ожидание не возвращается раньше дедлайна, δ пересчитывается
+ * и не выходит за границы, опрос не больше двух бюджетов, отрицательный
+ * бюджет превращает ожидание в обычный сон.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "rt_wait.h"
+
+#define PERIOD_NS 1000000LL
+#define WAITS 600
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Прогон WAITS периодов; возвращает число ранних пробуждений
+static int run(RtWaiter* waiter, int64_t* elapsed) {
+    int early = 0;
+    int64_t start = now_ns();
+    int64_t deadline = start + PERIOD_NS;
+    for (int i = 0; i < WAITS; ++i, deadline += PERIOD_NS) {
+        int64_t woke = rt_wait_until(waiter, deadline);
+        if (woke < 0) return -1;
+        early += woke < deadline;
+    }
+    *elapsed = now_ns() - start;
+    return early;
+}
+
+int main(void) {
+    int failed = 0;
+    RtWaiter waiter;
+    RtWaitStats stats;
+    int64_t elapsed;
+
+    RtWaitConfig config = {.window = 100, .spin_budget = 0.2, .max_margin_ns = 300000};
+    if (rt_waiter_init(&waiter, &config) != 0) {
+        printf("FAIL: rt_waiter_init\n");
+        return 1;
+    }
+    int early = run(&waiter, &elapsed);
+    rt_waiter_stats(&waiter, &stats);
+    printf("adaptive: margin %lld ns, %llu adjustments, %llu/%llu late sleeps, spin %.2f%%\n",
+           (long long)stats.margin_ns, (unsigned long long)stats.adjustments, (unsigned long long)stats.late_sleeps,
+           (unsigned long long)stats.sleeps, 100.0 * (double)stats.spin_ns / (double)elapsed);
+    if (early != 0) {
+        printf("FAIL: %d waits returned before the deadline\n", early);
+        failed = 1;
+    }
+    if ((double)stats.spin_ns > 2 * config.spin_budget * (double)elapsed) {
+        printf("FAIL: spin exceeds twice the budget\n");
+        failed = 1;
+    }
+    if (stats.waits != WAITS || stats.adjustments != WAITS / 100) {
+        printf("FAIL: %llu waits, %llu adjustments\n", (unsigned long long)stats.waits,
+               (unsigned long long)stats.adjustments);
+        failed = 1;
+    }
+    if (stats.margin_ns < 0 || stats.margin_ns > config.max_margin_ns) {
+        printf("FAIL: margin out of bounds\n");
+        failed = 1;
+    }
+    rt_waiter_destroy(&waiter);
+
+    // Бюджет 0.5%: опрос не больше двух бюджетов
+    config = (RtWaitConfig){.window = 100, .spin_budget = 0.005, .initial_margin_ns = 1000};
+    if (rt_waiter_init(&waiter, &config) != 0) return 1;
+    early = run(&waiter, &elapsed);
+    rt_waiter_stats(&waiter, &stats);
+    double spin = (double)stats.spin_ns / (double)elapsed;
+    printf("budget 0.5%%: margin %lld ns, spin %.2f%%\n", (long long)stats.margin_ns, 100.0 * spin);
+    if (early != 0 || spin > 2 * config.spin_budget) {
+        printf("FAIL: spin budget is not respected\n");
+        failed = 1;
+    }
+    rt_waiter_destroy(&waiter);
+
+    // Отрицательный бюджет: δ = 0, каждый сон просыпается после дедлайна
+    config = (RtWaitConfig){.spin_budget = -1.0};
+    if (rt_waiter_init(&waiter, &config) != 0) return 1;
+    early = run(&waiter, &elapsed);
+    rt_waiter_stats(&waiter, &stats);
+    if (early != 0 || stats.margin_ns != 0 || stats.sleeps == 0 || stats.late_sleeps != stats.sleeps) {
+        printf("FAIL: plain sleep mode (margin %lld, %llu sleeps, %llu late)\n", (long long)stats.margin_ns,
+               (unsigned long long)stats.sleeps, (unsigned long long)stats.late_sleeps);
+        failed = 1;
+    }
+    rt_waiter_destroy(&waiter);
+
+    return failed;
+}
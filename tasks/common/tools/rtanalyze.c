@@ -0,0 +1,359 @@
+/*
+ * rtanalyze — разбор журналов замеров rt_log.
+ *
+ *   rtanalyze info FILE...               заголовки: хост, ядро, CPU, политика
+ *   rtanalyze stats [-f FIELD] FILE...   min/avg/max/stddev и перцентили
+ *   rtanalyze hist [-f FIELD] FILE       гистограмма по степеням двойки
+ *   rtanalyze series [-f FIELD] [-w N] FILE
+ *                                        ряд по окнам из N записей
+ *   rtanalyze compare [-f FIELD] BASE FILE...
+ *                                        перцентили прогонов против BASE
+ *   rtanalyze csv FILE                   все записи в CSV
+ *
+ * Поле по умолчанию — latency_ns, если оно есть, иначе первое; для stats
+ * без -f выводятся все поля.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rt_hist.h"
+#include "rt_log.h"
+
+#define DEFAULT_FIELD "latency_ns"
+#define DEFAULT_WINDOWS 50
+#define BAR_WIDTH 50
+
+static const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99, 100.0};
+#define PERCENTILE_COUNT (sizeof(percentiles) / sizeof(percentiles[0]))
+
+typedef struct {
+    uint64_t count;
+    int64_t min;
+    int64_t max;
+    double mean;
+    double stddev;
+    int64_t values[PERCENTILE_COUNT];
+} FieldStats;
+
+static const char* percentile_label(size_t p) {
+    static char label[16];
+    if (percentiles[p] >= 100.0) return "max";
+    snprintf(label, sizeof(label), "p%g", percentiles[p]);
+    return label;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "Usage: rtanalyze COMMAND [options] FILE...\n"
+            "  info FILE...                  run description from the headers\n"
+            "  stats [-f FIELD] FILE...      min/avg/max/stddev and percentiles\n"
+            "  hist [-f FIELD] FILE          power-of-two histogram\n"
+            "  series [-f FIELD] [-w N] FILE statistics per window of N records\n"
+            "  compare [-f FIELD] BASE FILE... percentiles against BASE\n"
+            "  csv FILE                      all records as CSV\n");
+}
+
+static int open_log(RtLog* log, const char* path) {
+    if (rt_log_open(log, path) != 0) {
+        fprintf(stderr, "%s: not an rt_log file or cannot be read\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static int pick_field(const RtLog* log, const char* path, const char* name) {
+    if (!name) {
+        int field = rt_log_field(log, DEFAULT_FIELD);
+        return field >= 0 ? field : 0;
+    }
+    int field = rt_log_field(log, name);
+    if (field < 0) fprintf(stderr, "%s: no field %s\n", path, name);
+    return field;
+}
+
+// Перцентили — через rt_hist с точностью 0.1%; min/max/среднее — точные
+static void field_stats(const RtLog* log, int field, uint64_t first, uint64_t last, FieldStats* s) {
+    memset(s, 0, sizeof(*s));
+    s->count = last - first;
+    if (s->count == 0) return;
+    s->min = INT64_MAX;
+    s->max = INT64_MIN;
+    double sum = 0.0;
+    for (uint64_t i = first; i < last; ++i) {
+        int64_t v = rt_log_value(log, i, field);
+        if (v < s->min) s->min = v;
+        if (v > s->max) s->max = v;
+        sum += (double)v;
+    }
+    s->mean = sum / (double)s->count;
+    double sum_sq = 0.0;
+    for (uint64_t i = first; i < last; ++i) {
+        double d = (double)rt_log_value(log, i, field) - s->mean;
+        sum_sq += d * d;
+    }
+    s->stddev = sqrt(sum_sq / (double)s->count);
+
+    // Значения сдвигаются к нулю от минимума: относительная точность
+    // гистограммы тогда делит разброс данных, а не их величину (у time_ns
+    // и cycle 0.1% от значения больше всего разброса), и отрицательные
+    // разности счетчиков тоже помещаются
+    int64_t offset = s->min;
+    RtHist* hist = rt_hist_create(s->max - offset > 0 ? s->max - offset : 1, 10);
+    if (!hist) return;
+    for (uint64_t i = first; i < last; ++i) rt_hist_record(hist, rt_log_value(log, i, field) - offset);
+    for (size_t p = 0; p < PERCENTILE_COUNT; ++p) s->values[p] = rt_hist_percentile(hist, percentiles[p]) + offset;
+    rt_hist_destroy(hist);
+}
+
+static void format_realtime(int64_t ns, char* buf, size_t size) {
+    if (ns == 0) {
+        snprintf(buf, size, "-");
+        return;
+    }
+    time_t seconds = (time_t)(ns / 1000000000LL);
+    struct tm tm;
+    localtime_r(&seconds, &tm);
+    strftime(buf, size, "%Y-%m-%d %H:%M:%S", &tm);
+}
+
+static int cmd_info(int count, char** paths) {
+    int failed = 0;
+    for (int i = 0; i < count; ++i) {
+        RtLog log;
+        if (open_log(&log, paths[i]) != 0) {
+            failed = 1;
+            continue;
+        }
+        const RtLogHeader* h = log.header;
+        char start[32], end[32];
+        format_realtime(h->start_realtime_ns, start, sizeof(start));
+        format_realtime(h->end_realtime_ns, end, sizeof(end));
+        printf("%s\n", paths[i]);
+        printf("  title:    %s\n", h->title);
+        printf("  host:     %s, %d CPUs\n", h->host, h->cpu_count);
+        printf("  kernel:   %s\n", h->kernel);
+        printf("  cpu:      %s\n", h->cpu_model);
+        printf("  policy:   %s\n", h->policy);
+        printf("  clock:    %s\n", h->clock);
+        printf("  run:      %s .. %s, pid %d%s\n", start, end, h->pid,
+               h->end_realtime_ns ? "" : " (not closed)");
+        printf("  records:  %" PRIu64 " of %" PRIu64 ", dropped %" PRIu64 "\n", log.count, h->capacity,
+               h->dropped);
+        printf("  fields:  ");
+        for (uint32_t f = 0; f < log.field_count; ++f) {
+            printf(" %s%s%s%s", h->fields[f], h->units[f][0] ? " [" : "", h->units[f], h->units[f][0] ? "]" : "");
+        }
+        printf("\n");
+        rt_log_close(&log);
+    }
+    return failed;
+}
+
+static void print_stats_header(void) {
+    printf("%-24s %10s %10s %12s %10s %10s", "field", "count", "min", "avg", "max", "stddev");
+    for (size_t p = 0; p + 1 < PERCENTILE_COUNT; ++p) printf(" %10s", percentile_label(p));
+    printf("\n");
+}
+
+static void print_stats_row(const char* name, const FieldStats* s) {
+    printf("%-24s %10" PRIu64 " %10" PRId64 " %12.1f %10" PRId64 " %10.1f", name, s->count, s->min, s->mean, s->max,
+           s->stddev);
+    for (size_t p = 0; p + 1 < PERCENTILE_COUNT; ++p) printf(" %10" PRId64, s->values[p]);
+    printf("\n");
+}
+
+static int cmd_stats(int count, char** paths, const char* field_name) {
+    int failed = 0;
+    for (int i = 0; i < count; ++i) {
+        RtLog log;
+        if (open_log(&log, paths[i]) != 0) {
+            failed = 1;
+            continue;
+        }
+        printf("%s: %s, %" PRIu64 " records\n", paths[i], log.header->title, log.count);
+        print_stats_header();
+        for (uint32_t f = 0; f < log.field_count; ++f) {
+            if (field_name && strcmp(field_name, log.header->fields[f]) != 0) continue;
+            FieldStats s;
+            field_stats(&log, (int)f, 0, log.count, &s);
+            print_stats_row(log.header->fields[f], &s);
+        }
+        if (field_name && rt_log_field(&log, field_name) < 0) {
+            fprintf(stderr, "%s: no field %s\n", paths[i], field_name);
+            failed = 1;
+        }
+        rt_log_close(&log);
+    }
+    return failed;
+}
+
+static int cmd_hist(const char* path, const char* field_name) {
+    RtLog log;
+    if (open_log(&log, path) != 0) return 1;
+    int field = pick_field(&log, path, field_name);
+    if (field < 0) {
+        rt_log_close(&log);
+        return 1;
+    }
+
+    // Строка k: значения в (2^(k-1), 2^k], строка 0 — значения <= 1
+    uint64_t rows[65] = {0};
+    int last_row = 0;
+    for (uint64_t i = 0; i < log.count; ++i) {
+        int64_t v = rt_log_value(&log, i, field);
+        int row = v <= 1 ? 0 : 64 - __builtin_clzll((uint64_t)(v - 1));
+        ++rows[row];
+        if (row > last_row) last_row = row;
+    }
+    uint64_t peak = 1;
+    for (int r = 0; r <= last_row; ++r) {
+        if (rows[r] > peak) peak = rows[r];
+    }
+
+    printf("%s: %s [%s], %" PRIu64 " records\n", path, log.header->fields[field], log.header->units[field],
+           log.count);
+    printf("%20s %12s %8s\n", "<= value", "count", "%");
+    for (int r = 0; r <= last_row; ++r) {
+        char bar[BAR_WIDTH + 1];
+        int width = (int)(rows[r] * BAR_WIDTH / peak);
+        if (rows[r] && width == 0) width = 1;
+        memset(bar, '#', (size_t)width);
+        bar[width] = '\0';
+        printf("%20" PRIu64 " %12" PRIu64 " %8.3f %s\n", r == 64 ? UINT64_MAX : (uint64_t)1 << r, rows[r],
+               log.count ? 100.0 * (double)rows[r] / (double)log.count : 0.0, bar);
+    }
+    rt_log_close(&log);
+    return 0;
+}
+
+static int cmd_series(const char* path, const char* field_name, uint64_t window) {
+    RtLog log;
+    if (open_log(&log, path) != 0) return 1;
+    int field = pick_field(&log, path, field_name);
+    if (field < 0) {
+        rt_log_close(&log);
+        return 1;
+    }
+    if (window == 0) window = log.count / DEFAULT_WINDOWS > 0 ? log.count / DEFAULT_WINDOWS : 1;
+    // Если в журнале есть время, окно подписывается секундами от начала
+    int time_field = rt_log_field(&log, "time_ns");
+
+    printf("%s: %s per %" PRIu64 " records\n", path, log.header->fields[field], window);
+    printf("%12s %10s %10s %12s %10s %10s %10s\n", "first", time_field >= 0 ? "time_s" : "", "min", "avg",
+           "p99", "p99.99", "max");
+    for (uint64_t first = 0; first < log.count; first += window) {
+        uint64_t last = first + window < log.count ? first + window : log.count;
+        FieldStats s;
+        field_stats(&log, field, first, last, &s);
+        char when[24] = "";
+        if (time_field >= 0) {
+            double seconds = (double)(rt_log_value(&log, first, time_field) - rt_log_value(&log, 0, time_field)) / 1e9;
+            snprintf(when, sizeof(when), "%.3f", seconds);
+        }
+        printf("%12" PRIu64 " %10s %10" PRId64 " %12.1f %10" PRId64 " %10" PRId64 " %10" PRId64 "\n", first, when,
+               s.min, s.mean, s.values[2], s.values[4], s.max);
+    }
+    rt_log_close(&log);
+    return 0;
+}
+
+static int cmd_compare(int count, char** paths, const char* field_name) {
+    if (count < 2) {
+        usage();
+        return 1;
+    }
+    FieldStats base;
+    int failed = 0;
+    printf("%-32s %10s %12s", "run", "count", "avg");
+    for (size_t p = 0; p < PERCENTILE_COUNT; ++p) printf(" %11s", percentile_label(p));
+    printf("\n");
+    for (int i = 0; i < count; ++i) {
+        RtLog log;
+        if (open_log(&log, paths[i]) != 0) {
+            if (i == 0) return 1;
+            failed = 1;
+            continue;
+        }
+        int field = pick_field(&log, paths[i], field_name);
+        if (field < 0) {
+            rt_log_close(&log);
+            if (i == 0) return 1;
+            failed = 1;
+            continue;
+        }
+        FieldStats s;
+        field_stats(&log, field, 0, log.count, &s);
+        if (i == 0) base = s;
+        printf("%-32s %10" PRIu64 " %12.1f", paths[i], s.count, s.mean);
+        for (size_t p = 0; p < PERCENTILE_COUNT; ++p) printf(" %11" PRId64, s.values[p]);
+        printf("\n");
+        if (i > 0) {
+            // Изменение относительно первого прогона, в процентах
+            printf("%-32s %10s %11.1f%%", "", "", base.mean ? 100.0 * (s.mean - base.mean) / base.mean : 0.0);
+            for (size_t p = 0; p < PERCENTILE_COUNT; ++p) {
+                double change = base.values[p] ? 100.0 * (double)(s.values[p] - base.values[p]) /
+                                                     (double)base.values[p] : 0.0;
+                printf(" %10.1f%%", change);
+            }
+            printf("\n");
+        }
+        rt_log_close(&log);
+    }
+    return failed;
+}
+
+static int cmd_csv(const char* path) {
+    RtLog log;
+    if (open_log(&log, path) != 0) return 1;
+    for (uint32_t f = 0; f < log.field_count; ++f) printf("%s%s", f ? "," : "", log.header->fields[f]);
+    printf("\n");
+    for (uint64_t i = 0; i < log.count; ++i) {
+        for (uint32_t f = 0; f < log.field_count; ++f) {
+            printf("%s%" PRId64, f ? "," : "", rt_log_value(&log, i, (int)f));
+        }
+        printf("\n");
+    }
+    rt_log_close(&log);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+    const char* command = argv[1];
+    const char* field = NULL;
+    uint64_t window = 0;
+
+    // Опции идут после команды
+    optind = 2;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:w:")) != -1) {
+        switch (opt) {
+        case 'f': field = optarg; break;
+        case 'w': window = strtoull(optarg, NULL, 10); break;
+        default: usage(); return 1;
+        }
+    }
+    int count = argc - optind;
+    char** paths = argv + optind;
+    if (count < 1) {
+        usage();
+        return 1;
+    }
+
+    if (strcmp(command, "info") == 0) return cmd_info(count, paths);
+    if (strcmp(command, "stats") == 0) return cmd_stats(count, paths, field);
+    if (strcmp(command, "hist") == 0) return cmd_hist(paths[0], field);
+    if (strcmp(command, "series") == 0) return cmd_series(paths[0], field, window);
+    if (strcmp(command, "compare") == 0) return cmd_compare(count, paths, field);
+    if (strcmp(command, "csv") == 0) return cmd_csv(paths[0]);
+    usage();
+    return 1;
+}
@@ -12,15 +12,18 @@
 #include <errno.h>
 #include <stdint.h>
 #include <inttypes.h>
-#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "rt_hist.h"
+
 #define BILLION 1000000000LL
 #define MILLION 1000000LL
 #define NUM_SAMPLES 5000 /* 5000 * 2 ms ≈ 10 секунд эксперимента */
+#define FIRST_SAMPLES 10
+#define HIST_MAX_NS BILLION /* интервалы длиннее 1 с попадают в последнюю корзину */
 
 // Вспомогательная функция: перевод timespec в наносекунды
 static inline int64_t timespec_to_ns(const struct timespec *ts) {
@@ -38,7 +41,7 @@ int main(void) {
     struct timespec res_rt = {0}, res_mono = {0};
     struct timespec t_next = {0}, now = {0};
     const int64_t period_ns = 2 * MILLION; /* Период 2 мс */
-    int64_t deltas_ns[NUM_SAMPLES];
+    int64_t first_ns[FIRST_SAMPLES]; /* первые интервалы для наглядности */
     int samples = 0;
 
     setvbuf(stdout, NULL, _IOLBF, 0);
@@ -56,6 +59,13 @@ int main(void) {
     printf("Resolution: REALTIME=%ld ns, MONOTONIC=%ld ns\n",
            (long)res_rt.tv_nsec, (long)res_mono.tv_nsec);
 
+    // Гистограмма постоянного размера вместо массива всех интервалов
+    RtHist *hist = rt_hist_create(HIST_MAX_NS, RT_HIST_DEFAULT_PRECISION);
+    if (!hist) {
+        fprintf(stderr, "rt_hist_create failed\n");
+        return EXIT_FAILURE;
+    }
+
     // Инициализируем время старта
     if (clock_gettime(CLOCK_MONOTONIC, &t_next) != 0) {
         fprintf(stderr, "clock_gettime failed: %s\n", strerror(errno));
@@ -106,36 +116,24 @@ int main(void) {
         
         // [MODIFIED] Считаем интервал между текущим и прошлым пробуждением
         // Идеал: должно быть ровно 2 000 000 нс.
-        deltas_ns[samples] = now_ns - prev_wakeup_ns; 
+        int64_t interval_ns = now_ns - prev_wakeup_ns;
+        rt_hist_record(hist, interval_ns);
+        if (samples < FIRST_SAMPLES) first_ns[samples] = interval_ns;
         
         prev_wakeup_ns = now_ns;
     }
 
     /* Статистика */
-    int64_t min_ns = INT64_MAX, max_ns = INT64_MIN, sum_ns = 0;
-    for (int i = 0; i < NUM_SAMPLES; ++i) {
-        if (deltas_ns[i] < min_ns) min_ns = deltas_ns[i];
-        if (deltas_ns[i] > max_ns) max_ns = deltas_ns[i];
-        sum_ns += deltas_ns[i];
-    }
-    double avg_ns = (double)sum_ns / (double)NUM_SAMPLES;
-
-    // [MODIFIED] Расчет стандартного отклонения (Standard Deviation)
-    // Показывает стабильность таймера (насколько велик разброс)
-    double sum_sq_diff = 0;
-    for (int i = 0; i < NUM_SAMPLES; ++i) {
-        sum_sq_diff += pow((double)deltas_ns[i] - avg_ns, 2);
-    }
-    double std_dev_ns = sqrt(sum_sq_diff / NUM_SAMPLES);
-
+    // std_dev показывает стабильность таймера (насколько велик разброс);
+    // гистограмма считает его по серединам корзин
     printf("Period stats over %d samples (target: %" PRId64 " ns):\n", NUM_SAMPLES, period_ns);
-    printf("  min=%" PRId64 " ns, avg=%.1f ns, max=%" PRId64 " ns, std_dev=%.1f ns\n",
-           min_ns, avg_ns, max_ns, std_dev_ns);
+    rt_hist_print(hist, NULL, "ns");
+    rt_hist_destroy(hist);
 
     /* Вывести первые несколько измерений для наглядности */
-    printf("\nFirst 10 intervals (ns):\n");
-    for (int i = 0; i < 10 && i < NUM_SAMPLES; ++i) {
-        printf("  sample %d: %" PRId64 "\n", i, deltas_ns[i]);
+    printf("\nFirst %d intervals (ns):\n", FIRST_SAMPLES);
+    for (int i = 0; i < FIRST_SAMPLES && i < NUM_SAMPLES; ++i) {
+        printf("  sample %d: %" PRId64 "\n", i, first_ns[i]);
     }
 
     return EXIT_SUCCESS;
@@ -0,0 +1,320 @@
+/*
+ * Precise wait: plain absolute clock_nanosleep against the hybrid
+ * sleep-then-spin waiter (common/src/rt_wait.h) over several periods.
+ *
+ * Absolute clock_nanosleep (calctime2.c) wakes up after the deadline by the
+ * timer exit and scheduling latency, tens of microseconds with a long tail.
+ * rt_wait_until() sleeps until T - margin and spins on clock_gettime until
+ * T; the margin follows a percentile of the observed sleep overshoot, capped
+ * by a CPU budget for spinning.
+ *
+ * For every period both waits run in a fresh pinned thread for the same
+ * number of cycles. The table shows:
+ * - lateness after the deadline (p50/p99/p99.9/max);
+ * - the final margin chosen by the waiter;
+ * - spin%: time spent spinning / wall time;
+ * - cpu%: user + system time of the thread / wall time (rusage);
+ * - late%: sleeps that ended after the deadline, i.e. the margin was too
+ *   small and the wait degenerated to a plain sleep.
+ *
+ * Examples:
+ *   precise_wait                              # 200 us .. 5 ms, SCHED_FIFO 80
+ *   precise_wait -a 3 -P 100,1000 -n 5000 -b 5
+ *   precise_wait -y other -q 99.9
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rt_hist.h"
+#include "rt_mem.h"
+#include "rt_wait.h"
+
+#ifndef __linux__
+int main(void) {
+    printf("precise_wait: Linux-only example\n");
+    return 0;
+}
+#else
+
+#include <sys/resource.h>
+
+#define HIST_MAX_NS (1000LL * 1000000LL) /* wakeups later than 1 s are clamped */
+#define WARMUP_CYCLES RT_WAIT_DEFAULT_WINDOW /* one margin adjustment before measuring */
+#define MAX_PERIODS 16
+#define THREAD_STACK_SIZE (256 * 1024)
+#define THREAD_STACK_PREFAULT (64 * 1024)
+
+typedef struct {
+    int64_t periods_ns[MAX_PERIODS];
+    int period_count;
+    long cycles;
+    int cpu;
+    int policy;
+    int priority;
+    double budget;     /* fraction of CPU time for spinning */
+    double percentile; /* sleep overshoot tail covered by the margin */
+} PreciseConfig;
+
+typedef struct {
+    const PreciseConfig *config;
+    int64_t period_ns;
+    int hybrid;
+    RtHist *hist;
+    RtWaitStats stats;
+    double spin_percent;
+    double cpu_percent;
+    int error;
+} PreciseRun;
+
+static inline int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int64_t thread_cpu_ns(const struct rusage *ru) {
+    return ((int64_t)ru->ru_utime.tv_sec + ru->ru_stime.tv_sec) * 1000000000LL +
+           ((int64_t)ru->ru_utime.tv_usec + ru->ru_stime.tv_usec) * 1000LL;
+}
+
+static int sleep_until(int64_t deadline_ns) {
+    struct timespec ts = {.tv_sec = (time_t)(deadline_ns / 1000000000LL), .tv_nsec = (long)(deadline_ns % 1000000000LL)};
+    int rc;
+    while ((rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) == EINTR) {
+    }
+    return rc;
+}
+
+static void *measure_thread(void *arg) {
+    PreciseRun *run = (PreciseRun *)arg;
+    const PreciseConfig *config = run->config;
+    rt_mem_prefault_stack(THREAD_STACK_PREFAULT);
+
+    RtWaiter waiter;
+    RtWaitConfig wait_config = {.percentile = config->percentile, .spin_budget = config->budget};
+    if (run->hybrid && rt_waiter_init(&waiter, &wait_config) != 0) {
+        run->error = errno;
+        return NULL;
+    }
+
+    struct rusage ru_start, ru_end;
+    int64_t start_ns = 0;
+    int64_t spin_start_ns = 0;
+    int64_t next_ns = now_ns() + run->period_ns;
+    // The waiter keeps adapting during the warm-up; only its spin after it counts.
+    for (long cycle = -WARMUP_CYCLES; cycle < config->cycles; ++cycle) {
+        if (cycle == 0) {
+            getrusage(RUSAGE_THREAD, &ru_start);
+            start_ns = now_ns();
+            if (run->hybrid) {
+                rt_waiter_stats(&waiter, &run->stats);
+                spin_start_ns = run->stats.spin_ns;
+            }
+        }
+        int64_t now;
+        if (run->hybrid) {
+            now = rt_wait_until(&waiter, next_ns);
+            if (now < 0) {
+                run->error = errno;
+                break;
+            }
+        } else {
+            if ((run->error = sleep_until(next_ns)) != 0) break;
+            now = now_ns();
+        }
+        if (cycle >= 0) rt_hist_record(run->hist, now - next_ns);
+        next_ns += run->period_ns;
+        while (next_ns <= now) next_ns += run->period_ns;
+    }
+    int64_t wall_ns = now_ns() - start_ns;
+    getrusage(RUSAGE_THREAD, &ru_end);
+
+    if (!run->error && wall_ns > 0) {
+        run->cpu_percent = 100.0 * (double)(thread_cpu_ns(&ru_end) - thread_cpu_ns(&ru_start)) / (double)wall_ns;
+        if (run->hybrid) {
+            RtWaitStats warmup = run->stats;
+            rt_waiter_stats(&waiter, &run->stats);
+            run->spin_percent = 100.0 * (double)(run->stats.spin_ns - spin_start_ns) / (double)wall_ns;
+            run->stats.sleeps -= warmup.sleeps;
+            run->stats.late_sleeps -= warmup.late_sleeps;
+        }
+    }
+    if (run->hybrid) rt_waiter_destroy(&waiter);
+    return NULL;
+}
+
+/* Runs one measurement in a new pinned thread; returns pthread_create's error. */
+static int run_measurement(PreciseRun *run) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+    if (run->config->cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(run->config->cpu, &cpu_set);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpu_set), &cpu_set);
+    }
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, run->config->policy);
+    struct sched_param sp = {.sched_priority = run->config->policy == SCHED_OTHER ? 0 : run->config->priority};
+    pthread_attr_setschedparam(&attr, &sp);
+
+    pthread_t thread;
+    int rc = pthread_create(&thread, &attr, measure_thread, run);
+    pthread_attr_destroy(&attr);
+    if (rc == 0) pthread_join(thread, NULL);
+    return rc;
+}
+
+static const char *policy_name(int policy) {
+    return policy == SCHED_FIFO ? "fifo" : policy == SCHED_RR ? "rr" : "other";
+}
+
+static void print_header(void) {
+    printf("%8s %-6s %8s %8s %8s %8s %8s %7s %7s %7s\n", "period", "wait", "p50", "p99", "p99.9", "max",
+           "margin", "spin%", "cpu%", "late%");
+    printf("%8s %-6s %8s %8s %8s %8s %8s\n", "us", "", "us", "us", "us", "us", "us");
+}
+
+static void print_row(const PreciseRun *run) {
+    const RtHist *h = run->hist;
+    printf("%8" PRId64 " %-6s %8.1f %8.1f %8.1f %8.1f", run->period_ns / 1000, run->hybrid ? "hybrid" : "sleep",
+           rt_hist_percentile(h, 50.0) / 1000.0, rt_hist_percentile(h, 99.0) / 1000.0,
+           rt_hist_percentile(h, 99.9) / 1000.0, rt_hist_max(h) / 1000.0);
+    if (!run->hybrid) {
+        printf(" %8s %7s %7.1f %7s\n", "-", "-", run->cpu_percent, "-");
+        return;
+    }
+    double late = run->stats.sleeps ? 100.0 * (double)run->stats.late_sleeps / (double)run->stats.sleeps : 0.0;
+    printf(" %8.1f %7.1f %7.1f %7.1f\n", run->stats.margin_ns / 1000.0, run->spin_percent, run->cpu_percent, late);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -a, --cpu CPU          pin the measuring thread (default: not pinned)\n"
+            "  -P, --periods LIST     periods in microseconds, comma-separated\n"
+            "                         (default: 200,500,1000,2000,5000)\n"
+            "  -n, --cycles N         measured cycles per run (default: 1000)\n"
+            "  -y, --policy POLICY    other, fifo or rr (default: fifo)\n"
+            "  -p, --priority PRIO    RT priority (default: 80)\n"
+            "  -b, --budget PCT       CPU budget for spinning, %% of time (default: 10)\n"
+            "  -q, --percentile P     sleep overshoot tail covered by the margin (default: 99)\n"
+            "  -h, --help             show this help\n",
+            prog);
+}
+
+static int parse_periods(char *list, PreciseConfig *config) {
+    config->period_count = 0;
+    for (char *item = strtok(list, ","); item; item = strtok(NULL, ",")) {
+        if (config->period_count == MAX_PERIODS) return -1;
+        int64_t period_ns = atoll(item) * 1000LL;
+        if (period_ns <= 0) return -1;
+        config->periods_ns[config->period_count++] = period_ns;
+    }
+    return config->period_count > 0 ? 0 : -1;
+}
+
+static int parse_options(int argc, char *argv[], PreciseConfig *config) {
+    static const struct option options[] = {
+        {"cpu", required_argument, NULL, 'a'},      {"periods", required_argument, NULL, 'P'},
+        {"cycles", required_argument, NULL, 'n'},   {"policy", required_argument, NULL, 'y'},
+        {"priority", required_argument, NULL, 'p'}, {"budget", required_argument, NULL, 'b'},
+        {"percentile", required_argument, NULL, 'q'}, {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    *config = (PreciseConfig){
+        .periods_ns = {200000LL, 500000LL, 1000000LL, 2000000LL, 5000000LL},
+        .period_count = 5,
+        .cycles = 1000,
+        .cpu = -1,
+        .policy = SCHED_FIFO,
+        .priority = 80,
+        .budget = 0.1,
+        .percentile = RT_WAIT_DEFAULT_PERCENTILE,
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "a:P:n:y:p:b:q:h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'a': config->cpu = atoi(optarg); break;
+        case 'P':
+            if (parse_periods(optarg, config) != 0) {
+                fprintf(stderr, "Invalid period list\n");
+                return -1;
+            }
+            break;
+        case 'n': config->cycles = atol(optarg); break;
+        case 'y':
+            if (strcmp(optarg, "fifo") == 0) config->policy = SCHED_FIFO;
+            else if (strcmp(optarg, "rr") == 0) config->policy = SCHED_RR;
+            else if (strcmp(optarg, "other") == 0) config->policy = SCHED_OTHER;
+            else return -1;
+            break;
+        case 'p': config->priority = atoi(optarg); break;
+        case 'b': config->budget = atof(optarg) / 100.0; break;
+        case 'q': config->percentile = atof(optarg); break;
+        default: return -1;
+        }
+    }
+    if (optind < argc || config->cycles <= 0 || config->budget <= 0.0 || config->budget > 1.0 ||
+        config->percentile <= 0.0 || config->percentile > 100.0 || config->cpu >= CPU_SETSIZE) {
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    PreciseConfig config;
+    if (parse_options(argc, argv, &config) != 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    RtMemConfig mem_config = {.heap_reserve = 1024 * 1024, .stack_reserve = 64 * 1024};
+    if (rt_mem_prepare(&mem_config, NULL) != 0) perror("WARNING: mlockall failed");
+
+    printf("%ld cycles per run, %s", config.cycles, policy_name(config.policy));
+    if (config.policy != SCHED_OTHER) printf(" %d", config.priority);
+    printf(", spin budget %.1f%%, margin covers p%g of the sleep overshoot, ", config.budget * 100.0,
+           config.percentile);
+    if (config.cpu >= 0) printf("pinned to CPU %d\n", config.cpu);
+    else printf("not pinned\n");
+    print_header();
+
+    RtHist *hist = rt_hist_create(HIST_MAX_NS, RT_HIST_DEFAULT_PRECISION);
+    if (!hist) {
+        fprintf(stderr, "rt_hist_create failed\n");
+        return EXIT_FAILURE;
+    }
+    int failed = 0;
+    for (int p = 0; p < config.period_count && !failed; ++p) {
+        for (int hybrid = 0; hybrid <= 1; ++hybrid) {
+            rt_hist_reset(hist);
+            PreciseRun run = {.config = &config, .period_ns = config.periods_ns[p], .hybrid = hybrid, .hist = hist};
+            int rc = run_measurement(&run);
+            if (rc != 0 || run.error) {
+                printf("%8" PRId64 " %-6s %s\n", run.period_ns / 1000, hybrid ? "hybrid" : "sleep",
+                       strerror(rc ? rc : run.error));
+                failed = 1;
+                break;
+            }
+            print_row(&run);
+        }
+    }
+    rt_hist_destroy(hist);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif
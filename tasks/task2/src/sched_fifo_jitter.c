@@ -1,24 +1,66 @@
 /*
- * Measure jitter of 2ms periodic wakeups under SCHED_FIFO
- * This version includes professional techniques for jitter reduction:
- * - SCHED_FIFO scheduler policy
- * - Pinning the thread to a specific CPU core (CPU affinity)
- * - Locking memory to prevent page faults (mlockall)
+ * Measure wakeup latency of periodic real-time threads (cyclictest-style).
+ *
+ * One measurement thread is started per selected CPU. Each thread sleeps
+ * until an absolute deadline with clock_nanosleep(TIMER_ABSTIME), reads the
+ * clock on wakeup and records how late it woke up. The techniques for
+ * jitter reduction are the same as in the single-thread version:
+ * - real-time scheduling policy (SCHED_FIFO by default)
+ * - pinning every thread to its CPU (CPU affinity)
+ * - locking and prefaulting memory to prevent page faults (rt_mem)
+ *
+ * The main thread stays SCHED_OTHER: it prints live per-CPU min/avg/max and,
+ * at the end, a per-CPU latency histogram built from rt_hist.
+ *
+ * Streaming mode (-S) is for runs of hours or days in fixed memory. Every
+ * thread fills an interval histogram and, at each interval boundary, hands
+ * it to a SCHED_OTHER reporter thread through a lock-free SPSC channel and
+ * takes an empty one back through a second channel. The RT loop never calls
+ * printf or malloc; if the reporter falls behind, the interval is extended
+ * instead of blocking.
+ *
+ * Flight recorder mode (-b) is for finding the cause of a spike. Every thread
+ * keeps a ring of its last cycles (wakeup time, latency, CPU, involuntary
+ * context switches, page faults). The first wakeup later than the threshold
+ * freezes the ring and writes a marker to tracefs trace_marker, so the spike
+ * can be found in an ftrace recording (--trace-stop also stops tracing). The
+ * main thread dumps the window to a file and rearms the recorder.
+ *
+ * With --log every thread also writes each cycle (cycle, wakeup time,
+ * latency) into its own memory-mapped rt_log file for offline analysis with
+ * common/bin/rtanalyze; the RT loop only stores into mapped memory.
+ *
+ * Examples:
+ *   sched_fifo_jitter                         # all CPUs, FIFO 80, 1 ms, 10 s
+ *   sched_fifo_jitter -a 2-3 -p 95 -i 200 -D 1h -q
+ *   sched_fifo_jitter -i 1000 -d 500          # periods 1000, 1500, 2000 us...
+ *   sched_fifo_jitter -a 3 -S 60 -D 24h       # per-minute snapshots for a day
+ *   sched_fifo_jitter -a 3 -b 200 --trace-stop  # freeze ftrace on a 200 us spike
+ *   sched_fifo_jitter -a 2-3 -D 1m --log /dev/shm/run1  # run1_T0.rtlog, run1_T1.rtlog
  */
 
+#ifndef _GNU_SOURCE
 #define _GNU_SOURCE
+#endif
 #define _POSIX_C_SOURCE 200809L
 #include <errno.h>
+#include <getopt.h>
 #include <inttypes.h>
 #include <pthread.h>
 #include <sched.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/mman.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "rt_flight.h"
+#include "rt_hist.h"
+#include "rt_log.h"
+#include "rt_mem.h"
+#include "rt_spsc.h"
+
 #ifndef __linux__
 int main(void) {
     printf("sched_fifo_jitter: Linux-only example (SCHED_FIFO not available)\n");
@@ -26,13 +68,96 @@ int main(void) {
 }
 #else
 
-static int compare_i64(const void *a, const void *b) {
-    int64_t va = *(const int64_t *)a;
-    int64_t vb = *(const int64_t *)b;
-    if (va < vb) return -1;
-    if (va > vb) return 1;
-    return 0;
-}
+#define MAX_THREADS CPU_SETSIZE
+#define HIST_MAX_NS (1000LL * 1000000LL) /* wakeups later than 1 s are clamped */
+#define THREAD_STACK_SIZE (256 * 1024)
+#define THREAD_STACK_PREFAULT (64 * 1024)
+/* Interval histograms per thread in streaming mode: one being filled, the
+ * rest queued for or returned from the reporter. */
+#define STREAM_HISTS 4
+#define STREAM_CHANNEL_SIZE (2 * STREAM_HISTS) /* never full: more slots than histograms */
+#define REPORTER_POLL_NS (50 * 1000000L)
+#define FLIGHT_DEFAULT_SIZE 1000
+#define FLIGHT_DEFAULT_MAX_DUMPS 10
+#define LOG_DEFAULT_RECORDS (4L * 1024 * 1024) /* per thread when the run is unbounded */
+#define LOG_FIELDS 3
+
+/* Long-only options */
+enum { OPT_FLIGHT_SIZE = 256, OPT_FLIGHT_DIR, OPT_FLIGHT_MAX, OPT_TRACE_STOP, OPT_LOG, OPT_LOG_SIZE };
+
+typedef struct {
+    int policy;
+    int priority;
+    int64_t interval_ns;
+    int64_t distance_ns;
+    int64_t duration_ns; /* 0 = until loops or a signal */
+    long loops;          /* 0 = unlimited */
+    clockid_t clock;
+    int64_t refresh_ns;
+    int64_t stream_ns;   /* snapshot interval, 0 = no streaming */
+    int64_t realtime_offset_ns; /* CLOCK_REALTIME - measurement clock, for timestamps */
+    int quiet;
+    int64_t breaktrace_ns; /* flight recorder threshold, 0 = off */
+    long flight_size;      /* cycles per recorder ring */
+    long flight_max;       /* dumps per thread before the recorder stays frozen */
+    const char *flight_dir;
+    int trace_stop;        /* stop ftrace on a spike */
+    RtTrace trace;
+    const char *log_prefix; /* sample logs, NULL = off */
+    long log_size;          /* records per thread, 0 = from duration or loops */
+    int cpus[MAX_THREADS];
+    int cpu_count;
+} JitterConfig;
+
+/* One interval snapshot handed from a measurement thread to the reporter. */
+typedef struct {
+    RtHist *hist;
+    int64_t start_ns; /* measurement clock */
+    int64_t end_ns;
+    uint64_t overruns;
+    int final;
+} StreamSnapshot;
+
+/*
+ * Per-thread state. The live statistics are written only by the measurement
+ * thread and read by the main thread with relaxed atomics, so printing never
+ * blocks the RT loop.
+ */
+typedef struct {
+    int id;
+    int cpu;
+    int64_t period_ns;
+    RtHist *hist;
+    const JitterConfig *config;
+
+    uint64_t cycles;
+    uint64_t overruns; /* wakeups later than a whole period */
+    int64_t last;
+    int64_t min;
+    int64_t max;
+    int64_t sum;
+    int64_t worst_at_ns; /* measurement clock time of the worst wakeup */
+    int finished;
+    int error;
+
+    /* Streaming mode */
+    RtHist *interval;                 /* being filled by the RT loop */
+    RtHist *stream_hists[STREAM_HISTS];
+    RtSpsc *snapshots;                /* RT thread -> reporter */
+    RtSpsc *spares;                   /* reporter -> RT thread, reset histograms */
+
+    /* Flight recorder mode */
+    RtFlight *flight;
+    long flight_dumps;
+
+    /* Sample log */
+    RtLog log;
+    int logging;
+
+    pthread_t thread;
+} JitterThread;
+
+static int stop_requested;
 
 static inline int64_t ts_to_ns(const struct timespec *ts) {
     return (int64_t)ts->tv_sec * 1000000000LL + (int64_t)ts->tv_nsec;
@@ -42,90 +167,725 @@ static inline void ns_to_ts(int64_t ns, struct timespec *ts) {
     ts->tv_nsec = (long)(ns % 1000000000LL);
 }
 
-int main(void) {
-    setvbuf(stdout, NULL, _IOLBF, 0);
+static void on_signal(int sig) {
+    (void)sig;
+    __atomic_store_n(&stop_requested, 1, __ATOMIC_RELAXED);
+}
+
+static int should_stop(void) {
+    return __atomic_load_n(&stop_requested, __ATOMIC_RELAXED);
+}
 
-    // --- 1. Set SCHED_FIFO policy ---
-    // This is the most crucial step. It moves the thread to a real-time scheduler
-    // that preempts all non-RT threads (SCHED_OTHER/NORMAL).
-    // Requires root or CAP_SYS_NICE capability.
-    struct sched_param sp = {.sched_priority = 50};
-    if (sched_setscheduler(0, SCHED_FIFO, &sp) != 0) {
-        perror("WARNING: sched_setscheduler failed; continuing with default scheduler");
-    } else {
-        printf("Switched to SCHED_FIFO priority %d\n", sp.sched_priority);
+/*
+ * Hands the current interval to the reporter and continues with a spare
+ * histogram. Returns 0 if no spare is available yet: the caller keeps
+ * filling the same interval. The final snapshot needs no spare.
+ */
+static int stream_publish(JitterThread *t, int64_t start_ns, int64_t end_ns, uint64_t overruns,
+                          int final) {
+    RtHist *spare = NULL;
+    if (!final && rt_spsc_pop(t->spares, &spare) != 0) return 0;
+    StreamSnapshot snapshot = {
+        .hist = t->interval, .start_ns = start_ns, .end_ns = end_ns, .overruns = overruns, .final = final};
+    rt_spsc_push(t->snapshots, &snapshot);
+    t->interval = spare;
+    return 1;
+}
+
+static void *measure_thread(void *arg) {
+    JitterThread *t = (JitterThread *)arg;
+    const JitterConfig *config = t->config;
+
+    // The stack used by the loop is prefaulted before the first deadline.
+    rt_mem_prefault_stack(THREAD_STACK_PREFAULT);
+
+    struct timespec now, next;
+    clock_gettime(config->clock, &now);
+    int64_t next_ns = ts_to_ns(&now) + t->period_ns;
+    int64_t min = INT64_MAX, max = 0, sum = 0;
+    int64_t interval_start_ns = ts_to_ns(&now);
+    int64_t interval_end_ns = interval_start_ns + config->stream_ns;
+    uint64_t interval_overruns = 0;
+
+    for (uint64_t cycle = 0; config->loops == 0 || cycle < (uint64_t)config->loops; ++cycle) {
+        if (should_stop()) break;
+        ns_to_ts(next_ns, &next);
+        int rc;
+        // Absolute wait is crucial to prevent period drift.
+        do {
+            rc = clock_nanosleep(config->clock, TIMER_ABSTIME, &next, NULL);
+        } while (rc == EINTR && !should_stop());
+        if (rc == EINTR) break;
+        if (rc != 0) {
+            __atomic_store_n(&t->error, rc, __ATOMIC_RELAXED);
+            break;
+        }
+
+        clock_gettime(config->clock, &now);
+        int64_t now_ns = ts_to_ns(&now);
+        // The "error" or "jitter" for this cycle: how late we woke up.
+        int64_t latency = now_ns - next_ns;
+        rt_hist_record(t->hist, latency);
+        if (t->flight) rt_flight_record(t->flight, cycle, now_ns, latency);
+        if (t->logging) {
+            int64_t sample[LOG_FIELDS] = {(int64_t)cycle, now_ns, latency};
+            rt_log_append(&t->log, sample);
+        }
+
+        if (latency < min) min = latency;
+        if (latency > max) {
+            max = latency;
+            t->worst_at_ns = now_ns;
+        }
+        sum += latency;
+        __atomic_store_n(&t->last, latency, __ATOMIC_RELAXED);
+        __atomic_store_n(&t->min, min, __ATOMIC_RELAXED);
+        __atomic_store_n(&t->max, max, __ATOMIC_RELAXED);
+        __atomic_store_n(&t->sum, sum, __ATOMIC_RELAXED);
+        __atomic_store_n(&t->cycles, cycle + 1, __ATOMIC_RELEASE);
+
+        next_ns += t->period_ns;
+        // Woke up after the next deadline: skip the missed periods instead of
+        // firing them back to back.
+        while (next_ns <= now_ns) {
+            next_ns += t->period_ns;
+            __atomic_store_n(&t->overruns, t->overruns + 1, __ATOMIC_RELAXED);
+            ++interval_overruns;
+        }
+
+        if (t->interval) {
+            rt_hist_record(t->interval, latency);
+            if (now_ns >= interval_end_ns) {
+                if (stream_publish(t, interval_start_ns, now_ns, interval_overruns, 0)) {
+                    interval_start_ns = now_ns;
+                    interval_overruns = 0;
+                }
+                while (interval_end_ns <= now_ns) interval_end_ns += config->stream_ns;
+            }
+        }
     }
 
-    // --- 2. Lock memory pages ---
-    // mlockall prevents the process's memory from being paged to swap.
+    if (t->interval) {
+        clock_gettime(config->clock, &now);
+        stream_publish(t, interval_start_ns, ts_to_ns(&now), interval_overruns, 1);
+    }
+    __atomic_store_n(&t->finished, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* "2026-01-31 12:34:56.789" for a measurement clock timestamp. */
+static void format_time(const JitterConfig *config, int64_t clock_ns, char *buf, size_t size) {
+    int64_t wall_ns = clock_ns + config->realtime_offset_ns;
+    time_t seconds = (time_t)(wall_ns / 1000000000LL);
+    struct tm tm;
+    localtime_r(&seconds, &tm);
+    size_t n = strftime(buf, size, "%Y-%m-%d %H:%M:%S", &tm);
+    snprintf(buf + n, size - n, ".%03d", (int)(wall_ns % 1000000000LL / 1000000));
+}
+
+static void print_snapshot(const JitterThread *t, const StreamSnapshot *snapshot) {
+    char when[48];
+    format_time(t->config, snapshot->end_ns, when, sizeof(when));
+    const RtHist *h = snapshot->hist;
+    printf("[%s] T:%d CPU:%d %5.1fs C:%8" PRIu64 " Min:%6" PRId64 " Avg:%6.0f P50:%6" PRId64
+           " P99:%6" PRId64 " P99.9:%6" PRId64 " P99.99:%6" PRId64 " Max:%7" PRId64 " us, overruns %" PRIu64
+           "%s\n",
+           when, t->id, t->cpu, (double)(snapshot->end_ns - snapshot->start_ns) / 1e9, rt_hist_count(h),
+           rt_hist_min(h) / 1000, rt_hist_mean(h) / 1000.0, rt_hist_percentile(h, 50.0) / 1000,
+           rt_hist_percentile(h, 99.0) / 1000, rt_hist_percentile(h, 99.9) / 1000,
+           rt_hist_percentile(h, 99.99) / 1000, rt_hist_max(h) / 1000, snapshot->overruns,
+           snapshot->final ? " (final)" : "");
+}
+
+typedef struct {
+    JitterThread *threads;
+    int count;
+} Reporter;
+
+/* Non-RT side of the streaming channels: prints and recycles snapshots. */
+static void *reporter_thread(void *arg) {
+    Reporter *r = (Reporter *)arg;
+    int open = r->count;
+    int closed[MAX_THREADS] = {0};
+    while (open > 0) {
+        int received = 0;
+        for (int i = 0; i < r->count; ++i) {
+            JitterThread *t = &r->threads[i];
+            StreamSnapshot snapshot;
+            while (!closed[i] && rt_spsc_pop(t->snapshots, &snapshot) == 0) {
+                received = 1;
+                print_snapshot(t, &snapshot);
+                if (snapshot.final) {
+                    closed[i] = 1;
+                    --open;
+                    break;
+                }
+                rt_hist_reset(snapshot.hist);
+                rt_spsc_push(t->spares, &snapshot.hist);
+            }
+        }
+        if (!received) {
+            struct timespec pause = {.tv_sec = 0, .tv_nsec = REPORTER_POLL_NS};
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+/* Interval histograms and channels are allocated before the RT threads start. */
+static int stream_init(JitterThread *t) {
+    t->snapshots = rt_spsc_create(STREAM_CHANNEL_SIZE, sizeof(StreamSnapshot));
+    t->spares = rt_spsc_create(STREAM_CHANNEL_SIZE, sizeof(RtHist *));
+    if (!t->snapshots || !t->spares) return -1;
+    for (int i = 0; i < STREAM_HISTS; ++i) {
+        t->stream_hists[i] = rt_hist_create(HIST_MAX_NS, RT_HIST_DEFAULT_PRECISION);
+        if (!t->stream_hists[i]) return -1;
+        if (i > 0) rt_spsc_push(t->spares, &t->stream_hists[i]);
+    }
+    t->interval = t->stream_hists[0];
+    return 0;
+}
+
+static void stream_destroy(JitterThread *t) {
+    for (int i = 0; i < STREAM_HISTS; ++i) rt_hist_destroy(t->stream_hists[i]);
+    rt_spsc_destroy(t->snapshots);
+    rt_spsc_destroy(t->spares);
+}
+
+/*
+ * Dumps frozen flight recorder windows and rearms the recorders. Runs in the
+ * non-RT main thread. Returns the number of lines printed.
+ */
+static int flight_collect(JitterThread *threads, int count, const JitterConfig *config) {
+    int lines = 0;
+    for (int i = 0; i < count; ++i) {
+        JitterThread *t = &threads[i];
+        if (!t->flight || t->flight_dumps >= config->flight_max || !rt_flight_frozen(t->flight)) continue;
+        RtFlightRecord spike;
+        rt_flight_trigger(t->flight, &spike);
+        char path[512], when[48];
+        snprintf(path, sizeof(path), "%s/flight_T%d_%ld.txt", config->flight_dir, t->id, t->flight_dumps);
+        format_time(config, spike.time_ns, when, sizeof(when));
+        if (rt_flight_dump(t->flight, path) == 0) {
+            printf("T:%d CPU %d: %" PRId64 " us spike at %s, cycle %" PRIu64 " -> %s\n", t->id, t->cpu,
+                   spike.latency_ns / 1000, when, spike.cycle, path);
+        } else {
+            fprintf(stderr, "T:%d: cannot write %s: %s\n", t->id, path, strerror(errno));
+        }
+        ++lines;
+        // After the last allowed dump the ring stays frozen: recording stops.
+        if (++t->flight_dumps < config->flight_max) rt_flight_rearm(t->flight);
+    }
+    return lines;
+}
+
+static void print_live(const JitterThread *threads, int count) {
+    for (int i = 0; i < count; ++i) {
+        const JitterThread *t = &threads[i];
+        uint64_t cycles = __atomic_load_n(&t->cycles, __ATOMIC_ACQUIRE);
+        int64_t sum = __atomic_load_n(&t->sum, __ATOMIC_RELAXED);
+        printf("T:%3d CPU:%3d I:%7" PRId64 " C:%10" PRIu64 " Min:%8" PRId64 " Act:%8" PRId64
+               " Avg:%8" PRId64 " Max:%8" PRId64 " us\n",
+               t->id, t->cpu, t->period_ns / 1000, cycles,
+               cycles ? __atomic_load_n(&t->min, __ATOMIC_RELAXED) / 1000 : 0,
+               __atomic_load_n(&t->last, __ATOMIC_RELAXED) / 1000,
+               cycles ? sum / (int64_t)cycles / 1000 : 0,
+               __atomic_load_n(&t->max, __ATOMIC_RELAXED) / 1000);
+    }
+}
+
+/* Histogram with power-of-two microsecond bounds: one column per CPU. */
+static void print_histogram(const JitterThread *threads, int count, const RtHist *total) {
+    int64_t max_ns = rt_hist_max(total);
+    printf("\nLatency histogram (samples with previous bound < latency <= bound):\n");
+    printf("%10s", "<= us");
+    for (int i = 0; i < count; ++i) {
+        char name[16];
+        snprintf(name, sizeof(name), "CPU%d", threads[i].cpu);
+        printf("  %10s", name);
+    }
+    printf("  %10s\n", "total");
+
+    uint64_t previous[MAX_THREADS + 1] = {0};
+    for (int64_t bound_us = 1;; bound_us *= 2) {
+        printf("%10" PRId64, bound_us);
+        for (int i = 0; i <= count; ++i) {
+            const RtHist *hist = i < count ? threads[i].hist : total;
+            uint64_t cumulative = rt_hist_count_at_or_below(hist, bound_us * 1000);
+            printf("  %10" PRIu64, cumulative - previous[i]);
+            previous[i] = cumulative;
+        }
+        printf("\n");
+        if (bound_us * 1000 >= max_ns) break;
+    }
+}
+
+static int parse_cpu_list(const char *list, JitterConfig *config) {
+    config->cpu_count = 0;
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0) return -1;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first) return -1;
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            if (cpu >= CPU_SETSIZE || config->cpu_count == MAX_THREADS) return -1;
+            config->cpus[config->cpu_count++] = (int)cpu;
+        }
+        if (*p == '\0') break;
+        if (*p != ',') return -1;
+        ++p;
+    }
+    return config->cpu_count > 0 ? 0 : -1;
+}
+
+/* "500ms", "10s", "5m", "2h", "1d"; a plain number means seconds. */
+static int parse_duration(const char *text, int64_t *ns) {
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text || value < 0) return -1;
+    double scale = 1e9;
+    if (strcmp(end, "ms") == 0) scale = 1e6;
+    else if (strcmp(end, "m") == 0) scale = 60e9;
+    else if (strcmp(end, "h") == 0) scale = 3600e9;
+    else if (strcmp(end, "d") == 0) scale = 86400e9;
+    else if (*end != '\0' && strcmp(end, "s") != 0) return -1;
+    *ns = (int64_t)(value * scale);
+    return 0;
+}
+
+static int parse_policy(const char *name, int *policy) {
+    if (strcmp(name, "fifo") == 0) *policy = SCHED_FIFO;
+    else if (strcmp(name, "rr") == 0) *policy = SCHED_RR;
+    else if (strcmp(name, "other") == 0) *policy = SCHED_OTHER;
+    else return -1;
+    return 0;
+}
+
+static const char *policy_name(int policy) {
+    return policy == SCHED_FIFO ? "fifo" : policy == SCHED_RR ? "rr" : "other";
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -a, --affinity CPUS   CPUs to measure, e.g. 0,2-3 (default: all allowed)\n"
+            "  -y, --policy POLICY   fifo, rr or other (default: fifo)\n"
+            "  -p, --priority PRIO   RT priority (default: 80)\n"
+            "  -i, --interval US     base period in microseconds (default: 1000)\n"
+            "  -d, --distance US     period step between threads (default: 0)\n"
+            "  -D, --duration TIME   run time, e.g. 30s, 10m, 2h, 1d (default: 10s)\n"
+            "  -l, --loops N         stop after N cycles per thread\n"
+            "  -c, --clock CLOCK     monotonic or realtime (default: monotonic)\n"
+            "  -r, --refresh MS      live statistics period (default: 1000)\n"
+            "  -S, --stream SEC      streaming mode: interval snapshots every SEC seconds,\n"
+            "                        run until -D or a signal\n"
+            "  -b, --breaktrace US   flight recorder: freeze and dump the last cycles\n"
+            "                        when a wakeup is later than US\n"
+            "      --flight-size N   cycles kept per thread (default: 1000)\n"
+            "      --flight-dir DIR  where to write flight_T<thread>_<n>.txt (default: .)\n"
+            "      --flight-max N    dumps per thread (default: 10)\n"
+            "      --trace-stop      also stop ftrace (tracing_on = 0) on the first spike\n"
+            "      --log PREFIX      write every cycle to PREFIX_T<thread>.rtlog\n"
+            "      --log-size N      records per log (default: the whole run, 4M if unbounded)\n"
+            "  -q, --quiet           print only the final summary\n"
+            "  -h, --help            show this help\n",
+            prog);
+}
+
+static int parse_options(int argc, char *argv[], JitterConfig *config) {
+    static const struct option options[] = {
+        {"affinity", required_argument, NULL, 'a'}, {"policy", required_argument, NULL, 'y'},
+        {"priority", required_argument, NULL, 'p'}, {"interval", required_argument, NULL, 'i'},
+        {"distance", required_argument, NULL, 'd'}, {"duration", required_argument, NULL, 'D'},
+        {"loops", required_argument, NULL, 'l'},    {"clock", required_argument, NULL, 'c'},
+        {"refresh", required_argument, NULL, 'r'},  {"stream", required_argument, NULL, 'S'},
+        {"breaktrace", required_argument, NULL, 'b'},
+        {"flight-size", required_argument, NULL, OPT_FLIGHT_SIZE},
+        {"flight-dir", required_argument, NULL, OPT_FLIGHT_DIR},
+        {"flight-max", required_argument, NULL, OPT_FLIGHT_MAX},
+        {"trace-stop", no_argument, NULL, OPT_TRACE_STOP},
+        {"log", required_argument, NULL, OPT_LOG},
+        {"log-size", required_argument, NULL, OPT_LOG_SIZE},
+        {"quiet", no_argument, NULL, 'q'},          {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    *config = (JitterConfig){
+        .policy = SCHED_FIFO,
+        .priority = 80,
+        .interval_ns = 1000000LL,
+        .duration_ns = 10LL * 1000000000LL,
+        .clock = CLOCK_MONOTONIC,
+        .refresh_ns = 1000000000LL,
+        .flight_size = FLIGHT_DEFAULT_SIZE,
+        .flight_max = FLIGHT_DEFAULT_MAX_DUMPS,
+        .flight_dir = ".",
+        .trace = {.marker_fd = -1, .on_fd = -1},
+    };
+    int duration_set = 0;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "a:y:p:i:d:D:l:c:r:S:b:qh", options, NULL)) != -1) {
+        switch (opt) {
+        case 'a':
+            if (parse_cpu_list(optarg, config) != 0) {
+                fprintf(stderr, "Invalid CPU list: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'y':
+            if (parse_policy(optarg, &config->policy) != 0) {
+                fprintf(stderr, "Unknown policy: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'p': config->priority = atoi(optarg); break;
+        case 'i': config->interval_ns = atoll(optarg) * 1000LL; break;
+        case 'd': config->distance_ns = atoll(optarg) * 1000LL; break;
+        case 'D':
+            if (parse_duration(optarg, &config->duration_ns) != 0) {
+                fprintf(stderr, "Invalid duration: %s\n", optarg);
+                return -1;
+            }
+            duration_set = 1;
+            break;
+        case 'l': config->loops = atol(optarg); break;
+        case 'c':
+            if (strcmp(optarg, "monotonic") == 0) config->clock = CLOCK_MONOTONIC;
+            else if (strcmp(optarg, "realtime") == 0) config->clock = CLOCK_REALTIME;
+            else {
+                fprintf(stderr, "Unknown clock: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'r': config->refresh_ns = atoll(optarg) * 1000000LL; break;
+        case 'S':
+            if (parse_duration(optarg, &config->stream_ns) != 0 || config->stream_ns <= 0) {
+                fprintf(stderr, "Invalid stream interval: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'b': config->breaktrace_ns = atoll(optarg) * 1000LL; break;
+        case OPT_FLIGHT_SIZE: config->flight_size = atol(optarg); break;
+        case OPT_FLIGHT_DIR: config->flight_dir = optarg; break;
+        case OPT_FLIGHT_MAX: config->flight_max = atol(optarg); break;
+        case OPT_TRACE_STOP: config->trace_stop = 1; break;
+        case OPT_LOG: config->log_prefix = optarg; break;
+        case OPT_LOG_SIZE: config->log_size = atol(optarg); break;
+        case 'q': config->quiet = 1; break;
+        default: return -1;
+        }
+    }
+    if (optind < argc || config->interval_ns <= 0 || config->distance_ns < 0 || config->loops < 0 ||
+        config->refresh_ns <= 0 || config->breaktrace_ns < 0 || config->flight_size <= 0 ||
+        config->flight_max <= 0 || config->log_size < 0) {
+        return -1;
+    }
+    // With a loop count and no explicit duration, run until the loops are done.
+    if (config->loops > 0 && !duration_set) config->duration_ns = 0;
+    // Streaming runs until a signal unless a duration is given.
+    if (config->stream_ns > 0 && !duration_set) config->duration_ns = 0;
+
+    int min_prio = sched_get_priority_min(config->policy);
+    int max_prio = sched_get_priority_max(config->policy);
+    if (config->policy == SCHED_OTHER) config->priority = 0;
+    if (config->priority < min_prio || config->priority > max_prio) {
+        fprintf(stderr, "Priority must be in %d..%d for %s\n", min_prio, max_prio,
+                policy_name(config->policy));
+        return -1;
+    }
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return -1;
+    if (config->cpu_count == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) config->cpus[config->cpu_count++] = cpu;
+        }
+    }
+    for (int i = 0; i < config->cpu_count; ++i) {
+        if (!CPU_ISSET(config->cpus[i], &allowed)) {
+            fprintf(stderr, "CPU %d is offline or not in the process affinity mask\n", config->cpus[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Records per thread log: enough for the whole run when it is bounded. */
+static size_t log_capacity(const JitterThread *t, const JitterConfig *config) {
+    if (config->log_size > 0) return (size_t)config->log_size;
+    if (config->loops > 0) return (size_t)config->loops;
+    if (config->duration_ns > 0) return (size_t)(config->duration_ns / t->period_ns) + 16;
+    return LOG_DEFAULT_RECORDS;
+}
+
+static int log_open(JitterThread *t, const JitterConfig *config) {
+    static const char *const fields[LOG_FIELDS] = {"cycle", "time_ns", "latency_ns"};
+    static const char *const units[LOG_FIELDS] = {"", "ns", "ns"};
+    char path[512], policy[RT_LOG_TEXT_LEN];
+    snprintf(path, sizeof(path), "%s_T%d.rtlog", config->log_prefix, t->id);
+    snprintf(policy, sizeof(policy), "%s %d, CPU %d, period %" PRId64 " us", policy_name(config->policy),
+             config->priority, t->cpu, t->period_ns / 1000);
+    RtLogConfig log_config = {.title = "sched_fifo_jitter wakeup latency",
+                              .policy = policy,
+                              .clock = config->clock == CLOCK_MONOTONIC ? "CLOCK_MONOTONIC" : "CLOCK_REALTIME",
+                              .fields = fields,
+                              .units = units,
+                              .field_count = LOG_FIELDS,
+                              .capacity = log_capacity(t, config),
+                              .lock = 1};
+    int rc = rt_log_create(&t->log, path, &log_config);
+    if (rc != 0 && (errno == ENOMEM || errno == EPERM || errno == EAGAIN)) {
+        // Locking is over RLIMIT_MEMLOCK: a prefaulted but unlocked log still
+        // keeps faults out of the loop unless memory pressure evicts it
+        int lock_errno = errno;
+        log_config.lock = 0;
+        rc = rt_log_create(&t->log, path, &log_config);
+        if (rc == 0) {
+            fprintf(stderr, "WARNING: cannot lock %s (%s), logging unlocked; raise ulimit -l to lock it\n",
+                    path, strerror(lock_errno));
+        }
+    }
+    if (rc != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (t->id == 0 && rt_log_on_tmpfs(&t->log) == 0) {
+        fprintf(stderr, "WARNING: %s is not on tmpfs: writeback makes log appends page-fault; "
+                        "use a prefix under /dev/shm\n", path);
+    }
+    t->logging = 1;
+    return 0;
+}
+
+static int start_thread(JitterThread *t, const JitterConfig *config) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+
+    // Policy, priority and CPU are set before the thread runs its first instruction.
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(t->cpu, &cpu_set);
+    pthread_attr_setaffinity_np(&attr, sizeof(cpu_set), &cpu_set);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, config->policy);
+    struct sched_param sp = {.sched_priority = config->priority};
+    pthread_attr_setschedparam(&attr, &sp);
+
+    int rc = pthread_create(&t->thread, &attr, measure_thread, t);
+    if (rc == EPERM && config->policy != SCHED_OTHER) {
+        fprintf(stderr, "WARNING: no permission for %s; thread %d continues with SCHED_OTHER\n",
+                policy_name(config->policy), t->id);
+        pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+        sp.sched_priority = 0;
+        pthread_attr_setschedparam(&attr, &sp);
+        rc = pthread_create(&t->thread, &attr, measure_thread, t);
+    }
+    pthread_attr_destroy(&attr);
+    return rc;
+}
+
+int main(int argc, char *argv[]) {
+    JitterConfig config;
+    if (parse_options(argc, argv, &config) != 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // --- Lock and prefault memory ---
+    // mlockall prevents the process's memory from being paged to swap, and
+    // rt_mem_prepare also prefaults the heap used by the histograms below.
     // A page fault during a critical section can introduce huge latencies.
-    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    RtMemConfig mem_config = {.heap_reserve = 4 * 1024 * 1024, .stack_reserve = 64 * 1024};
+    RtMemReport mem_report;
+    if (rt_mem_prepare(&mem_config, &mem_report) != 0) {
         perror("WARNING: mlockall failed");
     }
+    rt_mem_print_report(&mem_report);
 
-    // --- 3. Set CPU affinity ---
-    // Pinning the thread to a single CPU core prevents the scheduler from migrating
-    // it, which would otherwise flush CPU caches and TLBs, causing latency spikes.
-    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
-    if (n_cpus > 0) {
-        cpu_set_t cpu_set;
-        CPU_ZERO(&cpu_set);
-        // Pin to the last core as it's often less busy with system tasks.
-        CPU_SET(n_cpus - 1, &cpu_set);
-        if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
-            perror("WARNING: pthread_setaffinity_np failed");
-        } else {
-            printf("Pinned thread to CPU %ld\n", n_cpus - 1);
+    static JitterThread threads[MAX_THREADS];
+    RtHist *total = rt_hist_create(HIST_MAX_NS, RT_HIST_DEFAULT_PRECISION);
+    if (!total) {
+        fprintf(stderr, "rt_hist_create failed\n");
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < config.cpu_count; ++i) {
+        threads[i] = (JitterThread){
+            .id = i,
+            .cpu = config.cpus[i],
+            .period_ns = config.interval_ns + (int64_t)i * config.distance_ns,
+            .hist = rt_hist_create(HIST_MAX_NS, RT_HIST_DEFAULT_PRECISION),
+            .config = &config,
+        };
+        if (!threads[i].hist) {
+            fprintf(stderr, "rt_hist_create failed\n");
+            return EXIT_FAILURE;
+        }
+        if (config.stream_ns > 0 && stream_init(&threads[i]) != 0) {
+            fprintf(stderr, "stream_init failed\n");
+            return EXIT_FAILURE;
         }
+        if (config.breaktrace_ns > 0) {
+            char name[48];
+            snprintf(name, sizeof(name), "T:%d CPU %d", i, config.cpus[i]);
+            RtFlightConfig flight_config = {.capacity = (size_t)config.flight_size,
+                                            .threshold_ns = config.breaktrace_ns,
+                                            .name = name,
+                                            .trace = &config.trace};
+            threads[i].flight = rt_flight_create(&flight_config);
+            if (!threads[i].flight) {
+                fprintf(stderr, "rt_flight_create failed\n");
+                return EXIT_FAILURE;
+            }
+        }
+        if (config.log_prefix && log_open(&threads[i], &config) != 0) return EXIT_FAILURE;
     }
 
-    const int64_t period = 2 * 1000000LL; /* 2ms */
-    const int samples = 5000;
-    int64_t deltas[samples]; // Store all deltas for percentile calculation
+    if (config.breaktrace_ns > 0) {
+        printf("Flight recorder: last %ld cycles, threshold %" PRId64 " us, dumps to %s\n", config.flight_size,
+               config.breaktrace_ns / 1000, config.flight_dir);
+        if (rt_trace_open(&config.trace, config.trace_stop) != 0) {
+            printf("tracefs trace_marker not available: spikes are not marked in ftrace\n");
+        } else if (config.trace_stop && config.trace.on_fd < 0) {
+            printf("tracefs tracing_on not writable: ftrace keeps running after a spike\n");
+        }
+    }
 
-    struct timespec next;
-    clock_gettime(CLOCK_MONOTONIC, &next);
-    int64_t next_ns = ts_to_ns(&next) + period;
+    // Wall-clock timestamps for snapshots and the worst wakeup.
+    if (config.clock == CLOCK_MONOTONIC) {
+        struct timespec real, mono;
+        clock_gettime(CLOCK_REALTIME, &real);
+        clock_gettime(CLOCK_MONOTONIC, &mono);
+        config.realtime_offset_ns = ts_to_ns(&real) - ts_to_ns(&mono);
+    }
 
-    for (int i = 0; i < samples; ++i) {
-        ns_to_ts(next_ns, &next);
-        int rc;
-        // Absolute wait is crucial to prevent period drift.
-        do {
-            rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
-        } while (rc == EINTR);
+    printf("%d thread(s), policy %s, priority %d, interval %" PRId64 " us, distance %" PRId64
+           " us, clock %s\n",
+           config.cpu_count, policy_name(config.policy), config.priority, config.interval_ns / 1000,
+           config.distance_ns / 1000, config.clock == CLOCK_MONOTONIC ? "monotonic" : "realtime");
+
+    int started = 0;
+    for (; started < config.cpu_count; ++started) {
+        int rc = start_thread(&threads[started], &config);
         if (rc != 0) {
-            fprintf(stderr, "clock_nanosleep: %s\n", strerror(rc));
-            return EXIT_FAILURE;
+            fprintf(stderr, "pthread_create for CPU %d: %s\n", threads[started].cpu, strerror(rc));
+            __atomic_store_n(&stop_requested, 1, __ATOMIC_RELAXED);
+            break;
         }
+    }
+
+    // Only started threads send a final snapshot, so the reporter waits for those.
+    Reporter reporter = {.threads = threads, .count = started};
+    pthread_t reporter_tid;
+    int reporting = config.stream_ns > 0 && started > 0;
+    if (reporting) {
+        printf("Streaming snapshots every %.1f s\n", (double)config.stream_ns / 1e9);
+        int rc = pthread_create(&reporter_tid, NULL, reporter_thread, &reporter);
+        if (rc != 0) {
+            fprintf(stderr, "pthread_create for reporter: %s\n", strerror(rc));
+            reporting = 0;
+        }
+    }
 
+    // --- Live statistics from the non-RT main thread ---
+    struct timespec start_ts;
+    clock_gettime(CLOCK_MONOTONIC, &start_ts);
+    int64_t start_ns = ts_to_ns(&start_ts);
+    int live_lines = 0;
+    for (;;) {
+        struct timespec pause;
+        ns_to_ts(config.refresh_ns, &pause);
+        nanosleep(&pause, NULL);
+
+        int running = 0;
+        for (int i = 0; i < started; ++i) running += !__atomic_load_n(&threads[i].finished, __ATOMIC_ACQUIRE);
         struct timespec now;
         clock_gettime(CLOCK_MONOTONIC, &now);
-        // The "error" or "jitter" for this cycle.
-        // It's the difference between when we woke up and when we *should* have.
-        deltas[i] = ts_to_ns(&now) - next_ns;
-        next_ns += period;
+        if (config.duration_ns > 0 && ts_to_ns(&now) - start_ns >= config.duration_ns) {
+            __atomic_store_n(&stop_requested, 1, __ATOMIC_RELAXED);
+        }
+
+        if (config.breaktrace_ns > 0 && flight_collect(threads, started, &config) > 0) live_lines = 0;
+        if (!config.quiet && config.stream_ns == 0) {
+            // On a terminal redraw the block in place, in a log append it.
+            if (live_lines && isatty(STDOUT_FILENO)) printf("\033[%dA", live_lines);
+            print_live(threads, started);
+            live_lines = started;
+        }
+        if (running == 0 || should_stop()) break;
+    }
+
+    if (started == 0) return EXIT_FAILURE;
+    int failed = started < config.cpu_count;
+    for (int i = 0; i < started; ++i) {
+        pthread_join(threads[i].thread, NULL);
+        if (threads[i].error) {
+            fprintf(stderr, "thread %d: clock_nanosleep: %s\n", i, strerror(threads[i].error));
+            failed = 1;
+        }
+        rt_hist_merge(total, threads[i].hist);
     }
+    if (reporting) pthread_join(reporter_tid, NULL);
+    if (config.breaktrace_ns > 0) flight_collect(threads, started, &config);
 
     // --- Statistics ---
-    qsort(deltas, samples, sizeof(int64_t), compare_i64);
-    int64_t min = deltas[0];
-    int64_t max = deltas[samples - 1];
-    int64_t p99 = deltas[(samples * 99) / 100];
-    int64_t sum = 0;
-    for (int i = 0; i < samples; ++i) {
-        sum += deltas[i];
-    }
-    double avg = (double)sum / (double)samples;
-
-    printf("\nJitter statistics over %d samples (2ms period):\n", samples);
-    printf("  min latency: %" PRId64 " ns\n", min);
-    printf("  avg latency: %.1f ns\n", avg);
-    printf("  99th percentile: %" PRId64 " ns\n", p99);
-    printf("  max latency: %" PRId64 " ns\n", max);
+    printf("\nWakeup latency per CPU:\n");
+    for (int i = 0; i < started; ++i) {
+        char title[96];
+        snprintf(title, sizeof(title), "T:%d CPU %d, period %" PRId64 " us, overruns %" PRIu64 ":",
+                 i, threads[i].cpu, threads[i].period_ns / 1000, threads[i].overruns);
+        rt_hist_print(threads[i].hist, title, "ns");
+    }
+    rt_hist_print(total, "All CPUs:", "ns");
+    print_histogram(threads, started, total);
 
-    return 0;
-}
-#endif
+    printf("\nWorst wakeup per CPU:\n");
+    for (int i = 0; i < started; ++i) {
+        if (!threads[i].cycles) continue;
+        char when[48];
+        format_time(&config, threads[i].worst_at_ns, when, sizeof(when));
+        printf("  T:%d CPU %d: %" PRId64 " us at %s\n", i, threads[i].cpu, threads[i].max / 1000, when);
+    }
+
+    if (config.breaktrace_ns > 0) {
+        printf("\nFlight recorder, wakeups over %" PRId64 " us:\n", config.breaktrace_ns / 1000);
+        for (int i = 0; i < started; ++i) {
+            printf("  T:%d CPU %d: %" PRIu64 " spike(s), %ld dump(s)\n", i, threads[i].cpu,
+                   rt_flight_events(threads[i].flight), threads[i].flight_dumps);
+        }
+        rt_trace_close(&config.trace);
+    }
 
+    if (config.log_prefix) {
+        printf("\nSample logs (common/bin/rtanalyze):\n");
+        for (int i = 0; i < config.cpu_count; ++i) {
+            printf("  %s_T%d.rtlog: %" PRIu64 " records, %" PRIu64 " dropped\n", config.log_prefix, i,
+                   threads[i].log.count, threads[i].log.header->dropped);
+            if (rt_log_close(&threads[i].log) != 0) perror("rt_log_close");
+        }
+    }
 
+    for (int i = 0; i < config.cpu_count; ++i) {
+        rt_flight_destroy(threads[i].flight);
+        rt_hist_destroy(threads[i].hist);
+        if (config.stream_ns > 0) stream_destroy(&threads[i]);
+    }
+    rt_hist_destroy(total);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,716 @@
+/*
+ * Wake-up mechanism shoot-out: the same periodic loop driven by every timing
+ * primitive the other task2 demos use, measured side by side.
+ *
+ * For each mechanism a fresh thread (pinned, with the requested policy) waits
+ * for the deadlines start + k * period, optionally burns -w microseconds of
+ * work per cycle, and records how late it woke up. Per mechanism and policy
+ * the table shows:
+ * - the wakeup latency distribution (rt_hist);
+ * - CPU usage of the thread (user + system time / wall time);
+ * - syscalls per cycle, counted with the raw_syscalls:sys_enter tracepoint
+ *   through perf_event_open (needs tracefs and perf permissions, otherwise
+ *   "n/a");
+ * - voluntary context switches per cycle (1 for a blocking wait, 0 for
+ *   busy-poll).
+ *
+ * Mechanisms:
+ *   clock_nanosleep  absolute deadline, TIMER_ABSTIME
+ *   nanosleep        relative sleep to the deadline
+ *   timerfd          periodic timerfd, blocking read()
+ *   posix_timer      periodic timer_create + SIGRTMIN, sigwaitinfo()
+ *   itimer           setitimer(ITIMER_REAL) + SIGALRM, sigwaitinfo() (alarm.c)
+ *   condvar          pthread_cond_timedwait on a CLOCK_MONOTONIC condvar
+ *   poll             poll() with a millisecond timeout
+ *   ppoll            ppoll() with a nanosecond timeout
+ *   epoll            epoll_wait() with a millisecond timeout
+ *   epoll_pwait2     epoll_pwait2() with a nanosecond timeout (Linux 5.11+)
+ *   mq               mq_timedreceive() on an empty queue (CLOCK_REALTIME deadline)
+ *   busy_poll        spinning on clock_gettime (vDSO, no syscalls)
+ *
+ * Examples:
+ *   wakeup_shootout                          # all mechanisms, other and fifo
+ *   wakeup_shootout -a 3 -i 500 -n 5000 -y fifo
+ *   wakeup_shootout -m clock_nanosleep,timerfd,busy_poll -w 100
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rt_hist.h"
+#include "rt_mem.h"
+
+#ifndef __linux__
+int main(void) {
+    printf("wakeup_shootout: Linux-only example\n");
+    return 0;
+}
+#else
+
+#include <linux/perf_event.h>
+#include <mqueue.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/timerfd.h>
+
+#ifndef SYS_epoll_pwait2
+#define SYS_epoll_pwait2 441
+#endif
+
+#define HIST_MAX_NS (1000LL * 1000000LL) /* wakeups later than 1 s are clamped */
+#define WARMUP_CYCLES 20
+#define THREAD_STACK_SIZE (256 * 1024)
+#define THREAD_STACK_PREFAULT (64 * 1024)
+
+typedef struct {
+    int64_t period_ns;
+    long cycles;
+    int64_t work_ns;
+    int cpu;
+    int priority;
+    int policies[2];
+    int policy_count;
+    unsigned mechanisms; /* bit per entry of mechanisms[] */
+} ShootoutConfig;
+
+/* Resources of one mechanism, created in the measuring thread. */
+typedef struct {
+    const ShootoutConfig *config;
+    int fd;             /* timerfd, epoll or pipe read end */
+    int pipe_write;
+    timer_t timer;
+    int timer_created;
+    sigset_t signals;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    mqd_t mq;
+    char mq_name[64];
+    int64_t realtime_offset_ns; /* CLOCK_REALTIME - CLOCK_MONOTONIC */
+} WaitState;
+
+typedef struct {
+    const char *name;
+    /* first_deadline_ns lets periodic kernel timers run on the same grid. */
+    int (*setup)(WaitState *st, int64_t first_deadline_ns);
+    /* Returns 0 after waking at or after the deadline, or an errno value. */
+    int (*wait)(WaitState *st, int64_t deadline_ns);
+    void (*teardown)(WaitState *st);
+} Mechanism;
+
+typedef struct {
+    const Mechanism *mechanism;
+    const ShootoutConfig *config;
+    int policy;
+    RtHist *hist;
+    uint64_t overruns;
+    double cpu_percent;
+    double syscalls_per_cycle; /* < 0: not available */
+    double vcsw_per_cycle;
+    int error;
+    const char *error_what;
+} ShootoutRun;
+
+static inline int64_t ts_to_ns(const struct timespec *ts) {
+    return (int64_t)ts->tv_sec * 1000000000LL + (int64_t)ts->tv_nsec;
+}
+static inline void ns_to_ts(int64_t ns, struct timespec *ts) {
+    ts->tv_sec = (time_t)(ns / 1000000000LL);
+    ts->tv_nsec = (long)(ns % 1000000000LL);
+}
+static inline int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts_to_ns(&ts);
+}
+static inline int timeout_ms(int64_t deadline_ns) {
+    int64_t left = deadline_ns - now_ns();
+    // Rounded up: a millisecond timeout never wakes before the deadline.
+    return left <= 0 ? 0 : (int)((left + 999999) / 1000000);
+}
+static inline void timeout_ts(int64_t deadline_ns, struct timespec *ts) {
+    int64_t left = deadline_ns - now_ns();
+    ns_to_ts(left > 0 ? left : 0, ts);
+}
+
+/* --- clock_nanosleep / nanosleep --- */
+
+static int wait_clock_nanosleep(WaitState *st, int64_t deadline_ns) {
+    (void)st;
+    struct timespec ts;
+    ns_to_ts(deadline_ns, &ts);
+    int rc;
+    while ((rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) == EINTR) {
+    }
+    return rc;
+}
+
+static int wait_nanosleep(WaitState *st, int64_t deadline_ns) {
+    (void)st;
+    struct timespec ts;
+    timeout_ts(deadline_ns, &ts);
+    while (nanosleep(&ts, &ts) != 0) {
+        if (errno != EINTR) return errno;
+    }
+    return 0;
+}
+
+/* --- timerfd --- */
+
+static int setup_timerfd(WaitState *st, int64_t first_deadline_ns) {
+    st->fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (st->fd < 0) return errno;
+    struct itimerspec its;
+    ns_to_ts(first_deadline_ns, &its.it_value);
+    ns_to_ts(st->config->period_ns, &its.it_interval);
+    return timerfd_settime(st->fd, TFD_TIMER_ABSTIME, &its, NULL) == 0 ? 0 : errno;
+}
+
+/*
+ * After an overrun the loop skips the missed deadlines, but an expiration may
+ * still be pending: periodic timer waits continue until the deadline passes.
+ */
+static int wait_timerfd(WaitState *st, int64_t deadline_ns) {
+    uint64_t expirations;
+    do {
+        if (read(st->fd, &expirations, sizeof(expirations)) != sizeof(expirations) && errno != EINTR) {
+            return errno;
+        }
+    } while (now_ns() < deadline_ns);
+    return 0;
+}
+
+static void close_fds(WaitState *st) {
+    if (st->fd >= 0) close(st->fd);
+    if (st->pipe_write >= 0) close(st->pipe_write);
+}
+
+/* --- POSIX timer and itimer, both delivered as signals --- */
+
+/*
+ * The signals stay blocked in every thread (see main) and are consumed with
+ * sigwaitinfo(): no handler runs, the wakeup is a plain return from a syscall.
+ */
+static int setup_posix_timer(WaitState *st, int64_t first_deadline_ns) {
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIGRTMIN;
+    if (timer_create(CLOCK_MONOTONIC, &sev, &st->timer) != 0) return errno;
+    st->timer_created = 1;
+    sigemptyset(&st->signals);
+    sigaddset(&st->signals, SIGRTMIN);
+    struct itimerspec its;
+    ns_to_ts(first_deadline_ns, &its.it_value);
+    ns_to_ts(st->config->period_ns, &its.it_interval);
+    return timer_settime(st->timer, TIMER_ABSTIME, &its, NULL) == 0 ? 0 : errno;
+}
+
+static int wait_signal(WaitState *st, int64_t deadline_ns) {
+    do {
+        if (sigwaitinfo(&st->signals, NULL) < 0 && errno != EINTR) return errno;
+    } while (now_ns() < deadline_ns);
+    return 0;
+}
+
+static void teardown_posix_timer(WaitState *st) {
+    if (st->timer_created) timer_delete(st->timer);
+    // Drop a signal that may have fired after the last wait.
+    struct timespec zero = {0, 0};
+    while (sigtimedwait(&st->signals, NULL, &zero) > 0) {
+    }
+}
+
+/* ITIMER_REAL has no absolute mode and runs on CLOCK_REALTIME: the first
+ * expiry is relative, so its grid is only as good as this setup call. */
+static int setup_itimer(WaitState *st, int64_t first_deadline_ns) {
+    sigemptyset(&st->signals);
+    sigaddset(&st->signals, SIGALRM);
+    struct itimerval itv;
+    int64_t first = first_deadline_ns - now_ns();
+    if (first < 1000) first = 1000;
+    itv.it_value.tv_sec = (time_t)(first / 1000000000LL);
+    itv.it_value.tv_usec = (suseconds_t)(first % 1000000000LL / 1000);
+    itv.it_interval.tv_sec = (time_t)(st->config->period_ns / 1000000000LL);
+    itv.it_interval.tv_usec = (suseconds_t)(st->config->period_ns % 1000000000LL / 1000);
+    return setitimer(ITIMER_REAL, &itv, NULL) == 0 ? 0 : errno;
+}
+
+static void teardown_itimer(WaitState *st) {
+    struct itimerval off;
+    memset(&off, 0, sizeof(off));
+    setitimer(ITIMER_REAL, &off, NULL);
+    struct timespec zero = {0, 0};
+    while (sigtimedwait(&st->signals, NULL, &zero) > 0) {
+    }
+}
+
+/* --- condition variable --- */
+
+static int setup_condvar(WaitState *st, int64_t first_deadline_ns) {
+    (void)first_deadline_ns;
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&st->mutex, NULL);
+    int rc = pthread_cond_init(&st->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    return rc;
+}
+
+static int wait_condvar(WaitState *st, int64_t deadline_ns) {
+    struct timespec ts;
+    ns_to_ts(deadline_ns, &ts);
+    pthread_mutex_lock(&st->mutex);
+    int rc = 0;
+    // Nobody signals: every return before the deadline is spurious.
+    while (rc != ETIMEDOUT && now_ns() < deadline_ns) rc = pthread_cond_timedwait(&st->cond, &st->mutex, &ts);
+    pthread_mutex_unlock(&st->mutex);
+    return rc == ETIMEDOUT || rc == 0 ? 0 : rc;
+}
+
+static void teardown_condvar(WaitState *st) {
+    pthread_cond_destroy(&st->cond);
+    pthread_mutex_destroy(&st->mutex);
+}
+
+/* --- poll family: wait on a pipe that never becomes readable --- */
+
+static int setup_pipe(WaitState *st, int64_t first_deadline_ns) {
+    (void)first_deadline_ns;
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) return errno;
+    st->fd = fds[0];
+    st->pipe_write = fds[1];
+    return 0;
+}
+
+static int wait_poll(WaitState *st, int64_t deadline_ns) {
+    struct pollfd pfd = {.fd = st->fd, .events = POLLIN};
+    while (now_ns() < deadline_ns) {
+        if (poll(&pfd, 1, timeout_ms(deadline_ns)) < 0 && errno != EINTR) return errno;
+    }
+    return 0;
+}
+
+static int wait_ppoll(WaitState *st, int64_t deadline_ns) {
+    struct pollfd pfd = {.fd = st->fd, .events = POLLIN};
+    while (now_ns() < deadline_ns) {
+        struct timespec ts;
+        timeout_ts(deadline_ns, &ts);
+        if (ppoll(&pfd, 1, &ts, NULL) < 0 && errno != EINTR) return errno;
+    }
+    return 0;
+}
+
+static int setup_epoll(WaitState *st, int64_t first_deadline_ns) {
+    int rc = setup_pipe(st, first_deadline_ns);
+    if (rc != 0) return rc;
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) return errno;
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = st->fd};
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, st->fd, &ev) != 0) {
+        rc = errno;
+        close(epfd);
+        return rc;
+    }
+    // The pipe is kept open through pipe_write; fd now refers to the epoll.
+    close(st->fd);
+    st->fd = epfd;
+    return 0;
+}
+
+static int setup_epoll_pwait2(WaitState *st, int64_t first_deadline_ns) {
+    int rc = setup_epoll(st, first_deadline_ns);
+    if (rc != 0) return rc;
+    // epoll_pwait2 appeared in Linux 5.11.
+    struct timespec zero = {0, 0};
+    struct epoll_event out;
+    if (syscall(SYS_epoll_pwait2, st->fd, &out, 1, &zero, NULL, 0) < 0 && errno == ENOSYS) return ENOSYS;
+    return 0;
+}
+
+static int wait_epoll(WaitState *st, int64_t deadline_ns) {
+    struct epoll_event ev;
+    while (now_ns() < deadline_ns) {
+        if (epoll_wait(st->fd, &ev, 1, timeout_ms(deadline_ns)) < 0 && errno != EINTR) return errno;
+    }
+    return 0;
+}
+
+static int wait_epoll_pwait2(WaitState *st, int64_t deadline_ns) {
+    struct epoll_event ev;
+    while (now_ns() < deadline_ns) {
+        struct timespec ts;
+        timeout_ts(deadline_ns, &ts);
+        if (syscall(SYS_epoll_pwait2, st->fd, &ev, 1, &ts, NULL, 0) < 0 && errno != EINTR) return errno;
+    }
+    return 0;
+}
+
+/* --- POSIX message queue --- */
+
+static int setup_mq(WaitState *st, int64_t first_deadline_ns) {
+    (void)first_deadline_ns;
+    snprintf(st->mq_name, sizeof(st->mq_name), "/wakeup_shootout_%d", (int)getpid());
+    struct mq_attr attr = {.mq_maxmsg = 1, .mq_msgsize = 8};
+    st->mq = mq_open(st->mq_name, O_RDWR | O_CREAT | O_EXCL, 0600, &attr);
+    if (st->mq == (mqd_t)-1) return errno;
+    mq_unlink(st->mq_name);
+    // mq_timedreceive takes a CLOCK_REALTIME deadline.
+    struct timespec real, mono;
+    clock_gettime(CLOCK_REALTIME, &real);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    st->realtime_offset_ns = ts_to_ns(&real) - ts_to_ns(&mono);
+    return 0;
+}
+
+static int wait_mq(WaitState *st, int64_t deadline_ns) {
+    char msg[8];
+    while (now_ns() < deadline_ns) {
+        struct timespec ts;
+        ns_to_ts(deadline_ns + st->realtime_offset_ns, &ts);
+        if (mq_timedreceive(st->mq, msg, sizeof(msg), NULL, &ts) < 0 && errno != ETIMEDOUT && errno != EINTR) {
+            return errno;
+        }
+    }
+    return 0;
+}
+
+static void teardown_mq(WaitState *st) {
+    mq_close(st->mq);
+}
+
+/* --- busy-poll --- */
+
+static int wait_busy(WaitState *st, int64_t deadline_ns) {
+    (void)st;
+    while (now_ns() < deadline_ns) {
+    }
+    return 0;
+}
+
+static const Mechanism mechanisms[] = {
+    {"clock_nanosleep", NULL, wait_clock_nanosleep, NULL},
+    {"nanosleep", NULL, wait_nanosleep, NULL},
+    {"timerfd", setup_timerfd, wait_timerfd, close_fds},
+    {"posix_timer", setup_posix_timer, wait_signal, teardown_posix_timer},
+    {"itimer", setup_itimer, wait_signal, teardown_itimer},
+    {"condvar", setup_condvar, wait_condvar, teardown_condvar},
+    {"poll", setup_pipe, wait_poll, close_fds},
+    {"ppoll", setup_pipe, wait_ppoll, close_fds},
+    {"epoll", setup_epoll, wait_epoll, close_fds},
+    {"epoll_pwait2", setup_epoll_pwait2, wait_epoll_pwait2, close_fds},
+    {"mq", setup_mq, wait_mq, teardown_mq},
+    {"busy_poll", NULL, wait_busy, NULL},
+};
+#define MECHANISM_COUNT ((int)(sizeof(mechanisms) / sizeof(mechanisms[0])))
+
+/* --- counters --- */
+
+/* raw_syscalls:sys_enter counts every syscall of the thread, or -1. */
+static int open_syscall_counter(void) {
+    static const char *const paths[] = {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                                        "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"};
+    long long id = -1;
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]) && id < 0; ++i) {
+        FILE *f = fopen(paths[i], "r");
+        if (!f) continue;
+        if (fscanf(f, "%lld", &id) != 1) id = -1;
+        fclose(f);
+    }
+    if (id < 0) return -1;
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_TRACEPOINT;
+    attr.config = (uint64_t)id;
+    attr.disabled = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+static int64_t thread_cpu_ns(const struct rusage *ru) {
+    return ((int64_t)ru->ru_utime.tv_sec + ru->ru_stime.tv_sec) * 1000000000LL +
+           ((int64_t)ru->ru_utime.tv_usec + ru->ru_stime.tv_usec) * 1000LL;
+}
+
+static void burn(int64_t ns) {
+    int64_t until = now_ns() + ns;
+    while (now_ns() < until) {
+    }
+}
+
+static void *measure_thread(void *arg) {
+    ShootoutRun *run = (ShootoutRun *)arg;
+    const ShootoutConfig *config = run->config;
+    const Mechanism *m = run->mechanism;
+    rt_mem_prefault_stack(THREAD_STACK_PREFAULT);
+
+    WaitState st;
+    memset(&st, 0, sizeof(st));
+    st.config = config;
+    st.fd = -1;
+    st.pipe_write = -1;
+
+    int64_t next_ns = now_ns() + config->period_ns;
+    if (m->setup && (run->error = m->setup(&st, next_ns)) != 0) {
+        run->error_what = "setup";
+        if (m->teardown) m->teardown(&st);
+        return NULL;
+    }
+    int counter = open_syscall_counter();
+
+    struct rusage ru_start, ru_end;
+    int64_t start_ns = 0;
+    for (long cycle = -WARMUP_CYCLES; cycle < config->cycles; ++cycle) {
+        if (cycle == 0) {
+            // Counting starts after the warm-up cycles.
+            if (counter >= 0) ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+            getrusage(RUSAGE_THREAD, &ru_start);
+            start_ns = now_ns();
+        }
+        if ((run->error = m->wait(&st, next_ns)) != 0) {
+            run->error_what = "wait";
+            break;
+        }
+        int64_t now = now_ns();
+        if (cycle >= 0) rt_hist_record(run->hist, now - next_ns);
+        if (config->work_ns > 0) burn(config->work_ns);
+
+        next_ns += config->period_ns;
+        // Kernel timers keep their own grid; the loop skips the missed periods too.
+        while (next_ns <= now) {
+            next_ns += config->period_ns;
+            if (cycle >= 0) ++run->overruns;
+        }
+    }
+    int64_t wall_ns = now_ns() - start_ns;
+    getrusage(RUSAGE_THREAD, &ru_end);
+
+    run->syscalls_per_cycle = -1.0;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t syscalls;
+        if (read(counter, &syscalls, sizeof(syscalls)) == sizeof(syscalls)) {
+            run->syscalls_per_cycle = (double)syscalls / (double)config->cycles;
+        }
+        close(counter);
+    }
+    if (!run->error && wall_ns > 0) {
+        run->cpu_percent = 100.0 * (double)(thread_cpu_ns(&ru_end) - thread_cpu_ns(&ru_start)) / (double)wall_ns;
+        run->vcsw_per_cycle = (double)(ru_end.ru_nvcsw - ru_start.ru_nvcsw) / (double)config->cycles;
+    }
+    if (m->teardown) m->teardown(&st);
+    return NULL;
+}
+
+static const char *policy_name(int policy) {
+    return policy == SCHED_FIFO ? "fifo" : policy == SCHED_RR ? "rr" : "other";
+}
+
+/* Runs one mechanism in a new pinned thread; returns pthread_create's error. */
+static int run_mechanism(ShootoutRun *run) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+    if (run->config->cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(run->config->cpu, &cpu_set);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpu_set), &cpu_set);
+    }
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, run->policy);
+    struct sched_param sp = {.sched_priority = run->policy == SCHED_OTHER ? 0 : run->config->priority};
+    pthread_attr_setschedparam(&attr, &sp);
+
+    pthread_t thread;
+    int rc = pthread_create(&thread, &attr, measure_thread, run);
+    pthread_attr_destroy(&attr);
+    if (rc == 0) pthread_join(thread, NULL);
+    return rc;
+}
+
+static void print_header(void) {
+    printf("%-16s %-6s %8s %8s %8s %8s %8s %8s %9s %7s %9s %8s\n", "mechanism", "policy", "min", "p50", "p99",
+           "p99.9", "max", "avg", "overruns", "cpu%", "sys/cyc", "vcsw/cyc");
+    printf("%-16s %-6s %8s %8s %8s %8s %8s %8s\n", "", "", "us", "us", "us", "us", "us", "us");
+}
+
+static void print_row(const ShootoutRun *run) {
+    const RtHist *h = run->hist;
+    char syscalls[16];
+    if (run->syscalls_per_cycle < 0) snprintf(syscalls, sizeof(syscalls), "n/a");
+    else snprintf(syscalls, sizeof(syscalls), "%.2f", run->syscalls_per_cycle);
+    printf("%-16s %-6s %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %9" PRIu64 " %7.1f %9s %8.2f\n", run->mechanism->name,
+           policy_name(run->policy), rt_hist_min(h) / 1000.0, rt_hist_percentile(h, 50.0) / 1000.0,
+           rt_hist_percentile(h, 99.0) / 1000.0, rt_hist_percentile(h, 99.9) / 1000.0, rt_hist_max(h) / 1000.0,
+           rt_hist_mean(h) / 1000.0, run->overruns, run->cpu_percent, syscalls, run->vcsw_per_cycle);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -a, --cpu CPU          pin the measuring thread (default: not pinned)\n"
+            "  -i, --interval US      period in microseconds (default: 1000)\n"
+            "  -n, --cycles N         measured cycles per mechanism (default: 1000)\n"
+            "  -w, --work US          busy work per cycle in microseconds (default: 0)\n"
+            "  -y, --policy LIST      other, fifo, rr, comma-separated (default: other,fifo)\n"
+            "  -p, --priority PRIO    RT priority (default: 80)\n"
+            "  -m, --mechanisms LIST  comma-separated subset (default: all)\n"
+            "  -h, --help             show this help\n"
+            "Mechanisms:",
+            prog);
+    for (int i = 0; i < MECHANISM_COUNT; ++i) fprintf(stderr, " %s", mechanisms[i].name);
+    fprintf(stderr, "\n");
+}
+
+static int parse_mechanisms(char *list, unsigned *mask) {
+    *mask = 0;
+    for (char *name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        int found = -1;
+        for (int i = 0; i < MECHANISM_COUNT; ++i) {
+            if (strcmp(name, mechanisms[i].name) == 0) found = i;
+        }
+        if (found < 0) {
+            fprintf(stderr, "Unknown mechanism: %s\n", name);
+            return -1;
+        }
+        *mask |= 1u << found;
+    }
+    return *mask ? 0 : -1;
+}
+
+static int parse_policies(char *list, ShootoutConfig *config) {
+    config->policy_count = 0;
+    for (char *name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        if (config->policy_count == 2) return -1;
+        int policy;
+        if (strcmp(name, "fifo") == 0) policy = SCHED_FIFO;
+        else if (strcmp(name, "rr") == 0) policy = SCHED_RR;
+        else if (strcmp(name, "other") == 0) policy = SCHED_OTHER;
+        else return -1;
+        config->policies[config->policy_count++] = policy;
+    }
+    return config->policy_count > 0 ? 0 : -1;
+}
+
+static int parse_options(int argc, char *argv[], ShootoutConfig *config) {
+    static const struct option options[] = {
+        {"cpu", required_argument, NULL, 'a'},      {"interval", required_argument, NULL, 'i'},
+        {"cycles", required_argument, NULL, 'n'},   {"work", required_argument, NULL, 'w'},
+        {"policy", required_argument, NULL, 'y'},   {"priority", required_argument, NULL, 'p'},
+        {"mechanisms", required_argument, NULL, 'm'}, {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    *config = (ShootoutConfig){
+        .period_ns = 1000000LL,
+        .cycles = 1000,
+        .cpu = -1,
+        .priority = 80,
+        .policies = {SCHED_OTHER, SCHED_FIFO},
+        .policy_count = 2,
+        .mechanisms = (1u << MECHANISM_COUNT) - 1,
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "a:i:n:w:y:p:m:h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'a': config->cpu = atoi(optarg); break;
+        case 'i': config->period_ns = atoll(optarg) * 1000LL; break;
+        case 'n': config->cycles = atol(optarg); break;
+        case 'w': config->work_ns = atoll(optarg) * 1000LL; break;
+        case 'y':
+            if (parse_policies(optarg, config) != 0) {
+                fprintf(stderr, "Invalid policy list: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'p': config->priority = atoi(optarg); break;
+        case 'm':
+            if (parse_mechanisms(optarg, &config->mechanisms) != 0) return -1;
+            break;
+        default: return -1;
+        }
+    }
+    if (optind < argc || config->period_ns <= 0 || config->cycles <= 0 || config->work_ns < 0 ||
+        config->work_ns >= config->period_ns) {
+        return -1;
+    }
+    if (config->cpu >= CPU_SETSIZE) return -1;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    ShootoutConfig config;
+    if (parse_options(argc, argv, &config) != 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    // Timer signals are consumed with sigwaitinfo(): block them in every
+    // thread (the mask is inherited) so none is delivered as a default action.
+    sigset_t timer_signals;
+    sigemptyset(&timer_signals);
+    sigaddset(&timer_signals, SIGRTMIN);
+    sigaddset(&timer_signals, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &timer_signals, NULL);
+
+    RtMemConfig mem_config = {.heap_reserve = 1024 * 1024, .stack_reserve = 64 * 1024};
+    if (rt_mem_prepare(&mem_config, NULL) != 0) perror("WARNING: mlockall failed");
+
+    printf("period %" PRId64 " us, %ld cycles, work %" PRId64 " us, ", config.period_ns / 1000, config.cycles,
+           config.work_ns / 1000);
+    if (config.cpu >= 0) printf("pinned to CPU %d\n", config.cpu);
+    else printf("not pinned\n");
+    print_header();
+
+    RtHist *hist = rt_hist_create(HIST_MAX_NS, RT_HIST_DEFAULT_PRECISION);
+    if (!hist) {
+        fprintf(stderr, "rt_hist_create failed\n");
+        return EXIT_FAILURE;
+    }
+    int failed = 0;
+    for (int p = 0; p < config.policy_count; ++p) {
+        for (int i = 0; i < MECHANISM_COUNT; ++i) {
+            if (!(config.mechanisms & (1u << i))) continue;
+            rt_hist_reset(hist);
+            ShootoutRun run = {.mechanism = &mechanisms[i], .config = &config, .policy = config.policies[p],
+                               .hist = hist};
+            int rc = run_mechanism(&run);
+            if (rc != 0) {
+                printf("%-16s %-6s pthread_create: %s\n", mechanisms[i].name, policy_name(run.policy),
+                       strerror(rc));
+                failed = 1;
+                if (rc == EPERM) break; // the other mechanisms would fail the same way
+                continue;
+            }
+            if (run.error) {
+                printf("%-16s %-6s %s: %s\n", mechanisms[i].name, policy_name(run.policy), run.error_what,
+                       strerror(run.error));
+                continue;
+            }
+            print_row(&run);
+        }
+    }
+    rt_hist_destroy(hist);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif
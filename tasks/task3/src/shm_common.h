@@ -1,7 +1,9 @@
 #ifndef SHM_COMMON_H
 #define SHM_COMMON_H
 
+#include <stddef.h>
 #include <stdint.h>
+#include "shm_pool.h"
 
 // Имена для объектов ядра (shared memory и семафоры)
 // Начинаем с / для переносимости между системами.
@@ -11,10 +13,28 @@
 
 #define BUFFER_SIZE     10 
 
+// Полезная нагрузка передается через пул блоков в том же сегменте.
+// Блоков больше, чем мест в кольце: еще по одному держат producer и consumer.
+#define PAYLOAD_BLOCK_SIZE  4096
+#define PAYLOAD_BLOCK_COUNT (BUFFER_SIZE + 2)
+
+// Элемент кольца: вместо самих данных — смещение блока в пуле
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} shm_message_t;
+
 typedef struct {
-    uint64_t buffer[BUFFER_SIZE];
+    shm_message_t buffer[BUFFER_SIZE];
     int head; // Индекс для записи (producer)
     int tail; // Индекс для чтения (consumer)
+    // Должен быть последним: сразу за ним лежат блоки пула. Сегмент
+    // отображается с границы страницы, поэтому _Alignas(64) делает
+    // выровненными на 64 байта и сами блоки, а не только их смещения
+    _Alignas(64) shm_pool_t pool;
 } shared_data_t;
 
+#define SHM_POOL_REGION_SIZE (sizeof(shm_pool_t) + 64 + (size_t)PAYLOAD_BLOCK_COUNT * PAYLOAD_BLOCK_SIZE)
+#define SHM_SEGMENT_SIZE     (offsetof(shared_data_t, pool) + SHM_POOL_REGION_SIZE)
+
 #endif // SHM_COMMON_H
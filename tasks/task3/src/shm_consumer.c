@@ -3,7 +3,8 @@
  *
  * 1. Открывает существующий сегмент разделяемой памяти.
  * 2. Открывает существующие семафоры.
- * 3. В цикле читает данные из кольцевого буфера, когда они доступны.
+ * 3. В цикле читает из кольцевого буфера смещения блоков, обрабатывает
+ *    сообщение прямо в общей памяти и возвращает блок в пул.
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -34,7 +35,7 @@ int main() {
         perror("shm_open");
         exit(EXIT_FAILURE);
     }
-    shared_data_t *shared_data = mmap(0, sizeof(shared_data_t), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    shared_data_t *shared_data = mmap(0, SHM_SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
     if (shared_data == MAP_FAILED) {
         perror("mmap");
         exit(EXIT_FAILURE);
@@ -56,8 +57,22 @@ int main() {
     while (!done) {
         sem_wait(sem_cons);
 
-        uint64_t value = shared_data->buffer[shared_data->tail];
-        printf("Consumed: %llu from index %d\n", (unsigned long long)value, shared_data->tail);
+        shm_message_t msg = shared_data->buffer[shared_data->tail];
+        const char *payload = shm_pool_ptr(&shared_data->pool, msg.offset);
+        unsigned long long value = 0;
+        int header = 0;
+        sscanf(payload, "message %llu%n", &value, &header);
+
+        // Проверить, что блок дошел целиком: после заголовка — байт шаблона
+        int intact = header > 0;
+        for (uint32_t i = (uint32_t)header + 1; intact && i < msg.length; ++i) {
+            intact = (unsigned char)payload[i] == (value & 0xff);
+        }
+        printf("Consumed: %llu (%u bytes at offset %u, %s) from index %d\n",
+               value, msg.length, msg.offset, intact ? "ok" : "CORRUPTED", shared_data->tail);
+
+        // Блок больше не нужен: вернуть его в общий пул
+        shm_pool_free(&shared_data->pool, msg.offset);
         shared_data->tail = (shared_data->tail + 1) % BUFFER_SIZE;
 
         sem_post(sem_prod);
@@ -67,7 +82,7 @@ int main() {
 
     printf("\nConsumer: End of work...\n");
 
-    munmap(shared_data, sizeof(shared_data_t));
+    munmap(shared_data, SHM_SEGMENT_SIZE);
     close(shm_fd);
 
     sem_close(sem_prod);
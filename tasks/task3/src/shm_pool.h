@@ -0,0 +1,111 @@
+#ifndef SHM_POOL_H
+#define SHM_POOL_H
+
+/*
+ * Пул блоков фиксированного размера внутри сегмента POSIX shared memory.
+ *
+ * Каждый процесс отображает сегмент по своему адресу, поэтому пул не хранит
+ * указателей: блок задается смещением от начала структуры shm_pool_t.
+ * Список свободных блоков — lock-free стек, голова которого содержит
+ * смещение вершины и счетчик поколений (защита от ABA). Атомарные операции
+ * над 64-битным словом в общей памяти работают между процессами, если они
+ * lock-free, что проверяется при компиляции.
+ *
+ * Производитель выделяет блок, заполняет его и передает потребителю только
+ * смещение; потребитель освобождает блок после обработки (zero-copy).
+ */
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+_Static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shm_pool requires lock-free 64-bit atomics");
+
+// Смещение 0 — это сама структура пула, блоком оно быть не может
+#define SHM_POOL_NIL 0u
+
+#define SHM_POOL_HEAD_OFFSET(h) ((uint32_t)(h))
+#define SHM_POOL_HEAD_TAG(h) ((uint32_t)((h) >> 32))
+#define SHM_POOL_HEAD_MAKE(tag, off) (((uint64_t)(tag) << 32) | (uint32_t)(off))
+
+typedef struct {
+    _Atomic uint64_t head;  // [поколение:32 | смещение вершины:32]
+    uint32_t block_size;
+    uint32_t block_count;
+    uint32_t first_block;   // смещение первого блока от начала пула
+    uint32_t end;           // смещение конца области пула
+} shm_pool_t;
+
+static inline void *shm_pool_ptr(shm_pool_t *pool, uint32_t offset) {
+    return offset == SHM_POOL_NIL ? NULL : (char *)pool + offset;
+}
+
+static inline uint32_t shm_pool_offset(shm_pool_t *pool, const void *block) {
+    return block ? (uint32_t)((const char *)block - (const char *)pool) : SHM_POOL_NIL;
+}
+
+// Смещение следующего свободного блока хранится в первых 4 байтах блока
+static inline _Atomic uint32_t *shm_pool_next(shm_pool_t *pool, uint32_t offset) {
+    return (_Atomic uint32_t *)((char *)pool + offset);
+}
+
+/*
+ * Разметить область [pool, pool + region_size) под блоки block_size байт.
+ * Вызывается один раз процессом, создающим сегмент. Возвращает число блоков.
+ */
+static inline uint32_t shm_pool_init(shm_pool_t *pool, size_t region_size, uint32_t block_size) {
+    if (block_size < sizeof(uint32_t)) block_size = sizeof(uint32_t);
+    // Блоки выравниваются на 64 байта относительно pool, чтобы не делить
+    // кэш-линии; сам pool должен лежать на границе 64 байт
+    block_size = (block_size + 63u) & ~63u;
+    uint32_t first = (uint32_t)((sizeof(shm_pool_t) + 63u) & ~(size_t)63u);
+    uint32_t count = region_size > first ? (uint32_t)((region_size - first) / block_size) : 0;
+
+    pool->block_size = block_size;
+    pool->block_count = count;
+    pool->first_block = first;
+    pool->end = first + count * block_size;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t offset = first + i * block_size;
+        uint32_t next = (i + 1 < count) ? offset + block_size : SHM_POOL_NIL;
+        atomic_store_explicit(shm_pool_next(pool, offset), next, memory_order_relaxed);
+    }
+    atomic_store_explicit(&pool->head, SHM_POOL_HEAD_MAKE(0, count ? first : SHM_POOL_NIL),
+                          memory_order_release);
+    return count;
+}
+
+// Возвращает смещение выделенного блока или SHM_POOL_NIL, если блоков нет
+static inline uint32_t shm_pool_alloc(shm_pool_t *pool) {
+    uint64_t head = atomic_load_explicit(&pool->head, memory_order_acquire);
+    for (;;) {
+        uint32_t offset = SHM_POOL_HEAD_OFFSET(head);
+        if (offset == SHM_POOL_NIL) return SHM_POOL_NIL;
+        uint32_t next = atomic_load_explicit(shm_pool_next(pool, offset), memory_order_relaxed);
+        uint64_t new_head = SHM_POOL_HEAD_MAKE(SHM_POOL_HEAD_TAG(head) + 1, next);
+        if (atomic_compare_exchange_weak_explicit(&pool->head, &head, new_head,
+                                                  memory_order_acquire, memory_order_acquire)) {
+            return offset;
+        }
+    }
+}
+
+// Возвращает 0, либо -1, если смещение не указывает на блок этого пула
+static inline int shm_pool_free(shm_pool_t *pool, uint32_t offset) {
+    if (offset < pool->first_block || offset >= pool->end ||
+        (offset - pool->first_block) % pool->block_size != 0) {
+        return -1;
+    }
+    uint64_t head = atomic_load_explicit(&pool->head, memory_order_relaxed);
+    uint64_t new_head;
+    do {
+        atomic_store_explicit(shm_pool_next(pool, offset), SHM_POOL_HEAD_OFFSET(head),
+                              memory_order_relaxed);
+        new_head = SHM_POOL_HEAD_MAKE(SHM_POOL_HEAD_TAG(head) + 1, offset);
+    } while (!atomic_compare_exchange_weak_explicit(&pool->head, &head, new_head,
+                                                    memory_order_release, memory_order_relaxed));
+    return 0;
+}
+
+#endif // SHM_POOL_H
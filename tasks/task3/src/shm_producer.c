@@ -5,7 +5,8 @@
  * 2. Создает или открывает два именованных семафора для синхронизации:
  *    - один показывает, сколько свободного места есть в буфере (для producer'а).
  *    - другой показывает, сколько элементов готовы для чтения (для consumer'а).
- * 3. В цикле записывает данные в кольцевой буфер.
+ * 3. В цикле выделяет блок из пула в общей памяти, заполняет его
+ *    и передает через кольцевой буфер только смещение блока (zero-copy).
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,6 +16,7 @@
 #include <fcntl.h>
 #include <semaphore.h>
 #include <signal.h>
+#include <string.h>
 #include "shm_common.h"
 
 volatile sig_atomic_t done = 0;
@@ -33,11 +35,11 @@ int main() {
         perror("shm_open");
         exit(EXIT_FAILURE);
     }
-    if (ftruncate(shm_fd, sizeof(shared_data_t)) == -1) {
+    if (ftruncate(shm_fd, SHM_SEGMENT_SIZE) == -1) {
         perror("ftruncate");
         exit(EXIT_FAILURE);
     }
-    shared_data_t *shared_data = mmap(0, sizeof(shared_data_t), PROT_WRITE | PROT_READ, MAP_SHARED, shm_fd, 0);
+    shared_data_t *shared_data = mmap(0, SHM_SEGMENT_SIZE, PROT_WRITE | PROT_READ, MAP_SHARED, shm_fd, 0);
     if (shared_data == MAP_FAILED) {
         perror("mmap");
         exit(EXIT_FAILURE);
@@ -58,13 +60,29 @@ int main() {
 
     shared_data->head = 0;
     shared_data->tail = 0;
+    uint32_t blocks = shm_pool_init(&shared_data->pool, SHM_POOL_REGION_SIZE, PAYLOAD_BLOCK_SIZE);
+    printf("Producer: Payload pool with %u blocks of %u bytes.\n", blocks, shared_data->pool.block_size);
 
     uint64_t counter = 0;
     while (!done) {
         sem_wait(sem_prod);
 
-        shared_data->buffer[shared_data->head] = counter;
-        printf("Produced: %llu at index %d\n", (unsigned long long)counter, shared_data->head);
+        // Выделить блок и записать сообщение прямо в общую память
+        uint32_t offset = shm_pool_alloc(&shared_data->pool);
+        if (offset == SHM_POOL_NIL) {
+            fprintf(stderr, "Producer: payload pool exhausted\n");
+            sem_post(sem_prod);
+            usleep(100000);
+            continue;
+        }
+        char *payload = shm_pool_ptr(&shared_data->pool, offset);
+        uint32_t length = 64 + (uint32_t)((counter * 397) % (PAYLOAD_BLOCK_SIZE - 64));
+        int header = snprintf(payload, 64, "message %llu", (unsigned long long)counter);
+        memset(payload + header + 1, (int)(counter & 0xff), length - (uint32_t)header - 1);
+
+        shared_data->buffer[shared_data->head] = (shm_message_t){.offset = offset, .length = length};
+        printf("Produced: %llu (%u bytes at offset %u) at index %d\n",
+               (unsigned long long)counter, length, offset, shared_data->head);
         shared_data->head = (shared_data->head + 1) % BUFFER_SIZE;
         counter++;
 
@@ -75,7 +93,7 @@ int main() {
 
     printf("\nProducer: End of work...\n");
 
-    munmap(shared_data, sizeof(shared_data_t));
+    munmap(shared_data, SHM_SEGMENT_SIZE);
     close(shm_fd);
     shm_unlink(SHM_NAME);
 
@@ -0,0 +1,80 @@
+#include "arena.h"
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+struct Arena {
+    char* base;
+    size_t capacity;
+    size_t offset;        // начало свободной части
+    size_t high_water;
+    unsigned long failures;
+};
+
+Arena* arena_create(size_t capacity) {
+    if (capacity == 0) return NULL;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    capacity = (capacity + page_size - 1) / page_size * page_size;
+
+    Arena* arena = (Arena*)calloc(1, sizeof(Arena));
+    if (!arena) return NULL;
+
+    // MAP_POPULATE отображает все страницы сразу, mlock не дает их вытеснить:
+    // выделения в цикле не вызывают ни page faults, ни системных вызовов
+    void* base = mmap(NULL, capacity, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (base == MAP_FAILED) {
+        free(arena);
+        return NULL;
+    }
+    mlock(base, capacity);
+
+    arena->base = (char*)base;
+    arena->capacity = capacity;
+    return arena;
+}
+
+void* arena_alloc_aligned(Arena* arena, size_t size, size_t align) {
+    uintptr_t current = (uintptr_t)arena->base + arena->offset;
+    uintptr_t aligned = (current + align - 1) & ~(uintptr_t)(align - 1);
+    size_t end = (size_t)(aligned - (uintptr_t)arena->base) + size;
+    if (end > arena->capacity || end < arena->offset) {
+        arena->failures++;
+        return NULL;
+    }
+    arena->offset = end;
+    if (end > arena->high_water) arena->high_water = end;
+    return (void*)aligned;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    return arena_alloc_aligned(arena, size, alignof(max_align_t));
+}
+
+ArenaMark arena_mark(const Arena* arena) {
+    return arena->offset;
+}
+
+void arena_restore(Arena* arena, ArenaMark mark) {
+    if (mark <= arena->offset) arena->offset = mark;
+}
+
+void arena_reset(Arena* arena) {
+    arena->offset = 0;
+}
+
+size_t arena_high_water(const Arena* arena) {
+    return arena->high_water;
+}
+
+unsigned long arena_failures(const Arena* arena) {
+    return arena->failures;
+}
+
+void arena_destroy(Arena* arena) {
+    if (!arena) return;
+    munmap(arena->base, arena->capacity);
+    free(arena);
+}
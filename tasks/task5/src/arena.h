@@ -0,0 +1,93 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Кадровая арена (frame arena) для периодических RT-циклов.
+ *
+ * Вся память отображается, прогревается и блокируется (mlock) при создании.
+ * Выделение — сдвиг указателя с выравниванием, освобождения отдельных
+ * объектов нет: в конце цикла arena_reset() за O(1) возвращает арену
+ * в исходное состояние. Вложенные области (scopes) задаются парой
+ * arena_mark()/arena_restore().
+ */
+
+typedef struct Arena Arena;
+
+/** Позиция в арене, сохраненная arena_mark() */
+typedef size_t ArenaMark;
+
+/**
+ * @brief Создает арену заданной емкости.
+ * 
+ * @param capacity Емкость в байтах (округляется до размера страницы).
+ * @return Указатель на арену или NULL в случае ошибки.
+ */
+Arena* arena_create(size_t capacity);
+
+/**
+ * @brief Выделяет size байт с выравниванием alignof(max_align_t).
+ * 
+ * @param arena Указатель на арену.
+ * @param size Размер в байтах.
+ * @return Указатель на память или NULL, если арена исчерпана.
+ */
+void* arena_alloc(Arena* arena, size_t size);
+
+/**
+ * @brief Выделяет size байт с заданным выравниванием.
+ * 
+ * @param arena Указатель на арену.
+ * @param size Размер в байтах.
+ * @param align Выравнивание, степень двойки.
+ * @return Указатель на память или NULL, если арена исчерпана.
+ */
+void* arena_alloc_aligned(Arena* arena, size_t size, size_t align);
+
+/**
+ * @brief Запоминает текущую позицию арены (начало вложенной области).
+ * 
+ * @param arena Указатель на арену.
+ */
+ArenaMark arena_mark(const Arena* arena);
+
+/**
+ * @brief Освобождает все, что выделено после arena_mark().
+ * 
+ * @param arena Указатель на арену.
+ * @param mark Позиция из arena_mark() этой же арены.
+ */
+void arena_restore(Arena* arena, ArenaMark mark);
+
+/**
+ * @brief Освобождает все выделения арены (конец цикла).
+ * 
+ * @param arena Указатель на арену.
+ */
+void arena_reset(Arena* arena);
+
+/**
+ * @brief Возвращает наибольшее число байт, занятых одновременно.
+ * 
+ * Позволяет подобрать емкость арены по результатам прогона.
+ * 
+ * @param arena Указатель на арену.
+ */
+size_t arena_high_water(const Arena* arena);
+
+/**
+ * @brief Возвращает число выделений, не поместившихся в арену.
+ * 
+ * @param arena Указатель на арену.
+ */
+unsigned long arena_failures(const Arena* arena);
+
+/**
+ * @brief Уничтожает арену и освобождает ее память.
+ * 
+ * @param arena Указатель на арену.
+ */
+void arena_destroy(Arena* arena);
+
+#endif // ARENA_H
@@ -0,0 +1,223 @@
+#include "magazine.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+// Магазин: стек блоков фиксированной емкости
+typedef struct Magazine {
+    size_t rounds;
+    void* slots[];
+} Magazine;
+
+// Магазины одного потока для одного кэша
+typedef struct MagThread {
+    MagazineCache* cache;
+    Magazine* loaded;
+    Magazine* previous;
+} MagThread;
+
+struct MagazineCache {
+    MemoryPool* pool;
+    size_t magazine_size;
+    pthread_key_t key;
+
+    // Депо: стеки полных и пустых магазинов, защищены мьютексом.
+    // Поток всегда отдает один магазин в обмен на другой, поэтому
+    // full_count + empty_count никогда не превышает depot_capacity.
+    pthread_mutex_t depot_lock;
+    Magazine** full;
+    Magazine** empty;
+    size_t full_count;
+    size_t empty_count;
+    size_t depot_capacity;
+};
+
+static Magazine* magazine_new(size_t magazine_size) {
+    Magazine* mag = (Magazine*)malloc(sizeof(Magazine) + magazine_size * sizeof(void*));
+    if (mag) mag->rounds = 0;
+    return mag;
+}
+
+// Вызывается с захваченным depot_lock
+static void magazine_drain_to_pool(MagazineCache* cache, Magazine* mag) {
+    pool_free_bulk(cache->pool, mag->slots, mag->rounds);
+    mag->rounds = 0;
+}
+
+// Вызывается с захваченным depot_lock
+static void magazine_fill_from_pool(MagazineCache* cache, Magazine* mag) {
+    mag->rounds += pool_alloc_bulk(cache->pool, mag->slots + mag->rounds,
+                                   cache->magazine_size - mag->rounds);
+}
+
+static void mag_thread_release(MagThread* mt) {
+    MagazineCache* cache = mt->cache;
+    pthread_mutex_lock(&cache->depot_lock);
+    magazine_drain_to_pool(cache, mt->loaded);
+    magazine_drain_to_pool(cache, mt->previous);
+    pthread_mutex_unlock(&cache->depot_lock);
+    free(mt->loaded);
+    free(mt->previous);
+    free(mt);
+}
+
+static void mag_thread_destructor(void* value) {
+    if (value) mag_thread_release((MagThread*)value);
+}
+
+static MagThread* mag_thread_get(MagazineCache* cache) {
+    MagThread* mt = (MagThread*)pthread_getspecific(cache->key);
+    if (mt) return mt;
+
+    mt = (MagThread*)malloc(sizeof(MagThread));
+    if (!mt) return NULL;
+    mt->cache = cache;
+    mt->loaded = magazine_new(cache->magazine_size);
+    mt->previous = magazine_new(cache->magazine_size);
+    if (!mt->loaded || !mt->previous || pthread_setspecific(cache->key, mt) != 0) {
+        free(mt->loaded);
+        free(mt->previous);
+        free(mt);
+        return NULL;
+    }
+    return mt;
+}
+
+MagazineCache* mag_create(MemoryPool* pool, size_t magazine_size, size_t depot_magazines) {
+    if (!pool || magazine_size == 0) return NULL;
+
+    MagazineCache* cache = (MagazineCache*)calloc(1, sizeof(MagazineCache));
+    if (!cache) return NULL;
+
+    cache->pool = pool;
+    cache->magazine_size = magazine_size;
+    cache->depot_capacity = depot_magazines;
+    cache->full = (Magazine**)calloc(depot_magazines + 1, sizeof(Magazine*));
+    cache->empty = (Magazine**)calloc(depot_magazines + 1, sizeof(Magazine*));
+    if (!cache->full || !cache->empty) goto fail;
+
+    // Все магазины депо создаются сразу, чтобы обмен не вызывал malloc
+    for (size_t i = 0; i < depot_magazines; ++i) {
+        Magazine* mag = magazine_new(magazine_size);
+        if (!mag) goto fail;
+        cache->empty[cache->empty_count++] = mag;
+    }
+
+    if (pthread_key_create(&cache->key, mag_thread_destructor) != 0) goto fail;
+    pthread_mutex_init(&cache->depot_lock, NULL);
+    return cache;
+
+fail:
+    if (cache->empty) {
+        for (size_t i = 0; i < cache->empty_count; ++i) free(cache->empty[i]);
+    }
+    free(cache->full);
+    free(cache->empty);
+    free(cache);
+    return NULL;
+}
+
+int mag_thread_init(MagazineCache* cache) {
+    return mag_thread_get(cache) ? 0 : -1;
+}
+
+void* mag_alloc(MagazineCache* cache) {
+    MagThread* mt = mag_thread_get(cache);
+    if (!mt) return NULL;
+
+    // Быстрый путь: только память текущего потока
+    if (mt->loaded->rounds > 0) {
+        return mt->loaded->slots[--mt->loaded->rounds];
+    }
+    if (mt->previous->rounds > 0) {
+        Magazine* tmp = mt->loaded;
+        mt->loaded = mt->previous;
+        mt->previous = tmp;
+        return mt->loaded->slots[--mt->loaded->rounds];
+    }
+
+    // Оба магазина пусты: обменять пустой магазин на полный из депо,
+    // а если полных нет — наполнить текущий прямо из пула
+    pthread_mutex_lock(&cache->depot_lock);
+    if (cache->full_count > 0) {
+        cache->empty[cache->empty_count++] = mt->previous;
+        mt->previous = mt->loaded;
+        mt->loaded = cache->full[--cache->full_count];
+    } else {
+        magazine_fill_from_pool(cache, mt->loaded);
+    }
+    pthread_mutex_unlock(&cache->depot_lock);
+
+    if (mt->loaded->rounds == 0) return NULL;
+    return mt->loaded->slots[--mt->loaded->rounds];
+}
+
+void mag_free(MagazineCache* cache, void* block) {
+    if (!block) return;
+    MagThread* mt = mag_thread_get(cache);
+    if (!mt) {
+        // Нет памяти под магазины потока: вернуть блок напрямую в пул
+        pthread_mutex_lock(&cache->depot_lock);
+        pool_free(cache->pool, block);
+        pthread_mutex_unlock(&cache->depot_lock);
+        return;
+    }
+
+    // Быстрый путь: только память текущего потока
+    if (mt->loaded->rounds < cache->magazine_size) {
+        mt->loaded->slots[mt->loaded->rounds++] = block;
+        return;
+    }
+    if (mt->previous->rounds == 0) {
+        Magazine* tmp = mt->loaded;
+        mt->loaded = mt->previous;
+        mt->previous = tmp;
+        mt->loaded->slots[mt->loaded->rounds++] = block;
+        return;
+    }
+
+    // Оба магазина полны: отдать полный магазин в депо в обмен на пустой,
+    // а если пустых нет — вернуть его содержимое пачкой в пул
+    pthread_mutex_lock(&cache->depot_lock);
+    if (cache->empty_count > 0) {
+        cache->full[cache->full_count++] = mt->previous;
+        mt->previous = mt->loaded;
+        mt->loaded = cache->empty[--cache->empty_count];
+    } else {
+        magazine_drain_to_pool(cache, mt->previous);
+        Magazine* tmp = mt->loaded;
+        mt->loaded = mt->previous;
+        mt->previous = tmp;
+    }
+    pthread_mutex_unlock(&cache->depot_lock);
+
+    mt->loaded->slots[mt->loaded->rounds++] = block;
+}
+
+void mag_thread_flush(MagazineCache* cache) {
+    MagThread* mt = (MagThread*)pthread_getspecific(cache->key);
+    if (!mt) return;
+    pthread_setspecific(cache->key, NULL);
+    mag_thread_release(mt);
+}
+
+void mag_destroy(MagazineCache* cache) {
+    if (!cache) return;
+    mag_thread_flush(cache);
+    pthread_key_delete(cache->key);
+
+    // Вернуть блоки из полных магазинов депо в пул
+    pthread_mutex_lock(&cache->depot_lock);
+    for (size_t i = 0; i < cache->full_count; ++i) {
+        magazine_drain_to_pool(cache, cache->full[i]);
+        free(cache->full[i]);
+    }
+    for (size_t i = 0; i < cache->empty_count; ++i) {
+        free(cache->empty[i]);
+    }
+    pthread_mutex_unlock(&cache->depot_lock);
+
+    pthread_mutex_destroy(&cache->depot_lock);
+    free(cache->full);
+    free(cache->empty);
+    free(cache);
+}
@@ -0,0 +1,81 @@
+#ifndef MAGAZINE_H
+#define MAGAZINE_H
+
+#include <stddef.h>
+#include "mempool.h"
+
+/*
+ * Слой "магазинов" (per-thread magazine cache) поверх MemoryPool.
+ *
+ * У каждого потока есть два небольших стека блоков (текущий и предыдущий
+ * магазин). Большинство mag_alloc/mag_free работают только с ними и не
+ * касаются разделяемой памяти. Когда оба магазина пусты (или полны), поток
+ * обменивает магазин целиком в общем депо под мьютексом; если в депо нет
+ * подходящего магазина, блоки пачкой берутся из пула или возвращаются в него.
+ */
+
+typedef struct MagazineCache MagazineCache;
+
+/**
+ * @brief Создает кэш магазинов поверх существующего пула.
+ * 
+ * Пул остается во владении вызывающего кода, но все обращения к нему
+ * должны идти через кэш: депо обращается к пулу под своим мьютексом,
+ * поэтому подходит и обычный пул из pool_create().
+ * 
+ * @param pool Пул, из которого берутся блоки.
+ * @param magazine_size Емкость одного магазина (число блоков).
+ * @param depot_magazines Число магазинов в общем депо.
+ * @return Указатель на кэш или NULL в случае ошибки.
+ */
+MagazineCache* mag_create(MemoryPool* pool, size_t magazine_size, size_t depot_magazines);
+
+/**
+ * @brief Выделяет блок, по возможности из магазина текущего потока.
+ * 
+ * Первый вызов в потоке выделяет его магазины через malloc; RT-потокам
+ * стоит сделать это заранее с помощью mag_thread_init().
+ * 
+ * @param cache Указатель на кэш.
+ * @return Указатель на блок или NULL, если блоки закончились.
+ */
+void* mag_alloc(MagazineCache* cache);
+
+/**
+ * @brief Возвращает блок в магазин текущего потока.
+ * 
+ * Блок может быть выделен любым потоком, использующим этот же кэш.
+ * 
+ * @param cache Указатель на кэш.
+ * @param block Указатель на блок.
+ */
+void mag_free(MagazineCache* cache, void* block);
+
+/**
+ * @brief Заранее создает магазины текущего потока.
+ * 
+ * @param cache Указатель на кэш.
+ * @return 0 при успехе, -1 при нехватке памяти.
+ */
+int mag_thread_init(MagazineCache* cache);
+
+/**
+ * @brief Возвращает блоки из магазинов текущего потока обратно в пул.
+ * 
+ * Вызывается автоматически при завершении потока.
+ * 
+ * @param cache Указатель на кэш.
+ */
+void mag_thread_flush(MagazineCache* cache);
+
+/**
+ * @brief Уничтожает кэш, возвращая все блоки из депо в пул.
+ * 
+ * Остальные потоки к этому моменту должны завершиться или вызвать
+ * mag_thread_flush().
+ * 
+ * @param cache Указатель на кэш.
+ */
+void mag_destroy(MagazineCache* cache);
+
+#endif // MAGAZINE_H
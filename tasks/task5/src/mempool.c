@@ -1,24 +1,331 @@
 #include "mempool.h"
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+// Per-CPU кэши используют rseq, зарегистрированный glibc (2.35+), и
+// критические секции на ассемблере x86_64
+#if defined(__x86_64__) && defined(__has_include)
+#if __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#define POOL_HAVE_RSEQ 1
+#endif
+#endif
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23 // Linux 5.14+, в старых заголовках может отсутствовать
+#endif
+
+#define POOL_HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+#define POOL_CACHE_LINE 64
+#define POOL_PERCPU_CACHE_BLOCKS 64
 
 // Узел в связном списке свободных блоков
 typedef struct Node {
     struct Node* next;
 } Node;
 
+// Голова lock-free списка: [поколение:32 | индекс блока:32].
+// Поколение увеличивается при каждой успешной операции, поэтому CAS
+// со "старой" головой не пройдет, даже если тот же блок снова оказался
+// на вершине стека (ABA).
+#define POOL_NIL UINT32_MAX
+#define HEAD_INDEX(h) ((uint32_t)(h))
+#define HEAD_TAG(h) ((uint32_t)((h) >> 32))
+#define HEAD_MAKE(tag, idx) (((uint64_t)(tag) << 32) | (uint32_t)(idx))
+
+// Состояние растущего пула. Адресное пространство под max_blocks
+// резервируется сразу (PROT_NONE), фоновый поток открывает в нем
+// следующие куски, поэтому индекс блока по-прежнему вычисляется от
+// memory_start, а pool_alloc никогда не вызывает mmap/malloc.
+typedef struct PoolElastic {
+    PoolElasticConfig config;
+    _Atomic long free_count;
+    _Atomic long min_free_count;
+    _Atomic unsigned long refills;
+    _Atomic unsigned long waited_allocs;
+    _Atomic unsigned long failed_allocs;
+    _Atomic int refill_requested;
+    _Atomic int waiters;
+    _Atomic int stopping;
+    sem_t need_refill;  // RT-потоки -> фоновый поток
+    sem_t refilled;     // фоновый поток -> ожидающие pool_alloc
+    pthread_t refiller;
+} PoolElastic;
+
+// Учет и проверки для пулов с POOL_CHECKED. На горячем пути только байт
+// владения блока (1 — выдан): у каждого блока свой байт, поэтому выдача —
+// обычная запись, а освобождение — один xchg даже в concurrent-режиме.
+// Число выданных блоков считает pool_get_stats() по этим байтам. Максимум
+// берется из нижней точки списка свободных блоков: стек LIFO отдает еще не
+// выдававшиеся блоки по порядку индексов и доходит до нового, только когда
+// все уже побывавшие в работе блоки выданы. Поэтому число блоков, которые
+// хоть раз выдавались (touched), и есть максимум одновременно выданных.
+typedef struct PoolChecks {
+    _Atomic unsigned char* owned;
+    size_t capacity;
+    int block_shift;   // log2(block_size), если размер блока — степень двойки, иначе -1
+    _Atomic size_t touched;
+    // Пишутся только на ошибках
+    _Atomic unsigned long alloc_failures;
+    _Atomic unsigned long double_frees;
+    _Atomic unsigned long foreign_frees;
+} PoolChecks;
+
+// Список свободных блоков одного процессора: слово [число блоков:32 |
+// индекс вершины:32] меняется одной записью в конце секции rseq
+typedef struct PoolCpuList {
+    uint64_t word;
+    char pad[POOL_CACHE_LINE - sizeof(uint64_t)];
+} PoolCpuList;
+
+typedef struct PoolPerCpu {
+    size_t cpu_count;
+    uint64_t cache_blocks;   // предел длины списка одного CPU
+    PoolCpuList* lists;
+} PoolPerCpu;
+
 // Структура, описывающая пул
 struct MemoryPool {
     size_t block_size;
     Node* free_list_head; 
     void* memory_start;    
     size_t memory_total_size;
+    _Atomic size_t block_count;   // В растущем пуле увеличивается фоновым потоком
+    int concurrent;
+    PoolBacking backing;
+    size_t mapping_size;          // Размер отображения для munmap (mmap-арены)
+    _Atomic uint64_t tagged_head; // Используется только в concurrent-режиме
+    PoolElastic* elastic;         // NULL, если пул не растущий
+    PoolChecks* checks;           // NULL, если пул создан без POOL_CHECKED
+    PoolPerCpu* percpu;           // NULL без POOL_PERCPU или без поддержки rseq
 };
 
-MemoryPool* pool_create(size_t block_size, size_t block_count) {
-    // Размер блока должен быть достаточным, чтобы вместить указатель Node
-    if (block_size < sizeof(Node)) {
-        block_size = sizeof(Node);
+static size_t round_up(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+// Прогнать арену через page faults сейчас, а не в RT-цикле
+static void arena_populate(void* start, size_t size) {
+    if (madvise(start, size, MADV_POPULATE_WRITE) == 0) return;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    for (size_t offset = 0; offset < size; offset += page_size) {
+        ((volatile char*)start)[offset] = 0;
+    }
+}
+
+// Отобразить арену через mmap с учетом флагов; при неудаче huge pages
+// откатывается к обычным страницам
+static void* arena_map(size_t size, unsigned flags, PoolBacking* backing, size_t* mapping_size) {
+    int populate = (flags & POOL_POPULATE) ? MAP_POPULATE : 0;
+    void* start;
+
+    if (flags & POOL_HUGETLB) {
+        size_t len = round_up(size, POOL_HUGE_PAGE_SIZE);
+        start = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+        if (start != MAP_FAILED) {
+            *backing = POOL_BACKING_HUGETLB;
+            *mapping_size = len;
+            return start;
+        }
+    }
+
+    if (flags & POOL_THP) {
+        // THP работает только для выровненных на 2 МБ участков: взять с запасом
+        // и обрезать края
+        size_t len = round_up(size, POOL_HUGE_PAGE_SIZE);
+        char* raw = (char*)mmap(NULL, len + POOL_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw != MAP_FAILED) {
+            char* aligned = (char*)round_up((size_t)raw, POOL_HUGE_PAGE_SIZE);
+            if (aligned > raw) munmap(raw, (size_t)(aligned - raw));
+            size_t tail = (size_t)(raw + len + POOL_HUGE_PAGE_SIZE - (aligned + len));
+            if (tail > 0) munmap(aligned + len, tail);
+
+            *backing = madvise(aligned, len, MADV_HUGEPAGE) == 0 ? POOL_BACKING_THP : POOL_BACKING_PAGES;
+            *mapping_size = len;
+            // MAP_POPULATE отработал бы до madvise и заполнил арену страницами по 4 КБ
+            if (flags & POOL_POPULATE) arena_populate(aligned, len);
+            return aligned;
+        }
+    }
+
+    size_t len = round_up(size, (size_t)sysconf(_SC_PAGESIZE));
+    start = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | populate, -1, 0);
+    if (start == MAP_FAILED) return NULL;
+    *backing = POOL_BACKING_PAGES;
+    *mapping_size = len;
+    return start;
+}
+
+// В concurrent-режиме первые 4 байта свободного блока хранят индекс следующего.
+// Чтение идет атомарно: блок может быть одновременно выдан другому потоку,
+// полученное значение тогда будет мусором, но CAS по голове его отбросит.
+static inline _Atomic uint32_t* block_next(MemoryPool* pool, uint32_t index) {
+    return (_Atomic uint32_t*)((char*)pool->memory_start + (size_t)index * pool->block_size);
+}
+
+// Разметить первые block_count блоков как связный список свободных блоков
+static void pool_init_free_list(MemoryPool* pool, size_t block_count) {
+    pool->free_list_head = NULL;
+    if (pool->concurrent) {
+        // Список на индексах: 0 -> 1 -> ... -> NIL
+        for (size_t i = 0; i < block_count; ++i) {
+            uint32_t next = (i + 1 < block_count) ? (uint32_t)(i + 1) : POOL_NIL;
+            atomic_store_explicit(block_next(pool, (uint32_t)i), next, memory_order_relaxed);
+        }
+        atomic_init(&pool->tagged_head, HEAD_MAKE(0, block_count ? 0 : POOL_NIL));
+        return;
+    }
+    for (size_t i = 0; i < block_count; ++i) {
+        Node* current_node = (Node*)((char*)pool->memory_start + i * pool->block_size);
+        current_node->next = pool->free_list_head;
+        pool->free_list_head = current_node;
+    }
+}
+
+// --- Учет и проверки (POOL_CHECKED) ---
+
+static int pool_checks_init(MemoryPool* pool, size_t max_blocks) {
+#ifdef MEMPOOL_NO_CHECKS
+    (void)pool;
+    (void)max_blocks;
+    return 0;
+#else
+    PoolChecks* checks = (PoolChecks*)calloc(1, sizeof(PoolChecks));
+    if (!checks) return -1;
+    checks->capacity = max_blocks;
+    checks->owned = (_Atomic unsigned char*)calloc(max_blocks ? max_blocks : 1, 1);
+    if (!checks->owned) {
+        free(checks);
+        return -1;
+    }
+    // Байты владения тоже должны быть в RAM: их трогает каждый alloc/free
+    mlock((void*)checks->owned, max_blocks);
+    // Деление на каждом вызове заметно дороже сдвига
+    checks->block_shift = -1;
+    if ((pool->block_size & (pool->block_size - 1)) == 0) {
+        checks->block_shift = 0;
+        while (((size_t)1 << checks->block_shift) < pool->block_size) checks->block_shift++;
+    }
+    pool->checks = checks;
+    return 0;
+#endif
+}
+
+static inline void checks_count(MemoryPool* pool, _Atomic unsigned long* counter) {
+    if (pool->concurrent) {
+        atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+    } else {
+        atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+    }
+}
+
+static inline size_t checks_index(MemoryPool* pool, size_t offset) {
+    int shift = pool->checks->block_shift;
+    return shift >= 0 ? offset >> shift : offset / pool->block_size;
+}
+
+// Первый выдаваемый блок — вершина исходного списка: в обычном пуле это
+// последний блок арены, в concurrent-режиме первый
+static inline size_t checks_depth(MemoryPool* pool, size_t index) {
+    return pool->concurrent ? index + 1 : pool->checks->capacity - index;
+}
+
+static void pool_check_alloc(MemoryPool* pool, void* block) {
+    PoolChecks* checks = pool->checks;
+    if (!block) {
+        checks_count(pool, &checks->alloc_failures);
+        return;
+    }
+    size_t index = checks_index(pool, (size_t)((char*)block - (char*)pool->memory_start));
+    // Блок принадлежит только этому потоку, соседние байты — чужим блокам
+    atomic_store_explicit(&checks->owned[index], 1, memory_order_relaxed);
+
+    // Запись только при первой выдаче блока, не чаще capacity раз за жизнь пула
+    size_t depth = checks_depth(pool, index);
+    size_t touched = atomic_load_explicit(&checks->touched, memory_order_relaxed);
+    if (depth <= touched) return;
+    if (!pool->concurrent) {
+        atomic_store_explicit(&checks->touched, depth, memory_order_relaxed);
+        return;
+    }
+    while (depth > touched && !atomic_compare_exchange_weak_explicit(&checks->touched, &touched, depth,
+                                                                     memory_order_relaxed,
+                                                                     memory_order_relaxed)) {
+    }
+}
+
+// Возвращает 1, если блок можно вернуть в список
+static int pool_check_free(MemoryPool* pool, void* block) {
+    PoolChecks* checks = pool->checks;
+    size_t capacity = atomic_load_explicit(&pool->block_count, memory_order_relaxed);
+    char* start = (char*)pool->memory_start;
+    size_t offset = (size_t)((char*)block - start);
+    size_t index = checks_index(pool, offset);
+    if ((char*)block < start || index >= capacity || index * pool->block_size != offset) {
+        checks_count(pool, &checks->foreign_frees);
+        return 0;
+    }
+
+    // Из двух потоков, одновременно освобождающих блок, 1 увидит только один
+    unsigned char was_owned;
+    if (pool->concurrent) {
+        was_owned = atomic_exchange_explicit(&checks->owned[index], 0, memory_order_relaxed);
+    } else {
+        was_owned = atomic_load_explicit(&checks->owned[index], memory_order_relaxed);
+        atomic_store_explicit(&checks->owned[index], 0, memory_order_relaxed);
+    }
+    if (!was_owned) {
+        checks_count(pool, &checks->double_frees);
+        return 0;
+    }
+    return 1;
+}
+
+int pool_get_stats(const MemoryPool* pool, PoolStats* stats) {
+    if (!pool || !pool->checks || !stats) return -1;
+    PoolChecks* checks = pool->checks;
+    stats->capacity = atomic_load(&((MemoryPool*)pool)->block_count);
+    // Снимок не атомарен: при параллельных alloc/free live может
+    // разойтись с реальным на число операций, прошедших за время обхода
+    size_t live = 0;
+    for (size_t i = 0; i < stats->capacity; ++i) {
+        live += atomic_load_explicit(&checks->owned[i], memory_order_relaxed);
+    }
+    stats->live = live;
+    stats->high_water = atomic_load(&checks->touched);
+    stats->alloc_failures = atomic_load(&checks->alloc_failures);
+    stats->double_frees = atomic_load(&checks->double_frees);
+    stats->foreign_frees = atomic_load(&checks->foreign_frees);
+    return 0;
+}
+
+static int pool_percpu_init(MemoryPool* pool, size_t block_count);
+
+static MemoryPool* pool_create_common(void* buffer, size_t block_size, size_t block_count,
+                                      unsigned flags) {
+    int concurrent = (flags & (POOL_CONCURRENT | POOL_PERCPU)) != 0;
+
+    // Блок должен вмещать Node, а его размер — быть кратным sizeof(void*):
+    // иначе указатели и атомарные индексы списка в блоках не выровнены
+    size_t rounded = block_size < sizeof(Node) ? sizeof(Node) : round_up(block_size, sizeof(Node));
+    if (rounded != block_size) {
+        // Чужой буфер уже размечен под block_size, расширить блок нельзя
+        if (buffer) return NULL;
+        block_size = rounded;
+    }
+    if (concurrent && block_count >= POOL_NIL) {
+        return NULL;
     }
 
     // Выделить память для самой структуры пула
@@ -26,32 +333,570 @@ MemoryPool* pool_create(size_t block_size, size_t block_count) {
     if (!pool) return NULL;
 
     pool->block_size = block_size;
+    atomic_init(&pool->block_count, block_count);
+    pool->concurrent = concurrent;
     pool->memory_total_size = block_size * block_count;
+    pool->mapping_size = 0;
+    pool->elastic = NULL;
+    pool->checks = NULL;
+    pool->percpu = NULL;
 
-    // Выделить один большой кусок памяти для всех блоков
-    pool->memory_start = malloc(pool->memory_total_size);
-    if (!pool->memory_start) {
-        free(pool);
+    if (buffer) {
+        pool->memory_start = buffer;
+        pool->backing = POOL_BACKING_EXTERNAL;
+    } else if (flags & (POOL_HUGETLB | POOL_THP | POOL_POPULATE)) {
+        pool->memory_start = arena_map(pool->memory_total_size, flags, &pool->backing,
+                                       &pool->mapping_size);
+        if (!pool->memory_start) {
+            free(pool);
+            return NULL;
+        }
+        mlock(pool->memory_start, pool->mapping_size);
+    } else {
+        pool->backing = POOL_BACKING_MALLOC;
+        // Выделить один большой кусок памяти для всех блоков
+        pool->memory_start = malloc(pool->memory_total_size);
+        if (!pool->memory_start) {
+            free(pool);
+            return NULL;
+        }
+
+        // Заблокировать выделенную память в RAM
+        mlock(pool->memory_start, pool->memory_total_size);
+    }
+
+    pool_init_free_list(pool, block_count);
+    if ((flags & POOL_PERCPU) && pool_percpu_init(pool, block_count) != 0) {
+        pool_destroy(pool);
         return NULL;
     }
+    if ((flags & POOL_CHECKED) && pool_checks_init(pool, block_count) != 0) {
+        pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
 
-    // Заблокировать выделенную память в RAM
-    mlock(pool->memory_start, pool->memory_total_size);
+MemoryPool* pool_create(size_t block_size, size_t block_count) {
+    return pool_create_common(NULL, block_size, block_count, 0);
+}
 
-    // Разметить память как связный список свободных блоков
-    pool->free_list_head = NULL;
-    for (size_t i = 0; i < block_count; ++i) {
-        Node* current_node = (Node*)((char*)pool->memory_start + i * block_size);
-        current_node->next = pool->free_list_head;
-        pool->free_list_head = current_node;
+MemoryPool* pool_create_concurrent(size_t block_size, size_t block_count) {
+    return pool_create_common(NULL, block_size, block_count, POOL_CONCURRENT);
+}
+
+MemoryPool* pool_create_in_buffer(void* buffer, size_t block_size, size_t block_count, unsigned flags) {
+    if (!buffer) return NULL;
+    return pool_create_common(buffer, block_size, block_count, flags);
+}
+
+MemoryPool* pool_create_ex(size_t block_size, size_t block_count, unsigned flags) {
+    return pool_create_common(NULL, block_size, block_count, flags);
+}
+
+PoolBacking pool_backing(const MemoryPool* pool) {
+    return pool->backing;
+}
+
+size_t pool_block_size(const MemoryPool* pool) {
+    return pool->block_size;
+}
+
+void* pool_block_at(const MemoryPool* pool, size_t index) {
+    return (char*)pool->memory_start + index * pool->block_size;
+}
+
+size_t pool_block_index(const MemoryPool* pool, const void* block) {
+    return (size_t)((const char*)block - (const char*)pool->memory_start) / pool->block_size;
+}
+
+static void* pool_alloc_concurrent(MemoryPool* pool) {
+    uint64_t head = atomic_load_explicit(&pool->tagged_head, memory_order_acquire);
+    for (;;) {
+        uint32_t index = HEAD_INDEX(head);
+        if (index == POOL_NIL) {
+            return NULL;
+        }
+        uint32_t next = atomic_load_explicit(block_next(pool, index), memory_order_relaxed);
+        uint64_t new_head = HEAD_MAKE(HEAD_TAG(head) + 1, next);
+        if (atomic_compare_exchange_weak_explicit(&pool->tagged_head, &head, new_head,
+                                                  memory_order_acquire, memory_order_acquire)) {
+            return (char*)pool->memory_start + (size_t)index * pool->block_size;
+        }
+    }
+}
+
+static inline uint32_t block_index(MemoryPool* pool, void* block) {
+    return (uint32_t)(((char*)block - (char*)pool->memory_start) / pool->block_size);
+}
+
+static void pool_free_concurrent(MemoryPool* pool, void* block) {
+    uint32_t index = block_index(pool, block);
+    uint64_t head = atomic_load_explicit(&pool->tagged_head, memory_order_relaxed);
+    uint64_t new_head;
+    do {
+        atomic_store_explicit(block_next(pool, index), HEAD_INDEX(head), memory_order_relaxed);
+        new_head = HEAD_MAKE(HEAD_TAG(head) + 1, index);
+    } while (!atomic_compare_exchange_weak_explicit(&pool->tagged_head, &head, new_head,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+// Снять с вершины стека цепочку до n блоков одним CAS
+static size_t pool_alloc_bulk_concurrent(MemoryPool* pool, void** out, size_t n) {
+    uint64_t head = atomic_load_explicit(&pool->tagged_head, memory_order_acquire);
+    for (;;) {
+        uint32_t index = HEAD_INDEX(head);
+        size_t count = 0;
+        int stale = 0;
+        while (count < n && index != POOL_NIL) {
+            // Пока цепочка не снята, ее блоки может забрать другой поток, и
+            // next окажется мусором: такой индекс нельзя разыменовывать
+            if (index >= atomic_load_explicit(&pool->block_count, memory_order_relaxed)) {
+                stale = 1;
+                break;
+            }
+            out[count++] = (char*)pool->memory_start + (size_t)index * pool->block_size;
+            index = atomic_load_explicit(block_next(pool, index), memory_order_relaxed);
+        }
+        if (stale) {
+            head = atomic_load_explicit(&pool->tagged_head, memory_order_acquire);
+            continue;
+        }
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t new_head = HEAD_MAKE(HEAD_TAG(head) + 1, index);
+        if (atomic_compare_exchange_weak_explicit(&pool->tagged_head, &head, new_head,
+                                                  memory_order_acquire, memory_order_acquire)) {
+            return count;
+        }
     }
+}
+
+// Положить заранее связанную цепочку first..last на вершину стека одним CAS
+static void pool_push_chain(MemoryPool* pool, uint32_t first, uint32_t last) {
+    uint64_t head = atomic_load_explicit(&pool->tagged_head, memory_order_relaxed);
+    uint64_t new_head;
+    do {
+        atomic_store_explicit(block_next(pool, last), HEAD_INDEX(head), memory_order_relaxed);
+        new_head = HEAD_MAKE(HEAD_TAG(head) + 1, first);
+    } while (!atomic_compare_exchange_weak_explicit(&pool->tagged_head, &head, new_head,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+static void pool_free_bulk_concurrent(MemoryPool* pool, void** in, size_t n) {
+    for (size_t i = 0; i + 1 < n; ++i) {
+        atomic_store_explicit(block_next(pool, block_index(pool, in[i])),
+                              block_index(pool, in[i + 1]), memory_order_relaxed);
+    }
+    pool_push_chain(pool, block_index(pool, in[0]), block_index(pool, in[n - 1]));
+}
+
+// --- Per-CPU кэши (rseq) ---
+
+#ifdef POOL_HAVE_RSEQ
+
+static inline struct rseq* rseq_area(void) {
+    return (struct rseq*)((char*)__builtin_thread_pointer() + __rseq_offset);
+}
+
+// Дескриптор критической секции: начало (1), длина до точки фиксации (2)
+// и обработчик прерывания (4), перед которым стоит подпись RSEQ_SIG.
+// Ядро переводит поток на 4, если его вытеснили, прервали сигналом или
+// перенесли на другой CPU между 1 и 2.
+#define POOL_RSEQ_CS_BEGIN                                  \
+    ".pushsection __rseq_cs, \"aw\"\n\t"                   \
+    ".balign 32\n\t"                                        \
+    "3:\n\t"                                                \
+    ".long 0x0, 0x0\n\t"                                    \
+    ".quad 1f, (2f - 1f), 4f\n\t"                           \
+    ".popsection\n\t"                                       \
+    "leaq 3b(%%rip), %%rax\n\t"                             \
+    "movq %%rax, %[rseq_cs]\n\t"                            \
+    "1:\n\t"                                                \
+    "cmpl %[cpu], %[cpu_id]\n\t"                            \
+    "jnz 4f\n\t"
+
+#define POOL_RSEQ_CS_END                                    \
+    "2:\n\t"                                                \
+    ".pushsection __rseq_failure, \"ax\"\n\t"              \
+    ".long 0x53053053\n\t"                                  \
+    "4:\n\t"                                                \
+    "jmp %l[aborted]\n\t"                                   \
+    ".popsection\n\t"
+
+// Снять вершину списка CPU cpu. 0 — индекс блока в *out, 1 — список пуст,
+// -1 — секция прервана (повторить)
+static inline int percpu_pop(MemoryPool* pool, struct rseq* rs, int cpu, uint32_t* out) {
+    uint64_t* word = &pool->percpu->lists[cpu].word;
+    __asm__ goto(
+        POOL_RSEQ_CS_BEGIN
+        "movq (%[word]), %%rax\n\t"
+        "cmpl $0xffffffff, %%eax\n\t"
+        "je %l[empty]\n\t"
+        "movl %%eax, %%edx\n\t"
+        "imulq %[block_size], %%rdx\n\t"
+        "movl (%[base], %%rdx), %%edx\n\t"   // индекс следующего блока
+        "movl %%eax, (%[out])\n\t"
+        "shrq $32, %%rax\n\t"
+        "decq %%rax\n\t"
+        "shlq $32, %%rax\n\t"
+        "orq %%rdx, %%rax\n\t"
+        "movq %%rax, (%[word])\n\t"          // фиксация
+        POOL_RSEQ_CS_END
+        :
+        : [cpu_id] "m"(rs->cpu_id), [rseq_cs] "m"(rs->rseq_cs), [cpu] "r"(cpu),
+          [word] "r"(word), [block_size] "r"(pool->block_size), [base] "r"(pool->memory_start),
+          [out] "r"(out)
+        : "rax", "rdx", "memory", "cc"
+        : empty, aborted);
+    return 0;
+empty:
+    return 1;
+aborted:
+    return -1;
+}
+
+// Положить блок index на вершину списка CPU cpu. 0 — готово,
+// 1 — список полон, -1 — секция прервана (повторить)
+static inline int percpu_push(MemoryPool* pool, struct rseq* rs, int cpu, uint64_t index, void* block) {
+    uint64_t* word = &pool->percpu->lists[cpu].word;
+    __asm__ goto(
+        POOL_RSEQ_CS_BEGIN
+        "movq (%[word]), %%rax\n\t"
+        "movq %%rax, %%rdx\n\t"
+        "shrq $32, %%rdx\n\t"
+        "cmpq %[cache_blocks], %%rdx\n\t"
+        "jae %l[full]\n\t"
+        "movl %%eax, (%[block])\n\t"         // next = старая вершина
+        "incq %%rdx\n\t"
+        "shlq $32, %%rdx\n\t"
+        "orq %[index], %%rdx\n\t"
+        "movq %%rdx, (%[word])\n\t"          // фиксация
+        POOL_RSEQ_CS_END
+        :
+        : [cpu_id] "m"(rs->cpu_id), [rseq_cs] "m"(rs->rseq_cs), [cpu] "r"(cpu),
+          [word] "r"(word), [cache_blocks] "r"(pool->percpu->cache_blocks), [index] "r"(index),
+          [block] "r"(block)
+        : "rax", "rdx", "memory", "cc"
+        : full, aborted);
+    return 0;
+full:
+    return 1;
+aborted:
+    return -1;
+}
+
+// Текущий CPU потока или -1, если rseq для потока не зарегистрирован
+static inline int percpu_current_cpu(MemoryPool* pool, struct rseq* rs) {
+    int cpu = (int)__atomic_load_n(&rs->cpu_id, __ATOMIC_RELAXED);
+    return (cpu >= 0 && (size_t)cpu < pool->percpu->cpu_count) ? cpu : -1;
+}
+
+static void* pool_alloc_percpu(MemoryPool* pool) {
+    struct rseq* rs = rseq_area();
+    int cpu;
+    while ((cpu = percpu_current_cpu(pool, rs)) >= 0) {
+        uint32_t index;
+        int rc = percpu_pop(pool, rs, cpu, &index);
+        if (rc == 0) return (char*)pool->memory_start + (size_t)index * pool->block_size;
+        if (rc > 0) break;
+    }
+    return pool_alloc_concurrent(pool);
+}
+
+static void pool_free_percpu(MemoryPool* pool, void* block) {
+    struct rseq* rs = rseq_area();
+    int cpu;
+    while ((cpu = percpu_current_cpu(pool, rs)) >= 0) {
+        int rc = percpu_push(pool, rs, cpu, block_index(pool, block), block);
+        if (rc == 0) return;
+        if (rc > 0) break;
+    }
+    pool_free_concurrent(pool, block);
+}
+
+#endif // POOL_HAVE_RSEQ
+
+static int pool_percpu_init(MemoryPool* pool, size_t block_count) {
+#ifdef POOL_HAVE_RSEQ
+    // glibc не зарегистрировал rseq (отключен через GLIBC_TUNABLES или
+    // не поддерживается ядром): остается обычный concurrent-пул
+    if (__rseq_size == 0 || (int)rseq_area()->cpu_id < 0) return 0;
+
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    if (cpus <= 0) return 0;
+    PoolPerCpu* percpu = (PoolPerCpu*)malloc(sizeof(PoolPerCpu));
+    if (!percpu) return -1;
+    percpu->lists = (PoolCpuList*)aligned_alloc(POOL_CACHE_LINE, (size_t)cpus * sizeof(PoolCpuList));
+    if (!percpu->lists) {
+        free(percpu);
+        return -1;
+    }
+    mlock(percpu->lists, (size_t)cpus * sizeof(PoolCpuList));
+    for (long i = 0; i < cpus; ++i) {
+        percpu->lists[i].word = POOL_NIL; // пустой список, 0 блоков
+    }
+    // Не больше половины пула на все кэши, чтобы блоки не застревали у CPU
+    size_t share = block_count / (2 * (size_t)cpus);
+    percpu->cache_blocks = share < POOL_PERCPU_CACHE_BLOCKS ? share : POOL_PERCPU_CACHE_BLOCKS;
+    percpu->cpu_count = (size_t)cpus;
+    pool->percpu = percpu;
+#else
+    (void)pool;
+    (void)block_count;
+#endif
+    return 0;
+}
+
+// --- Растущий пул ---
+
+static void elastic_request_refill(PoolElastic* e) {
+    // sem_post только на переходе 0 -> 1, чтобы не будить поток на каждом вызове
+    if (!atomic_exchange_explicit(&e->refill_requested, 1, memory_order_acq_rel)) {
+        sem_post(&e->need_refill);
+    }
+}
+
+// Учесть n выданных блоков: минимум свободных и проверка порога
+static void elastic_note_taken(PoolElastic* e, size_t n) {
+    long left = atomic_fetch_sub_explicit(&e->free_count, (long)n, memory_order_relaxed) - (long)n;
+    long min = atomic_load_explicit(&e->min_free_count, memory_order_relaxed);
+    while (left < min && !atomic_compare_exchange_weak_explicit(&e->min_free_count, &min, left,
+                                                                memory_order_relaxed,
+                                                                memory_order_relaxed)) {
+    }
+    if (left < (long)e->config.low_watermark) {
+        elastic_request_refill(e);
+    }
+}
+
+static void elastic_note_returned(PoolElastic* e, size_t n) {
+    atomic_fetch_add_explicit(&e->free_count, (long)n, memory_order_relaxed);
+}
+
+// Сделать блоки [first, first + count) доступными: открыть страницы,
+// прогнать page faults и заблокировать их в RAM
+static int elastic_commit(MemoryPool* pool, size_t first, size_t count) {
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t begin = first * pool->block_size / page_size * page_size;
+    size_t end = round_up((first + count) * pool->block_size, page_size);
+    char* start = (char*)pool->memory_start + begin;
+    if (mprotect(start, end - begin, PROT_READ | PROT_WRITE) != 0) return -1;
+    // Первая страница может быть общей с прошлым куском: она уже открыта и
+    // прогрета, а запасной путь arena_populate пишет в нее нули поверх
+    // живых блоков. Прогреваются только страницы целиком нового куска
+    size_t owned = round_up(first * pool->block_size, page_size);
+    if (owned < end) {
+        arena_populate((char*)pool->memory_start + owned, end - owned);
+        mlock((char*)pool->memory_start + owned, end - owned);
+    }
+    return 0;
+}
+
+// Вызывается только фоновым потоком
+static int elastic_grow(MemoryPool* pool) {
+    PoolElastic* e = pool->elastic;
+    size_t first = atomic_load_explicit(&pool->block_count, memory_order_relaxed);
+    if (first >= e->config.max_blocks) return -1;
+    size_t count = e->config.chunk_blocks;
+    if (count > e->config.max_blocks - first) count = e->config.max_blocks - first;
+    if (elastic_commit(pool, first, count) != 0) return -1;
+
+    for (size_t i = first; i + 1 < first + count; ++i) {
+        atomic_store_explicit(block_next(pool, (uint32_t)i), (uint32_t)(i + 1), memory_order_relaxed);
+    }
+    // Новая граница публикуется раньше самих блоков: pool_alloc_bulk
+    // проверяет по ней индексы из списка
+    atomic_store_explicit(&pool->block_count, first + count, memory_order_release);
+    pool_push_chain(pool, (uint32_t)first, (uint32_t)(first + count - 1));
+
+    elastic_note_returned(e, count);
+    atomic_fetch_add_explicit(&e->refills, 1, memory_order_relaxed);
+    return 0;
+}
+
+static void* elastic_refiller(void* arg) {
+    MemoryPool* pool = (MemoryPool*)arg;
+    PoolElastic* e = pool->elastic;
+    for (;;) {
+        while (sem_wait(&e->need_refill) != 0 && errno == EINTR) {
+        }
+        if (atomic_load(&e->stopping)) break;
+        atomic_store(&e->refill_requested, 0);
+
+        while (atomic_load_explicit(&e->free_count, memory_order_relaxed) <
+               (long)e->config.low_watermark) {
+            if (elastic_grow(pool) != 0) break;
+        }
+
+        // Разбудить тех, кто ждет в pool_alloc на пустом пуле: каждый
+        // sem_post забирает одну регистрацию, поэтому лишних не остается
+        for (int i = atomic_exchange(&e->waiters, 0); i > 0; --i) {
+            sem_post(&e->refilled);
+        }
+    }
+    return NULL;
+}
+
+// Снять регистрацию ожидающего, который не получил sem_post. Если фоновый
+// поток уже забрал регистрацию, sem_post для нее сделан или вот-вот будет
+// сделан: его нужно поглотить, иначе он впустую разбудит следующего
+static void elastic_leave(PoolElastic* e) {
+    int n = atomic_load(&e->waiters);
+    while (n > 0 && !atomic_compare_exchange_weak(&e->waiters, &n, n - 1)) {
+    }
+    if (n == 0) {
+        while (sem_wait(&e->refilled) != 0 && errno == EINTR) {
+        }
+    }
+}
+
+// Медленный путь pool_alloc на пустом растущем пуле
+static void* elastic_wait_alloc(MemoryPool* pool) {
+    PoolElastic* e = pool->elastic;
+    elastic_request_refill(e);
+    if (e->config.max_wait_ns <= 0) {
+        atomic_fetch_add_explicit(&e->failed_allocs, 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    atomic_fetch_add_explicit(&e->waited_allocs, 1, memory_order_relaxed);
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += e->config.max_wait_ns / 1000000000L;
+    deadline.tv_nsec += e->config.max_wait_ns % 1000000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    // Каждая регистрация в waiters заканчивается ровно одним из двух:
+    // ожидающий поглощает sem_post или снимает ее в elastic_leave()
+    void* block = NULL;
+    while (!block) {
+        atomic_fetch_add(&e->waiters, 1);
+        // Пополнение могло закончиться до регистрации
+        block = pool_alloc_concurrent(pool);
+        if (block) {
+            elastic_leave(e);
+            break;
+        }
+        int rc;
+        while ((rc = sem_clockwait(&e->refilled, CLOCK_MONOTONIC, &deadline)) != 0 && errno == EINTR) {
+        }
+        if (rc != 0) {
+            elastic_leave(e);
+            block = pool_alloc_concurrent(pool);
+            break;
+        }
+        block = pool_alloc_concurrent(pool);
+    }
+    if (!block) atomic_fetch_add_explicit(&e->failed_allocs, 1, memory_order_relaxed);
+    return block;
+}
+
+static void* pool_alloc_elastic(MemoryPool* pool) {
+    void* block = pool_alloc_concurrent(pool);
+    if (!block) block = elastic_wait_alloc(pool);
+    if (block) elastic_note_taken(pool->elastic, 1);
+    return block;
+}
+
+MemoryPool* pool_create_elastic(size_t block_size, const PoolElasticConfig* config) {
+    if (!config || config->chunk_blocks == 0 || config->initial_blocks == 0 ||
+        config->initial_blocks > config->max_blocks || config->max_blocks >= POOL_NIL) {
+        return NULL;
+    }
+    block_size = block_size < sizeof(Node) ? sizeof(Node) : round_up(block_size, sizeof(Node));
+
+    MemoryPool* pool = (MemoryPool*)calloc(1, sizeof(MemoryPool));
+    PoolElastic* e = (PoolElastic*)calloc(1, sizeof(PoolElastic));
+    if (!pool || !e) {
+        free(pool);
+        free(e);
+        return NULL;
+    }
+
+    // Зарезервировать адресное пространство под максимальный размер пула
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    pool->block_size = block_size;
+    pool->concurrent = 1;
+    pool->backing = POOL_BACKING_PAGES;
+    pool->memory_total_size = block_size * config->max_blocks;
+    pool->mapping_size = round_up(pool->memory_total_size, page_size);
+    pool->memory_start = mmap(NULL, pool->mapping_size, PROT_NONE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (pool->memory_start == MAP_FAILED) {
+        free(pool);
+        free(e);
+        return NULL;
+    }
+
+    e->config = *config;
+    atomic_init(&e->free_count, (long)config->initial_blocks);
+    atomic_init(&e->min_free_count, (long)config->initial_blocks);
+    sem_init(&e->need_refill, 0, 0);
+    sem_init(&e->refilled, 0, 0);
+    pool->elastic = e;
+
+    if (elastic_commit(pool, 0, config->initial_blocks) != 0) goto fail;
+    atomic_init(&pool->block_count, config->initial_blocks);
+    pool_init_free_list(pool, config->initial_blocks);
+    if ((config->flags & POOL_CHECKED) && pool_checks_init(pool, config->max_blocks) != 0) goto fail;
+
+    // Фоновый поток всегда SCHED_OTHER, даже если пул создает RT-поток
+    pthread_attr_t attr;
+    struct sched_param param = {.sched_priority = 0};
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    pthread_attr_setschedparam(&attr, &param);
+    int rc = pthread_create(&e->refiller, &attr, elastic_refiller, pool);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) goto fail;
 
     return pool;
+
+fail:
+    if (pool->checks) {
+        free((void*)pool->checks->owned);
+        free(pool->checks);
+    }
+    sem_destroy(&e->need_refill);
+    sem_destroy(&e->refilled);
+    munmap(pool->memory_start, pool->mapping_size);
+    free(e);
+    free(pool);
+    return NULL;
 }
 
-void* pool_alloc(MemoryPool* pool) {
+int pool_get_elastic_stats(const MemoryPool* pool, PoolElasticStats* stats) {
+    if (!pool || !pool->elastic || !stats) return -1;
+    PoolElastic* e = pool->elastic;
+    stats->capacity = atomic_load(&((MemoryPool*)pool)->block_count);
+    stats->free_blocks = atomic_load(&e->free_count);
+    stats->min_free_blocks = atomic_load(&e->min_free_count);
+    stats->refills = atomic_load(&e->refills);
+    stats->waited_allocs = atomic_load(&e->waited_allocs);
+    stats->failed_allocs = atomic_load(&e->failed_allocs);
+    return 0;
+}
+
+static inline void* pool_alloc_unchecked(MemoryPool* pool) {
+    if (pool->elastic) {
+        return pool_alloc_elastic(pool);
+    }
+#ifdef POOL_HAVE_RSEQ
+    if (pool->percpu) {
+        return pool_alloc_percpu(pool);
+    }
+#endif
+    if (pool->concurrent) {
+        return pool_alloc_concurrent(pool);
+    }
     // Извлечь первый свободный блок из списка
-    if (!pool || !pool->free_list_head) {
+    if (!pool->free_list_head) {
         return NULL;
     }
     Node* block_to_alloc = pool->free_list_head;
@@ -59,8 +904,31 @@ void* pool_alloc(MemoryPool* pool) {
     return (void*)block_to_alloc;
 }
 
+void* pool_alloc(MemoryPool* pool) {
+    if (!pool) return NULL;
+    void* block = pool_alloc_unchecked(pool);
+#ifndef MEMPOOL_NO_CHECKS
+    if (pool->checks) pool_check_alloc(pool, block);
+#endif
+    return block;
+}
+
 void pool_free(MemoryPool* pool, void* block) {
     if (!pool || !block) return;
+#ifndef MEMPOOL_NO_CHECKS
+    if (pool->checks && !pool_check_free(pool, block)) return;
+#endif
+#ifdef POOL_HAVE_RSEQ
+    if (pool->percpu) {
+        pool_free_percpu(pool, block);
+        return;
+    }
+#endif
+    if (pool->concurrent) {
+        pool_free_concurrent(pool, block);
+        if (pool->elastic) elastic_note_returned(pool->elastic, 1);
+        return;
+    }
 
     // Вернуть блок в начало списка свободных блоков
     Node* node_to_free = (Node*)block;
@@ -68,10 +936,87 @@ void pool_free(MemoryPool* pool, void* block) {
     pool->free_list_head = node_to_free;
 }
 
+static size_t pool_alloc_bulk_unchecked(MemoryPool* pool, void** out, size_t n) {
+    if (pool->concurrent) {
+        size_t count = pool_alloc_bulk_concurrent(pool, out, n);
+        if (pool->elastic) {
+            if (count < n) elastic_request_refill(pool->elastic);
+            if (count > 0) elastic_note_taken(pool->elastic, count);
+        }
+        return count;
+    }
+
+    // Пройти по списку n узлов и отрезать их одной записью головы
+    Node* node = pool->free_list_head;
+    size_t count = 0;
+    while (count < n && node) {
+        out[count++] = node;
+        node = node->next;
+    }
+    pool->free_list_head = node;
+    return count;
+}
+
+size_t pool_alloc_bulk(MemoryPool* pool, void** out, size_t n) {
+    if (!pool || !out || n == 0) return 0;
+    size_t count = pool_alloc_bulk_unchecked(pool, out, n);
+#ifndef MEMPOOL_NO_CHECKS
+    if (pool->checks) {
+        for (size_t i = 0; i < count; ++i) pool_check_alloc(pool, out[i]);
+        if (count < n) pool_check_alloc(pool, NULL);
+    }
+#endif
+    return count;
+}
+
+void pool_free_bulk(MemoryPool* pool, void** in, size_t n) {
+    if (!pool || !in || n == 0) return;
+#ifndef MEMPOOL_NO_CHECKS
+    // С проверками каждый блок проверяется и возвращается отдельно, чтобы
+    // ошибочный указатель из пачки не попал в список свободных блоков
+    if (pool->checks) {
+        for (size_t i = 0; i < n; ++i) pool_free(pool, in[i]);
+        return;
+    }
+#endif
+    if (pool->concurrent) {
+        pool_free_bulk_concurrent(pool, in, n);
+        if (pool->elastic) elastic_note_returned(pool->elastic, n);
+        return;
+    }
+
+    // Связать блоки между собой и присоединить цепочку к голове списка
+    for (size_t i = 0; i + 1 < n; ++i) {
+        ((Node*)in[i])->next = (Node*)in[i + 1];
+    }
+    ((Node*)in[n - 1])->next = pool->free_list_head;
+    pool->free_list_head = (Node*)in[0];
+}
+
 void pool_destroy(MemoryPool* pool) {
     if (!pool) return;
+    if (pool->elastic) {
+        atomic_store(&pool->elastic->stopping, 1);
+        sem_post(&pool->elastic->need_refill);
+        pthread_join(pool->elastic->refiller, NULL);
+        sem_destroy(&pool->elastic->need_refill);
+        sem_destroy(&pool->elastic->refilled);
+        free(pool->elastic);
+    }
+    if (pool->checks) {
+        free((void*)pool->checks->owned);
+        free(pool->checks);
+    }
+    if (pool->percpu) {
+        free(pool->percpu->lists);
+        free(pool->percpu);
+    }
     // Разблокировать и освободить всю память
-    munlock(pool->memory_start, pool->memory_total_size);
-    free(pool->memory_start);
+    if (pool->backing == POOL_BACKING_MALLOC) {
+        munlock(pool->memory_start, pool->memory_total_size);
+        free(pool->memory_start);
+    } else if (pool->backing != POOL_BACKING_EXTERNAL) {
+        munmap(pool->memory_start, pool->mapping_size); // munlock выполняется неявно
+    }
     free(pool);
 }
@@ -0,0 +1,69 @@
+#include "objpool.h"
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#define OBJ_GENERATION_MASK ((1u << OBJ_GENERATION_BITS) - 1)
+
+static inline ObjHandle make_handle(uint32_t index, uint32_t generation) {
+    return (generation << OBJ_INDEX_BITS) | index;
+}
+
+ObjectPool* obj_pool_create(size_t object_size, size_t capacity, unsigned flags,
+                            ObjCallback ctor, ObjCallback dtor, void* ctx) {
+    if (capacity == 0 || capacity > OBJ_MAX_OBJECTS) return NULL;
+
+    ObjectPool* objects = (ObjectPool*)calloc(1, sizeof(ObjectPool));
+    if (!objects) return NULL;
+
+    objects->pool = pool_create_ex(object_size, capacity, flags);
+    objects->generations = (uint16_t*)malloc(capacity * sizeof(uint16_t));
+    if (!objects->pool || !objects->generations) {
+        pool_destroy(objects->pool);
+        free(objects->generations);
+        free(objects);
+        return NULL;
+    }
+    mlock(objects->generations, capacity * sizeof(uint16_t));
+
+    // Поколение 0 зарезервировано, поэтому OBJ_HANDLE_NULL никогда не разрешится
+    for (size_t i = 0; i < capacity; ++i) {
+        objects->generations[i] = 1;
+    }
+    objects->base = (char*)pool_block_at(objects->pool, 0);
+    objects->object_size = pool_block_size(objects->pool);
+    objects->capacity = (uint32_t)capacity;
+    objects->ctor = ctor;
+    objects->dtor = dtor;
+    objects->ctx = ctx;
+    return objects;
+}
+
+ObjHandle obj_acquire(ObjectPool* pool) {
+    void* object = pool_alloc(pool->pool);
+    if (!object) return OBJ_HANDLE_NULL;
+
+    uint32_t index = (uint32_t)pool_block_index(pool->pool, object);
+    if (pool->ctor) pool->ctor(object, pool->ctx);
+    return make_handle(index, pool->generations[index]);
+}
+
+int obj_release(ObjectPool* pool, ObjHandle handle) {
+    void* object = obj_resolve(pool, handle);
+    if (!object) return -1;
+
+    uint32_t index = handle & OBJ_INDEX_MASK;
+    if (pool->dtor) pool->dtor(object, pool->ctx);
+
+    // Новое поколение делает все выданные ранее дескрипторы недействительными
+    uint32_t next = (pool->generations[index] + 1) & OBJ_GENERATION_MASK;
+    pool->generations[index] = (uint16_t)(next ? next : 1);
+    pool_free(pool->pool, object);
+    return 0;
+}
+
+void obj_pool_destroy(ObjectPool* pool) {
+    if (!pool) return;
+    pool_destroy(pool->pool);
+    free(pool->generations);
+    free(pool);
+}
@@ -0,0 +1,114 @@
+#ifndef OBJPOOL_H
+#define OBJPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mempool.h"
+
+/*
+ * Пул объектов с доступом по 32-битным дескрипторам (handles).
+ *
+ * Дескриптор = [поколение:OBJ_GENERATION_BITS | номер слота:OBJ_INDEX_BITS].
+ * При каждом освобождении поколение слота увеличивается, поэтому старый
+ * дескриптор после obj_release() перестает разрешаться (use-after-free
+ * превращается в NULL). Память объектов — блоки MemoryPool, номер слота
+ * совпадает с номером блока в арене пула.
+ *
+ * Поколение конечно: оно проходит OBJ_GENERATION_PERIOD значений (0
+ * пропускается), и после OBJ_GENERATION_PERIOD освобождений того же слота
+ * старый дескриптор снова разрешается — в объект, который сейчас живет в
+ * слоте. Гарантия действует, пока слот освобожден меньше
+ * OBJ_GENERATION_PERIOD раз с момента выдачи дескриптора: при 22 битах
+ * номера это 1023 освобождения. Если дескрипторы живут дольше, число бит
+ * номера уменьшают (-DOBJ_INDEX_BITS=16 дает 65535 поколений на 65536
+ * объектов).
+ */
+
+#ifndef OBJ_INDEX_BITS
+#define OBJ_INDEX_BITS 22
+#endif
+#define OBJ_GENERATION_BITS (32 - OBJ_INDEX_BITS)
+#if OBJ_GENERATION_BITS < 1 || OBJ_GENERATION_BITS > 16
+#error "OBJ_INDEX_BITS must leave 1..16 generation bits"
+#endif
+#define OBJ_GENERATION_PERIOD ((1u << OBJ_GENERATION_BITS) - 1)
+#define OBJ_INDEX_MASK ((1u << OBJ_INDEX_BITS) - 1)
+#define OBJ_MAX_OBJECTS (1u << OBJ_INDEX_BITS)
+
+/** Дескриптор объекта; 0 никогда не выдается (поколение 0 не используется) */
+typedef uint32_t ObjHandle;
+#define OBJ_HANDLE_NULL 0u
+
+/** Вызывается при выдаче (конструктор) или возврате (деструктор) объекта */
+typedef void (*ObjCallback)(void* object, void* ctx);
+
+/*
+ * Поля открыты только ради inline obj_resolve(); изменять их напрямую нельзя.
+ */
+typedef struct ObjectPool {
+    char* base;             // адрес слота 0 (начало арены пула)
+    size_t object_size;     // шаг между слотами
+    uint32_t capacity;
+    uint16_t* generations;  // текущее поколение каждого слота
+    MemoryPool* pool;
+    ObjCallback ctor;
+    ObjCallback dtor;
+    void* ctx;
+} ObjectPool;
+
+/**
+ * @brief Создает пул объектов.
+ * 
+ * @param object_size Размер объекта в байтах.
+ * @param capacity Число объектов (не больше OBJ_MAX_OBJECTS).
+ * @param flags Флаги POOL_* для нижележащего MemoryPool.
+ * @param ctor Конструктор, вызываемый в obj_acquire() (может быть NULL).
+ * @param dtor Деструктор, вызываемый в obj_release() (может быть NULL).
+ * @param ctx Контекст, передаваемый в ctor/dtor.
+ * @return Указатель на пул или NULL в случае ошибки.
+ */
+ObjectPool* obj_pool_create(size_t object_size, size_t capacity, unsigned flags,
+                            ObjCallback ctor, ObjCallback dtor, void* ctx);
+
+/**
+ * @brief Выдает объект и возвращает его дескриптор.
+ * 
+ * @param pool Указатель на пул объектов.
+ * @return Дескриптор или OBJ_HANDLE_NULL, если свободных объектов нет.
+ */
+ObjHandle obj_acquire(ObjectPool* pool);
+
+/**
+ * @brief Возвращает объект в пул; дескриптор становится недействительным
+ * (в пределах окна поколений, см. выше).
+ * 
+ * @param pool Указатель на пул объектов.
+ * @param handle Дескриптор из obj_acquire().
+ * @return 0 при успехе, -1, если дескриптор устарел или некорректен.
+ */
+int obj_release(ObjectPool* pool, ObjHandle handle);
+
+/**
+ * @brief Уничтожает пул объектов (деструкторы для живых объектов не вызываются).
+ * 
+ * @param pool Указатель на пул объектов.
+ */
+void obj_pool_destroy(ObjectPool* pool);
+
+/**
+ * @brief Разрешает дескриптор в указатель: одна загрузка поколения и сравнение.
+ * 
+ * Освобождение и разрешение одного объекта из разных потоков требуют
+ * внешней синхронизации.
+ * 
+ * @return Указатель на объект или NULL, если дескриптор устарел.
+ */
+static inline void* obj_resolve(const ObjectPool* pool, ObjHandle handle) {
+    uint32_t index = handle & OBJ_INDEX_MASK;
+    if (index >= pool->capacity || pool->generations[index] != (handle >> OBJ_INDEX_BITS)) {
+        return NULL;
+    }
+    return pool->base + (size_t)index * pool->object_size;
+}
+
+#endif // OBJPOOL_H
@@ -0,0 +1,49 @@
+/*
+ * Проверка окна поколений ObjectPool (make check).
+ *
+ * Слот освобождается и выдается заново: пока число освобождений меньше
+ * OBJ_GENERATION_PERIOD, старый дескриптор не разрешается и не
+ * освобождает объект; на OBJ_GENERATION_PERIOD-м освобождении поколение
+ * совершает полный круг, и он снова разрешается — это и есть
+ * задокументированная граница гарантии.
+ */
+
+#include <stdio.h>
+#include "objpool.h"
+
+int main(void) {
+    ObjectPool* objects = obj_pool_create(32, 1, 0, NULL, NULL, NULL);
+    if (!objects) {
+        printf("FAIL: obj_pool_create\n");
+        return 1;
+    }
+
+    ObjHandle stale = obj_acquire(objects);
+    if (stale == OBJ_HANDLE_NULL || !obj_resolve(objects, stale)) {
+        printf("FAIL: fresh handle does not resolve\n");
+        return 1;
+    }
+
+    ObjHandle current = stale;
+    for (unsigned releases = 1; releases < OBJ_GENERATION_PERIOD; ++releases) {
+        obj_release(objects, current);
+        current = obj_acquire(objects);
+        if (obj_resolve(objects, stale) || obj_release(objects, stale) == 0) {
+            printf("FAIL: stale handle is accepted after %u releases of its slot\n", releases);
+            return 1;
+        }
+    }
+
+    // Полный круг поколений: дескриптор совпадает с текущим
+    obj_release(objects, current);
+    current = obj_acquire(objects);
+    if (current != stale || obj_resolve(objects, stale) != obj_resolve(objects, current)) {
+        printf("FAIL: generation did not wrap after %u releases\n", OBJ_GENERATION_PERIOD);
+        return 1;
+    }
+
+    printf("objpool check passed: stale handle rejected for %u releases, resolves again after %u\n",
+           OBJ_GENERATION_PERIOD - 1, OBJ_GENERATION_PERIOD);
+    obj_pool_destroy(objects);
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include "probe.h"
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct Probe {
+    int use_perf;
+    int group_fd;                         // лидер группы, -1 в режиме getrusage
+    int fds[PROBE_COUNTER_COUNT];         // -1, если счетчик не открылся
+    int slot[PROBE_COUNTER_COUNT];        // позиция счетчика в ответе read()
+    int members;
+};
+
+static const struct {
+    const char* name;
+    uint64_t config;
+} probe_events[PROBE_COUNTER_COUNT] = {
+    [PROBE_PAGE_FAULTS] = {"faults", PERF_COUNT_SW_PAGE_FAULTS},
+    [PROBE_MINOR_FAULTS] = {"minflt", PERF_COUNT_SW_PAGE_FAULTS_MIN},
+    [PROBE_MAJOR_FAULTS] = {"majflt", PERF_COUNT_SW_PAGE_FAULTS_MAJ},
+    [PROBE_CONTEXT_SWITCHES] = {"ctxsw", PERF_COUNT_SW_CONTEXT_SWITCHES},
+    [PROBE_CPU_MIGRATIONS] = {"migr", PERF_COUNT_SW_CPU_MIGRATIONS},
+};
+
+static int open_event(uint64_t config, int group_fd, int exclude_kernel) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_SOFTWARE;
+    attr.config = config;
+    attr.disabled = group_fd == -1; // группа включается через лидера
+    attr.exclude_kernel = exclude_kernel;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static int probe_open_perf(Probe* probe) {
+    // Без прав на события ядра (perf_event_paranoid >= 2) остаются
+    // события с exclude_kernel, faults пользовательских адресов они видят
+    int exclude_kernel = 0;
+    int leader = open_event(probe_events[0].config, -1, exclude_kernel);
+    if (leader < 0) {
+        exclude_kernel = 1;
+        leader = open_event(probe_events[0].config, -1, exclude_kernel);
+    }
+    if (leader < 0) return -1;
+
+    probe->group_fd = leader;
+    probe->fds[0] = leader;
+    probe->slot[0] = probe->members++;
+    for (int i = 1; i < PROBE_COUNTER_COUNT; ++i) {
+        probe->fds[i] = open_event(probe_events[i].config, leader, exclude_kernel);
+        if (probe->fds[i] >= 0) probe->slot[i] = probe->members++;
+    }
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return 0;
+}
+
+Probe* probe_open(void) {
+    Probe* probe = (Probe*)calloc(1, sizeof(Probe));
+    if (!probe) return NULL;
+    probe->group_fd = -1;
+    for (int i = 0; i < PROBE_COUNTER_COUNT; ++i) {
+        probe->fds[i] = -1;
+        probe->slot[i] = -1;
+    }
+    probe->use_perf = probe_open_perf(probe) == 0;
+    return probe;
+}
+
+int probe_read(Probe* probe, ProbeSample* sample) {
+    memset(sample, 0, sizeof(*sample));
+    if (probe->use_perf) {
+        // Формат PERF_FORMAT_GROUP: число счетчиков, затем их значения
+        uint64_t buffer[1 + PROBE_COUNTER_COUNT];
+        ssize_t expected = (ssize_t)((1 + probe->members) * sizeof(uint64_t));
+        if (read(probe->group_fd, buffer, sizeof(buffer)) != expected) return -1;
+        for (int i = 0; i < PROBE_COUNTER_COUNT; ++i) {
+            if (probe->slot[i] >= 0) sample->values[i] = buffer[1 + probe->slot[i]];
+        }
+        return 0;
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) != 0) return -1;
+    sample->values[PROBE_MINOR_FAULTS] = (uint64_t)usage.ru_minflt;
+    sample->values[PROBE_MAJOR_FAULTS] = (uint64_t)usage.ru_majflt;
+    sample->values[PROBE_PAGE_FAULTS] = (uint64_t)(usage.ru_minflt + usage.ru_majflt);
+    sample->values[PROBE_CONTEXT_SWITCHES] = (uint64_t)(usage.ru_nvcsw + usage.ru_nivcsw);
+    return 0;
+}
+
+void probe_delta(const ProbeSample* before, const ProbeSample* after, ProbeSample* out) {
+    for (int i = 0; i < PROBE_COUNTER_COUNT; ++i) {
+        out->values[i] = after->values[i] - before->values[i];
+    }
+}
+
+int probe_has(const Probe* probe, ProbeCounter counter) {
+    if (probe->use_perf) return probe->slot[counter] >= 0;
+    return counter != PROBE_CPU_MIGRATIONS;
+}
+
+int probe_uses_perf(const Probe* probe) {
+    return probe->use_perf;
+}
+
+const char* probe_counter_name(ProbeCounter counter) {
+    return probe_events[counter].name;
+}
+
+#define PROBE_TOP_SLOWEST 5
+
+// Пишет "name=value" для всех доступных счетчиков
+static void print_events(const Probe* probe, const ProbeSample* sample) {
+    for (int c = 0; c < PROBE_COUNTER_COUNT; ++c) {
+        if (probe_has(probe, (ProbeCounter)c)) {
+            printf(" %s=%llu", probe_events[c].name, (unsigned long long)sample->values[c]);
+        }
+    }
+}
+
+void probe_print_summary(const Probe* probe, const ProbeRecord* records, int count) {
+    if (count <= 0) return;
+    long long min = records[0].latency_ns, max = records[0].latency_ns;
+    long long sum_fault = 0, sum_clean = 0, max_fault = 0, max_clean = 0;
+    int faulting = 0;
+    ProbeSample total;
+    memset(&total, 0, sizeof(total));
+    int slowest[PROBE_TOP_SLOWEST];
+    int slowest_count = 0;
+
+    for (int i = 0; i < count; ++i) {
+        long long latency = records[i].latency_ns;
+        if (latency < min) min = latency;
+        if (latency > max) max = latency;
+        for (int c = 0; c < PROBE_COUNTER_COUNT; ++c) total.values[c] += records[i].events.values[c];
+
+        if (records[i].events.values[PROBE_PAGE_FAULTS] > 0) {
+            faulting++;
+            sum_fault += latency;
+            if (latency > max_fault) max_fault = latency;
+        } else {
+            sum_clean += latency;
+            if (latency > max_clean) max_clean = latency;
+        }
+
+        // Вставка в короткий список самых медленных замеров
+        int pos = slowest_count < PROBE_TOP_SLOWEST ? slowest_count++ : PROBE_TOP_SLOWEST;
+        while (pos > 0 && records[slowest[pos - 1]].latency_ns < latency) {
+            if (pos < PROBE_TOP_SLOWEST) slowest[pos] = slowest[pos - 1];
+            pos--;
+        }
+        if (pos < PROBE_TOP_SLOWEST) slowest[pos] = i;
+    }
+
+    printf("Samples: %d (counters via %s)\n", count, probe->use_perf ? "perf_event_open" : "getrusage");
+    printf("Latency: min %lld ns, avg %.1f ns, max %lld ns\n", min,
+           (double)(sum_fault + sum_clean) / count, max);
+    if (faulting > 0) {
+        printf("With page faults:    %d samples, avg %.1f ns, max %lld ns\n", faulting,
+               (double)sum_fault / faulting, max_fault);
+    }
+    if (faulting < count) {
+        printf("Without page faults: %d samples, avg %.1f ns, max %lld ns\n", count - faulting,
+               (double)sum_clean / (count - faulting), max_clean);
+    }
+    printf("Totals:");
+    print_events(probe, &total);
+    printf("\nSlowest samples:\n");
+    for (int k = 0; k < slowest_count; ++k) {
+        printf("  #%d\t%lld ns\t", slowest[k], records[slowest[k]].latency_ns);
+        print_events(probe, &records[slowest[k]].events);
+        printf("\n");
+    }
+}
+
+void probe_print_records(const Probe* probe, const ProbeRecord* records, int count) {
+    printf("Iter\tLatency (ns)");
+    for (int c = 0; c < PROBE_COUNTER_COUNT; ++c) {
+        if (probe_has(probe, (ProbeCounter)c)) printf("\t%s", probe_events[c].name);
+    }
+    printf("\n");
+    for (int i = 0; i < count; ++i) {
+        printf("%d\t%lld", i, records[i].latency_ns);
+        for (int c = 0; c < PROBE_COUNTER_COUNT; ++c) {
+            if (probe_has(probe, (ProbeCounter)c)) {
+                printf("\t%llu", (unsigned long long)records[i].events.values[c]);
+            }
+        }
+        printf("\n");
+    }
+}
+
+void probe_close(Probe* probe) {
+    if (!probe) return;
+    // Сначала члены группы, лидер последним
+    for (int i = PROBE_COUNTER_COUNT - 1; i >= 0; --i) {
+        if (probe->fds[i] >= 0) close(probe->fds[i]);
+    }
+    free(probe);
+}
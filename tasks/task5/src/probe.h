@@ -0,0 +1,100 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdint.h>
+
+/*
+ * Счетчики событий ядра для замеров задержки: page faults, context
+ * switches и миграции потока между CPU.
+ *
+ * Все счетчики открываются один раз через perf_event_open как одна группа
+ * программных событий текущего потока и читаются одним read() на лидере
+ * группы. В отличие от пары getrusage, это один системный вызов на замер,
+ * счетчики относятся к потоку, а не ко всему процессу, и есть миграции.
+ * rdpmc для программных событий недоступен (у них нет аппаратного
+ * счетчика), поэтому чтение всегда идет через read().
+ *
+ * Если perf_event_open запрещен (perf_event_paranoid, seccomp), модуль
+ * переходит на getrusage(RUSAGE_THREAD): доступны только faults и
+ * переключения контекста.
+ */
+
+typedef enum {
+    PROBE_PAGE_FAULTS,
+    PROBE_MINOR_FAULTS,
+    PROBE_MAJOR_FAULTS,
+    PROBE_CONTEXT_SWITCHES,
+    PROBE_CPU_MIGRATIONS,
+    PROBE_COUNTER_COUNT
+} ProbeCounter;
+
+/** Значения всех счетчиков на момент чтения */
+typedef struct {
+    uint64_t values[PROBE_COUNTER_COUNT];
+} ProbeSample;
+
+typedef struct Probe Probe;
+
+/** Один замер: задержка и события, пришедшиеся на него */
+typedef struct {
+    long long latency_ns;
+    ProbeSample events;
+} ProbeRecord;
+
+/**
+ * @brief Открывает счетчики для текущего потока.
+ * 
+ * @return Указатель на probe или NULL при нехватке памяти.
+ */
+Probe* probe_open(void);
+
+/**
+ * @brief Читает все счетчики одним системным вызовом.
+ * 
+ * @param probe Указатель на probe.
+ * @param sample Куда записать значения.
+ * @return 0 при успехе, -1 при ошибке чтения.
+ */
+int probe_read(Probe* probe, ProbeSample* sample);
+
+/**
+ * @brief Разность двух замеров: out = after - before.
+ */
+void probe_delta(const ProbeSample* before, const ProbeSample* after, ProbeSample* out);
+
+/**
+ * @brief Возвращает 1, если счетчик действительно считается.
+ */
+int probe_has(const Probe* probe, ProbeCounter counter);
+
+/**
+ * @brief Возвращает 1, если используется perf_event_open, 0 — getrusage.
+ */
+int probe_uses_perf(const Probe* probe);
+
+/**
+ * @brief Короткое имя счетчика для вывода.
+ */
+const char* probe_counter_name(ProbeCounter counter);
+
+/**
+ * @brief Печатает сводку по замерам: задержки с событиями и без,
+ *        суммы счетчиков и самые медленные замеры.
+ * 
+ * @param probe Указатель на probe (нужен, чтобы не выводить недоступные счетчики).
+ * @param records Замеры.
+ * @param count Число замеров.
+ */
+void probe_print_summary(const Probe* probe, const ProbeRecord* records, int count);
+
+/**
+ * @brief Печатает замеры построчно (для построения графиков).
+ */
+void probe_print_records(const Probe* probe, const ProbeRecord* records, int count);
+
+/**
+ * @brief Закрывает счетчики и освобождает probe.
+ */
+void probe_close(Probe* probe);
+
+#endif // PROBE_H
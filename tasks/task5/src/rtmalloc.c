@@ -0,0 +1,312 @@
+#include "rtmalloc.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "mempool.h"
+
+// Библиотека собирается с -fvisibility=hidden: наружу видны только
+// перехватываемые функции и API rtmalloc_*, функции MemoryPool остаются
+// внутренними и не конфликтуют с одноименными символами программы
+#define RT_API __attribute__((visibility("default")))
+// initial-exec: обращение к TLS не должно само вызывать malloc
+#define RT_TLS __attribute__((tls_model("initial-exec")))
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+// Классы размеров 16..4096 байт (степени двойки)
+#define CLASS_MIN_SHIFT 4
+#define CLASS_MAX_SHIFT 12
+#define CLASS_COUNT (CLASS_MAX_SHIFT - CLASS_MIN_SHIFT + 1)
+#define DEFAULT_CLASS_BYTES (4UL * 1024 * 1024)
+
+// Настоящий аллокатор glibc: экспортируется libc и не требует dlsym,
+// который сам может вызвать malloc
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t align, size_t size);
+extern void __libc_free(void* ptr);
+
+enum { STATE_UNINIT, STATE_INIT, STATE_READY, STATE_DISABLED };
+enum { MODE_POLICY, MODE_ALL, MODE_API };
+
+static _Atomic int init_state = STATE_UNINIT;
+static int rt_mode = MODE_POLICY;
+static int abort_on_fallback;
+static int print_stats;
+
+// Арены классов: [region, region + region_size), окно класса i начинается
+// с region + (i << window_shift). Окна выровнены на страницу, поэтому блок
+// размера 2^k (k <= 12) выровнен на 2^k.
+static char* region;
+static size_t region_size;
+static int window_shift;
+static MemoryPool* pools[CLASS_COUNT];
+
+static _Atomic unsigned long stat_pool_allocs;
+static _Atomic unsigned long stat_rt_fallbacks;
+static _Atomic unsigned long stat_rt_libc_frees;
+static _Atomic unsigned long stat_pool_exhausted;
+
+// -1 — политика потока еще не прочитана
+static __thread RT_TLS signed char thread_rt = -1;
+static __thread RT_TLS char thread_explicit;
+
+static int rt_init(void) {
+    const char* mode = getenv("RTMALLOC_MODE");
+    if (mode && strcmp(mode, "all") == 0) rt_mode = MODE_ALL;
+    if (mode && strcmp(mode, "api") == 0) rt_mode = MODE_API;
+    const char* env = getenv("RTMALLOC_ABORT");
+    abort_on_fallback = env && env[0] == '1';
+    env = getenv("RTMALLOC_STATS");
+    print_stats = env && env[0] == '1';
+
+    size_t window = DEFAULT_CLASS_BYTES;
+    env = getenv("RTMALLOC_CLASS_KB");
+    if (env && atol(env) > 0) window = (size_t)atol(env) * 1024;
+    int shift = CLASS_MAX_SHIFT;
+    while (((size_t)1 << shift) < window) shift++;
+
+    size_t size = (size_t)CLASS_COUNT << shift;
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (base == MAP_FAILED) return 0;
+    mlock(base, size);
+
+    // pool_create_in_buffer вызывает malloc для структуры пула: в состоянии
+    // STATE_INIT такие вызовы уходят напрямую в glibc
+    for (int i = 0; i < CLASS_COUNT; ++i) {
+        int block_shift = CLASS_MIN_SHIFT + i;
+        pools[i] = pool_create_in_buffer((char*)base + ((size_t)i << shift), (size_t)1 << block_shift,
+                                         (size_t)1 << (shift - block_shift), POOL_CONCURRENT);
+        if (!pools[i]) {
+            for (int j = 0; j < i; ++j) pool_destroy(pools[j]);
+            munmap(base, size);
+            return 0;
+        }
+    }
+    region = (char*)base;
+    region_size = size;
+    window_shift = shift;
+    return 1;
+}
+
+static inline int rt_ready(void) {
+    int state = atomic_load_explicit(&init_state, memory_order_acquire);
+    if (state == STATE_READY) return 1;
+    if (state == STATE_UNINIT) {
+        int expected = STATE_UNINIT;
+        if (atomic_compare_exchange_strong(&init_state, &expected, STATE_INIT)) {
+            int ok = rt_init();
+            atomic_store_explicit(&init_state, ok ? STATE_READY : STATE_DISABLED, memory_order_release);
+            return ok;
+        }
+    }
+    return 0;
+}
+
+static int policy_is_rt(void) {
+    if (rt_mode == MODE_ALL) return 1;
+    if (rt_mode == MODE_API) return 0;
+    int policy = sched_getscheduler(0);
+    return policy == SCHED_FIFO || policy == SCHED_RR || policy == SCHED_DEADLINE;
+}
+
+static inline int thread_is_rt(void) {
+    if (thread_rt < 0) thread_rt = (signed char)policy_is_rt();
+    return thread_rt;
+}
+
+static inline int size_class(size_t size) {
+    if (size <= ((size_t)1 << CLASS_MIN_SHIFT)) return 0;
+    return (int)(sizeof(unsigned long) * 8 - (size_t)__builtin_clzl(size - 1)) - CLASS_MIN_SHIFT;
+}
+
+// Номер класса, которому принадлежит ptr, или -1 для памяти glibc
+static inline int owner_class(const void* ptr) {
+    if (atomic_load_explicit(&init_state, memory_order_acquire) != STATE_READY) return -1;
+    uintptr_t offset = (uintptr_t)ptr - (uintptr_t)region;
+    return offset < region_size ? (int)(offset >> window_shift) : -1;
+}
+
+static void rt_fallback(void) {
+    atomic_fetch_add_explicit(&stat_rt_fallbacks, 1, memory_order_relaxed);
+    if (abort_on_fallback) {
+        static const char msg[] = "rtmalloc: glibc allocation in a real-time thread, aborting\n";
+        write(STDERR_FILENO, msg, sizeof(msg) - 1);
+        abort();
+    }
+}
+
+// Блок из пула для RT-потока или NULL, если выделение должно уйти в glibc
+static void* rt_pool_alloc(size_t size, size_t align) {
+    if (!rt_ready() || !thread_is_rt()) return NULL;
+    if (align > size) size = align;
+    if (size <= RTMALLOC_MAX_SIZE) {
+        void* block = pool_alloc(pools[size_class(size)]);
+        if (block) {
+            atomic_fetch_add_explicit(&stat_pool_allocs, 1, memory_order_relaxed);
+            return block;
+        }
+        atomic_fetch_add_explicit(&stat_pool_exhausted, 1, memory_order_relaxed);
+    }
+    rt_fallback();
+    return NULL;
+}
+
+RT_API void* malloc(size_t size) {
+    void* block = rt_pool_alloc(size, 0);
+    return block ? block : __libc_malloc(size);
+}
+
+RT_API void free(void* ptr) {
+    if (!ptr) return;
+    int cls = owner_class(ptr);
+    if (cls >= 0) {
+        pool_free(pools[cls], ptr);
+        return;
+    }
+    if (thread_rt == 1) atomic_fetch_add_explicit(&stat_rt_libc_frees, 1, memory_order_relaxed);
+    __libc_free(ptr);
+}
+
+RT_API void* calloc(size_t count, size_t size) {
+    size_t total;
+    if (__builtin_mul_overflow(count, size, &total)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    void* block = rt_pool_alloc(total, 0);
+    if (!block) return __libc_calloc(count, size);
+    memset(block, 0, total);
+    return block;
+}
+
+RT_API void* realloc(void* ptr, size_t size) {
+    if (!ptr) return malloc(size);
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    int cls = owner_class(ptr);
+    if (cls < 0) {
+        if (thread_rt == 1) rt_fallback();
+        return __libc_realloc(ptr, size);
+    }
+    size_t old_size = (size_t)1 << (cls + CLASS_MIN_SHIFT);
+    if (size <= old_size) return ptr;
+    void* block = malloc(size);
+    if (!block) return NULL;
+    memcpy(block, ptr, old_size);
+    pool_free(pools[cls], ptr);
+    return block;
+}
+
+RT_API int posix_memalign(void** out, size_t align, size_t size) {
+    if (align < sizeof(void*) || (align & (align - 1)) != 0) return EINVAL;
+    void* block = rt_pool_alloc(size, align);
+    if (!block) block = __libc_memalign(align, size);
+    if (!block) return ENOMEM;
+    *out = block;
+    return 0;
+}
+
+RT_API void* memalign(size_t align, size_t size) {
+    void* block = rt_pool_alloc(size, align);
+    return block ? block : __libc_memalign(align, size);
+}
+
+RT_API void* aligned_alloc(size_t align, size_t size) {
+    return memalign(align, size);
+}
+
+RT_API void* valloc(size_t size) {
+    return memalign((size_t)sysconf(_SC_PAGESIZE), size);
+}
+
+RT_API size_t malloc_usable_size(void* ptr) {
+    if (!ptr) return 0;
+    int cls = owner_class(ptr);
+    if (cls >= 0) return (size_t)1 << (cls + CLASS_MIN_SHIFT);
+    static size_t (*real_usable_size)(void*);
+    if (!real_usable_size) real_usable_size = (size_t(*)(void*))dlsym(RTLD_NEXT, "malloc_usable_size");
+    return real_usable_size ? real_usable_size(ptr) : 0;
+}
+
+// Смена политики текущего потока сразу меняет маршрут его выделений
+RT_API int sched_setscheduler(pid_t pid, int policy, const struct sched_param* param) {
+    static int (*real_setscheduler)(pid_t, int, const struct sched_param*);
+    if (!real_setscheduler) {
+        real_setscheduler = (int (*)(pid_t, int, const struct sched_param*))dlsym(RTLD_NEXT, "sched_setscheduler");
+        if (!real_setscheduler) {
+            errno = ENOSYS;
+            return -1;
+        }
+    }
+    int rc = real_setscheduler(pid, policy, param);
+    if (rc == 0 && (pid == 0 || pid == gettid()) && !thread_explicit) thread_rt = -1;
+    return rc;
+}
+
+RT_API int pthread_setschedparam(pthread_t thread, int policy, const struct sched_param* param) {
+    static int (*real_setschedparam)(pthread_t, int, const struct sched_param*);
+    if (!real_setschedparam) {
+        real_setschedparam = (int (*)(pthread_t, int, const struct sched_param*))dlsym(RTLD_NEXT, "pthread_setschedparam");
+        if (!real_setschedparam) return ENOSYS;
+    }
+    int rc = real_setschedparam(thread, policy, param);
+    if (rc == 0 && pthread_equal(thread, pthread_self()) && !thread_explicit) thread_rt = -1;
+    return rc;
+}
+
+RT_API void rtmalloc_thread_set_rt(int enable) {
+    thread_explicit = 1;
+    thread_rt = enable ? 1 : 0;
+}
+
+RT_API void rtmalloc_thread_refresh(void) {
+    thread_explicit = 0;
+    thread_rt = -1;
+}
+
+RT_API int rtmalloc_thread_is_rt(void) {
+    return rt_ready() && thread_is_rt();
+}
+
+RT_API int rtmalloc_owns(const void* ptr) {
+    return ptr && owner_class(ptr) >= 0;
+}
+
+RT_API void rtmalloc_get_stats(RtMallocStats* stats) {
+    stats->pool_allocs = atomic_load_explicit(&stat_pool_allocs, memory_order_relaxed);
+    stats->rt_fallbacks = atomic_load_explicit(&stat_rt_fallbacks, memory_order_relaxed);
+    stats->rt_libc_frees = atomic_load_explicit(&stat_rt_libc_frees, memory_order_relaxed);
+    stats->pool_exhausted = atomic_load_explicit(&stat_pool_exhausted, memory_order_relaxed);
+}
+
+// Арены создаются при загрузке, до того как программа войдет в RT-секцию
+__attribute__((constructor)) static void rtmalloc_load(void) {
+    rt_ready();
+}
+
+__attribute__((destructor)) static void rtmalloc_unload(void) {
+    if (!print_stats) return;
+    RtMallocStats stats;
+    rtmalloc_get_stats(&stats);
+    char line[256];
+    int len = snprintf(line, sizeof(line),
+                       "rtmalloc: pool allocs %lu, RT fallbacks to glibc %lu (pool exhausted %lu), "
+                       "RT frees of glibc memory %lu\n",
+                       stats.pool_allocs, stats.rt_fallbacks, stats.pool_exhausted, stats.rt_libc_frees);
+    if (len > 0) write(STDERR_FILENO, line, (size_t)len);
+}
@@ -0,0 +1,69 @@
+#ifndef RTMALLOC_H
+#define RTMALLOC_H
+
+/*
+ * librtmalloc.so — перехватчик malloc/free (LD_PRELOAD) для RT-потоков.
+ *
+ * Малые выделения (до RTMALLOC_MAX_SIZE байт) из потоков, помеченных как
+ * real-time, обслуживаются lock-free пулами MemoryPool по классам размеров
+ * 16, 32, ..., 4096 байт. Арены всех классов лежат в одной заранее
+ * отображенной и заблокированной области, поэтому free() определяет
+ * владельца сравнением адреса. Остальные выделения уходят в glibc.
+ *
+ * Поток считается RT, если:
+ *   - он вызвал rtmalloc_thread_set_rt(1), или
+ *   - в режиме policy (по умолчанию) его политика планирования —
+ *     SCHED_FIFO/SCHED_RR/SCHED_DEADLINE. Политика читается при первом
+ *     выделении в потоке и обновляется при sched_setscheduler(0, ...),
+ *     pthread_setschedparam(pthread_self(), ...) и rtmalloc_thread_refresh().
+ *
+ * Переменные окружения:
+ *   RTMALLOC_MODE=policy|all|api   как определять RT-потоки (all — все потоки)
+ *   RTMALLOC_CLASS_KB=N            размер арены одного класса, КБ (степень двойки)
+ *   RTMALLOC_ABORT=1               abort() при выделении из glibc в RT-потоке
+ *   RTMALLOC_STATS=1               вывести счетчики в stderr при завершении
+ *
+ * Функции ниже экспортируются библиотекой; программа, собранная без нее,
+ * может получить их через dlsym(RTLD_DEFAULT, "rtmalloc_...").
+ */
+
+#include <stddef.h>
+
+#define RTMALLOC_MAX_SIZE 4096
+
+/** Счетчики перехватчика */
+typedef struct {
+    unsigned long pool_allocs;     /**< выделений RT-потоков из пулов */
+    unsigned long rt_fallbacks;    /**< выделений RT-потоков, ушедших в glibc */
+    unsigned long rt_libc_frees;   /**< free() памяти glibc из RT-потоков */
+    unsigned long pool_exhausted;  /**< из них: пул нужного класса был пуст */
+} RtMallocStats;
+
+/**
+ * @brief Явно помечает текущий поток как RT (1) или не RT (0).
+ * 
+ * Метка имеет приоритет над политикой планирования.
+ */
+void rtmalloc_thread_set_rt(int enable);
+
+/**
+ * @brief Снимает явную метку и перечитывает политику планирования потока.
+ */
+void rtmalloc_thread_refresh(void);
+
+/**
+ * @brief Возвращает 1, если выделения текущего потока идут в пулы.
+ */
+int rtmalloc_thread_is_rt(void);
+
+/**
+ * @brief Возвращает 1, если ptr выделен из пулов перехватчика.
+ */
+int rtmalloc_owns(const void* ptr);
+
+/**
+ * @brief Копирует текущие значения счетчиков.
+ */
+void rtmalloc_get_stats(RtMallocStats* stats);
+
+#endif // RTMALLOC_H
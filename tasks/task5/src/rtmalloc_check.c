@@ -0,0 +1,102 @@
+/*
+ * Проверка librtmalloc.so под LD_PRELOAD (make check).
+ *
+ * Поток, помеченный как RT, в цикле выделяет и освобождает блоки
+ * 1..RTMALLOC_MAX_SIZE байт: каждый указатель должен лежать в пулах
+ * перехватчика, а счетчики — показать выделения из пулов без ухода в
+ * glibc. Выделения обычного потока и крупные выделения RT-потока должны
+ * идти в glibc. Программа собирается без библиотеки и находит ее API
+ * через dlsym, как описано в rtmalloc.h.
+ */
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rtmalloc.h"
+
+#define CHECK_ITERATIONS 100000
+#define CHECK_HELD 64
+
+typedef struct {
+    void (*set_rt)(int);
+    int (*owns)(const void*);
+    void (*get_stats)(RtMallocStats*);
+} RtMallocApi;
+
+typedef struct {
+    const RtMallocApi* api;
+    long foreign;       // блоки RT-потока не из пулов
+    int large_in_pool;  // крупный блок оказался в пуле
+} CheckWorker;
+
+static void* rt_worker(void* arg) {
+    CheckWorker* w = (CheckWorker*)arg;
+    void* held[CHECK_HELD];
+    w->api->set_rt(1);
+
+    // Внутри цикла нет printf: он сам может выделять память
+    for (int i = 0; i < CHECK_ITERATIONS; ++i) {
+        size_t size = 1 + (size_t)(i * 7919) % RTMALLOC_MAX_SIZE;
+        void* block = malloc(size);
+        if (!w->api->owns(block)) w->foreign++;
+        memset(block, 0xA5, size);
+        held[i % CHECK_HELD] = block;
+        if (i % CHECK_HELD == CHECK_HELD - 1) {
+            for (int j = 0; j < CHECK_HELD; ++j) free(held[j]);
+        }
+    }
+    void* large = malloc(RTMALLOC_MAX_SIZE * 2);
+    w->large_in_pool = w->api->owns(large);
+    free(large);
+    return NULL;
+}
+
+int main(void) {
+    RtMallocApi api = {
+        .set_rt = (void (*)(int))dlsym(RTLD_DEFAULT, "rtmalloc_thread_set_rt"),
+        .owns = (int (*)(const void*))dlsym(RTLD_DEFAULT, "rtmalloc_owns"),
+        .get_stats = (void (*)(RtMallocStats*))dlsym(RTLD_DEFAULT, "rtmalloc_get_stats"),
+    };
+    if (!api.set_rt || !api.owns || !api.get_stats) {
+        printf("FAIL: librtmalloc.so is not preloaded (run via make check)\n");
+        return 1;
+    }
+    int failed = 0;
+
+    RtMallocStats before, after;
+    api.get_stats(&before);
+    CheckWorker worker = {.api = &api};
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, rt_worker, &worker) != 0) {
+        printf("FAIL: pthread_create\n");
+        return 1;
+    }
+    pthread_join(thread, NULL);
+    api.get_stats(&after);
+
+    unsigned long pool_allocs = after.pool_allocs - before.pool_allocs;
+    unsigned long fallbacks = after.rt_fallbacks - before.rt_fallbacks;
+    printf("RT thread: %lu pool allocations, %lu glibc fallbacks, %ld blocks outside the pools\n", pool_allocs,
+           fallbacks, worker.foreign);
+    if (worker.foreign != 0 || pool_allocs < CHECK_ITERATIONS) {
+        printf("FAIL: RT thread allocations did not come from the pools\n");
+        failed = 1;
+    }
+    // Единственный уход в glibc — блок больше RTMALLOC_MAX_SIZE
+    if (worker.large_in_pool || fallbacks != 1) {
+        printf("FAIL: oversized allocation was not routed to glibc\n");
+        failed = 1;
+    }
+
+    void* plain = malloc(64);
+    if (api.owns(plain)) {
+        printf("FAIL: non-RT thread allocation came from the pools\n");
+        failed = 1;
+    }
+    free(plain);
+
+    if (!failed) printf("rtmalloc check passed\n");
+    return failed;
+}
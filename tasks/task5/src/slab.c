@@ -0,0 +1,133 @@
+#include "slab.h"
+#include "mempool.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Шаг таблицы поиска класса по размеру
+#define SLAB_GRANULE sizeof(void*)
+
+struct Slab {
+    char* base;               // начало общей области всех классов
+    size_t region_size;
+    unsigned stride_shift;    // окно одного класса = 1 << stride_shift байт
+    size_t class_count;
+    size_t class_sizes[SLAB_MAX_CLASSES];
+    MemoryPool* pools[SLAB_MAX_CLASSES];
+    size_t max_size;
+    uint8_t* size_to_class;   // (size + SLAB_GRANULE - 1) / SLAB_GRANULE -> класс
+};
+
+static size_t round_up_pow2(size_t value) {
+    size_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+Slab* slab_create_classes(const size_t* class_sizes, size_t class_count, size_t bytes_per_class,
+                          unsigned flags) {
+    if (!class_sizes || class_count == 0 || class_count > SLAB_MAX_CLASSES) return NULL;
+    for (size_t i = 0; i < class_count; ++i) {
+        if (class_sizes[i] < sizeof(void*) || class_sizes[i] % SLAB_GRANULE != 0) return NULL;
+        if (i > 0 && class_sizes[i] <= class_sizes[i - 1]) return NULL;
+    }
+    if (class_sizes[class_count - 1] > bytes_per_class) return NULL;
+
+    Slab* slab = (Slab*)calloc(1, sizeof(Slab));
+    if (!slab) return NULL;
+
+    // Окно класса — степень двойки не меньше страницы, чтобы номер класса
+    // получался из адреса сдвигом
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t stride = round_up_pow2(bytes_per_class < page_size ? page_size : bytes_per_class);
+    while ((1UL << slab->stride_shift) < stride) slab->stride_shift++;
+
+    slab->class_count = class_count;
+    slab->max_size = class_sizes[class_count - 1];
+    slab->region_size = stride * class_count;
+    void* region = mmap(NULL, slab->region_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (region == MAP_FAILED) {
+        free(slab);
+        return NULL;
+    }
+    slab->base = (char*)region;
+
+    for (size_t i = 0; i < class_count; ++i) {
+        char* window = slab->base + i * stride;
+        size_t block_count = bytes_per_class / class_sizes[i];
+        slab->class_sizes[i] = class_sizes[i];
+        // Блокируется только реально используемая часть окна
+        mlock(window, block_count * class_sizes[i]);
+        slab->pools[i] = pool_create_in_buffer(window, class_sizes[i], block_count, flags);
+        if (!slab->pools[i]) {
+            slab_destroy(slab);
+            return NULL;
+        }
+    }
+
+    size_t lookup_len = slab->max_size / SLAB_GRANULE + 1;
+    slab->size_to_class = (uint8_t*)malloc(lookup_len);
+    if (!slab->size_to_class) {
+        slab_destroy(slab);
+        return NULL;
+    }
+    size_t cls = 0;
+    for (size_t g = 0; g < lookup_len; ++g) {
+        while (class_sizes[cls] < g * SLAB_GRANULE) cls++;
+        slab->size_to_class[g] = (uint8_t)cls;
+    }
+
+    return slab;
+}
+
+Slab* slab_create(size_t min_size, size_t max_size, size_t bytes_per_class, unsigned flags) {
+    size_t sizes[SLAB_MAX_CLASSES];
+    size_t count = 0;
+    size_t size = round_up_pow2(min_size < sizeof(void*) ? sizeof(void*) : min_size);
+    max_size = round_up_pow2(max_size);
+    for (; size <= max_size && count < SLAB_MAX_CLASSES; size <<= 1) {
+        sizes[count++] = size;
+    }
+    return slab_create_classes(sizes, count, bytes_per_class, flags);
+}
+
+void* slab_alloc(Slab* slab, size_t size) {
+    if (!slab || size > slab->max_size) return NULL;
+    size_t cls = slab->size_to_class[(size + SLAB_GRANULE - 1) / SLAB_GRANULE];
+
+    // Класс исчерпан — взять блок покрупнее; slab_free() все равно
+    // вернет его в правильный пул, так как пул определяется по адресу
+    for (; cls < slab->class_count; ++cls) {
+        void* block = pool_alloc(slab->pools[cls]);
+        if (block) return block;
+    }
+    return NULL;
+}
+
+int slab_owns(const Slab* slab, const void* ptr) {
+    return slab && (const char*)ptr >= slab->base &&
+           (const char*)ptr < slab->base + slab->region_size;
+}
+
+void slab_free(Slab* slab, void* block) {
+    if (!slab_owns(slab, block)) return;
+    size_t cls = (size_t)((char*)block - slab->base) >> slab->stride_shift;
+    pool_free(slab->pools[cls], block);
+}
+
+size_t slab_block_size(const Slab* slab, const void* block) {
+    if (!slab_owns(slab, block)) return 0;
+    return slab->class_sizes[(size_t)((const char*)block - slab->base) >> slab->stride_shift];
+}
+
+void slab_destroy(Slab* slab) {
+    if (!slab) return;
+    for (size_t i = 0; i < slab->class_count; ++i) {
+        pool_destroy(slab->pools[i]);
+    }
+    munmap(slab->base, slab->region_size);
+    free(slab->size_to_class);
+    free(slab);
+}
@@ -0,0 +1,89 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+
+/*
+ * Slab-аллокатор с классами размеров, каждый класс — отдельный MemoryPool.
+ *
+ * Все пулы лежат в одной непрерывной области: классу i принадлежит окно
+ * [base + i * stride, base + (i + 1) * stride), где stride — степень двойки.
+ * Поэтому slab_free() находит пул по адресу блока одним сдвигом, без
+ * заголовка перед блоком, а slab_alloc() находит класс по размеру
+ * через таблицу поиска.
+ */
+
+typedef struct Slab Slab;
+
+/** Максимальное число классов размеров */
+#define SLAB_MAX_CLASSES 32
+
+/**
+ * @brief Создает slab с классами-степенями двойки от min_size до max_size.
+ * 
+ * @param min_size Размер самого маленького класса (округляется до степени двойки).
+ * @param max_size Размер самого большого класса (округляется до степени двойки).
+ * @param bytes_per_class Объем памяти под блоки каждого класса.
+ * @param flags Флаги POOL_* для пулов классов (например, POOL_CONCURRENT).
+ * @return Указатель на slab или NULL в случае ошибки.
+ */
+Slab* slab_create(size_t min_size, size_t max_size, size_t bytes_per_class, unsigned flags);
+
+/**
+ * @brief Создает slab с произвольным набором классов.
+ * 
+ * @param class_sizes Размеры классов по возрастанию (кратные sizeof(void*)).
+ * @param class_count Число классов (не больше SLAB_MAX_CLASSES).
+ * @param bytes_per_class Объем памяти под блоки каждого класса.
+ * @param flags Флаги POOL_* для пулов классов.
+ * @return Указатель на slab или NULL в случае ошибки.
+ */
+Slab* slab_create_classes(const size_t* class_sizes, size_t class_count, size_t bytes_per_class,
+                          unsigned flags);
+
+/**
+ * @brief Выделяет блок не меньше size байт.
+ * 
+ * Если подходящий класс исчерпан, блок берется из следующего по размеру.
+ * 
+ * @param slab Указатель на slab.
+ * @param size Требуемый размер в байтах.
+ * @return Указатель на блок или NULL, если size больше максимального класса
+ *         или свободных блоков не осталось.
+ */
+void* slab_alloc(Slab* slab, size_t size);
+
+/**
+ * @brief Возвращает блок в пул его класса.
+ * 
+ * @param slab Указатель на slab.
+ * @param block Блок, полученный из slab_alloc().
+ */
+void slab_free(Slab* slab, void* block);
+
+/**
+ * @brief Проверяет, принадлежит ли адрес области slab.
+ * 
+ * @param slab Указатель на slab.
+ * @param ptr Проверяемый адрес.
+ * @return 1, если адрес лежит внутри slab, иначе 0.
+ */
+int slab_owns(const Slab* slab, const void* ptr);
+
+/**
+ * @brief Возвращает размер блока (класса), которому принадлежит адрес.
+ * 
+ * @param slab Указатель на slab.
+ * @param block Блок, полученный из slab_alloc().
+ * @return Размер класса или 0, если адрес не принадлежит slab.
+ */
+size_t slab_block_size(const Slab* slab, const void* block);
+
+/**
+ * @brief Уничтожает slab и освобождает всю его память.
+ * 
+ * @param slab Указатель на slab.
+ */
+void slab_destroy(Slab* slab);
+
+#endif // SLAB_H
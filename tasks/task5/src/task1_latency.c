@@ -1,20 +1,68 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <time.h>
-#include <sys/resource.h>
+#include "probe.h"
+#include "rt_log.h"
 
 #define ARRAY_SIZE (512 * 1024 * 1024) // 512 MB
 #define PAGE_SIZE 4096
 #define NUM_ITERATIONS 1000
 
+// Результаты замеров копятся здесь и выводятся после цикла:
+// printf внутри цикла сам вносил бы задержки и page faults
+static ProbeRecord records[NUM_ITERATIONS];
+
+// Поля журнала --log: номер итерации, задержка и все счетчики probe
+#define LOG_FIELDS (2 + PROBE_COUNTER_COUNT)
+
 long long timespec_diff_ns(struct timespec start, struct timespec end) {
     return (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
 }
 
-int main() {
+static int open_sample_log(RtLog* log, const char* path) {
+    const char* fields[LOG_FIELDS] = {"iteration", "latency_ns"};
+    const char* units[LOG_FIELDS] = {"", "ns"};
+    for (int c = 0; c < PROBE_COUNTER_COUNT; ++c) {
+        fields[2 + c] = probe_counter_name((ProbeCounter)c);
+        units[2 + c] = "";
+    }
+    RtLogConfig config = {.title = "task1_latency: first touch of a page",
+                          .fields = fields,
+                          .units = units,
+                          .field_count = LOG_FIELDS,
+                          .capacity = NUM_ITERATIONS};
+    return rt_log_create(log, path, &config);
+}
+
+int main(int argc, char* argv[]) {
+    int dump = 0;
+    const char* log_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--dump") == 0) {
+            dump = 1;
+        } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            log_path = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--dump] [--log FILE]\n", argv[0]);
+            return 1;
+        }
+    }
     printf("Task 1: Demonstrating Page Faults\n");
 
+    // Двоичный журнал замеров для rtanalyze: запись в цикле — только
+    // копирование в отображенную память
+    RtLog log;
+    if (log_path && open_sample_log(&log, log_path) != 0) {
+        perror("rt_log_create failed");
+        return 1;
+    }
+    if (log_path && rt_log_on_tmpfs(&log) == 0) {
+        fprintf(stderr, "WARNING: %s is not on tmpfs: writeback makes log appends page-fault; "
+                        "use a path under /dev/shm\n", log_path);
+    }
+
     // Выделить большой массив с помощью malloc
     char *array = (char *)malloc(ARRAY_SIZE);
     if (!array) {
@@ -22,15 +70,17 @@ int main() {
         return 1;
     }
 
-    struct timespec start_time, end_time;
-    struct rusage usage_before, usage_after;
+    Probe* probe = probe_open();
+    if (!probe) {
+        perror("probe_open failed");
+        return 1;
+    }
 
-    printf("Iter\tLatency (ns)\tMinor Faults\tMajor Faults\n");
+    struct timespec start_time, end_time;
+    ProbeSample before, after;
+    probe_read(probe, &before);
 
     for (int i = 0; i < NUM_ITERATIONS; ++i) {
-        // Получить статистику использования ресурсов ДО доступа к памяти (getrusage)
-        getrusage(RUSAGE_SELF, &usage_before);
-
         // Замерить время ДО доступа
         clock_gettime(CLOCK_MONOTONIC, &start_time);
 
@@ -42,16 +92,28 @@ int main() {
         // Замерить время ПОСЛЕ доступа
         clock_gettime(CLOCK_MONOTONIC, &end_time);
 
-        // Получить статистику использования ресурсов ПОСЛЕ доступа
-        getrusage(RUSAGE_SELF, &usage_after);
-
-        long long latency = timespec_diff_ns(start_time, end_time);
-        long minor_faults = usage_after.ru_minflt - usage_before.ru_minflt;
-        long major_faults = usage_after.ru_majflt - usage_before.ru_majflt;
+        // Счетчики читаются вне замеряемого участка, одним системным вызовом;
+        // все события между соседними чтениями относятся к этой итерации
+        probe_read(probe, &after);
+        records[i].latency_ns = timespec_diff_ns(start_time, end_time);
+        probe_delta(&before, &after, &records[i].events);
+        before = after;
 
-        printf("%d\t%lld\t\t%ld\t\t%ld\n", i, latency, minor_faults, major_faults);
+        if (log_path) {
+            int64_t values[LOG_FIELDS] = {i, records[i].latency_ns};
+            for (int c = 0; c < PROBE_COUNTER_COUNT; ++c) values[2 + c] = (int64_t)records[i].events.values[c];
+            rt_log_append(&log, values);
+        }
     }
 
+    if (dump) probe_print_records(probe, records, NUM_ITERATIONS);
+    probe_print_summary(probe, records, NUM_ITERATIONS);
+
+    if (log_path) {
+        if (rt_log_close(&log) != 0) perror("rt_log_close");
+        else printf("Samples written to %s\n", log_path);
+    }
+    probe_close(probe);
     free(array);
     return 0;
 }
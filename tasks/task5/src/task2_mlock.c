@@ -1,47 +1,56 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <time.h>
-#include <sys/resource.h>
-#include <sys/mman.h>
+#include "probe.h"
+#include "rt_mem.h"
 
 #define ARRAY_SIZE (512 * 1024 * 1024) // 512 MB
 #define PAGE_SIZE 4096
 #define NUM_ITERATIONS 1000
 
+// Результаты замеров копятся здесь и выводятся после цикла
+static ProbeRecord records[NUM_ITERATIONS];
+
 long long timespec_diff_ns(struct timespec start, struct timespec end) {
     return (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    int dump = argc > 1 && strcmp(argv[1], "--dump") == 0;
     printf("Task 2: Preventing Page Faults with mlockall\n");
 
-    // Заблокировать текущую и будущую память процесса в RAM
-    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    // Заблокировать память процесса в RAM и "прогреть" кучу под массив:
+    // все minor faults происходят на этапе инициализации
+    printf("Pre-faulting memory...\n");
+    RtMemConfig mem_config = {.heap_reserve = ARRAY_SIZE + PAGE_SIZE, .stack_reserve = 64 * 1024};
+    RtMemReport mem_report;
+    if (rt_mem_prepare(&mem_config, &mem_report) != 0) {
         perror("mlockall failed. Try running with sudo.");
         return 1;
     }
+    rt_mem_print_report(&mem_report);
 
+    // Куча не отдает память ядру, поэтому массив занимает уже прогретые страницы
     char *array = (char *)malloc(ARRAY_SIZE);
     if (!array) {
         perror("malloc failed");
         return 1;
     }
 
-    // "Прогреть" память, чтобы вызвать все minor faults на этапе инициализации
-    printf("Pre-faulting memory...\n");
-    for (size_t i = 0; i < ARRAY_SIZE; i += PAGE_SIZE) {
-        array[i] = 0;
+    // Счетчики открываются до цикла, чтобы сам probe не давал faults внутри него
+    Probe* probe = probe_open();
+    if (!probe) {
+        perror("probe_open failed");
+        return 1;
     }
-    printf("Memory pre-faulting complete.\n");
 
     struct timespec start_time, end_time;
-    struct rusage usage_before, usage_after;
-
-    printf("Iter\tLatency (ns)\tMinor Faults\tMajor Faults\n");
-
-    // Сбрасываем статистику перед основным циклом
-    getrusage(RUSAGE_SELF, &usage_before);
+    ProbeSample before, after;
+    // Первый вызов clock_gettime отображает страницы vDSO: сделать его до цикла
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    probe_read(probe, &before);
 
     for (int i = 0; i < NUM_ITERATIONS; ++i) {
         clock_gettime(CLOCK_MONOTONIC, &start_time);
@@ -51,18 +60,17 @@ int main() {
 
         clock_gettime(CLOCK_MONOTONIC, &end_time);
 
-        long long latency = timespec_diff_ns(start_time, end_time);
-
-        // Замеряем общее количество отказов после цикла
-        // В идеале, оно не должно меняться внутри цикла
-        getrusage(RUSAGE_SELF, &usage_after);
-        long minor_faults = usage_after.ru_minflt - usage_before.ru_minflt;
-        long major_faults = usage_after.ru_majflt - usage_before.ru_majflt;
-
-        printf("%d\t%lld\t\t%ld\t\t%ld\n", i, latency, minor_faults, major_faults);
-        usage_before = usage_after; // Обновляем для следующей итерации
+        // В идеале счетчики faults не должны меняться внутри цикла
+        probe_read(probe, &after);
+        records[i].latency_ns = timespec_diff_ns(start_time, end_time);
+        probe_delta(&before, &after, &records[i].events);
+        before = after;
     }
 
+    if (dump) probe_print_records(probe, records, NUM_ITERATIONS);
+    probe_print_summary(probe, records, NUM_ITERATIONS);
+
+    probe_close(probe);
     free(array);
     // munlockall() вызывается неявно при завершении процесса
     return 0;
@@ -1,41 +1,149 @@
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <time.h>
+#include <unistd.h>
+#include "magazine.h"
 #include "mempool.h"
+#include "objpool.h"
+#include "rt_clock.h"
+#include "rt_mem.h"
+#include "slab.h"
+#include "tlsf.h"
 
 #define BENCH_ITERATIONS 1000000
 #define BLOCK_SIZE 128
 
+// Многопоточный режим: операций на поток и блоков, удерживаемых потоком одновременно
+#define MT_OPS_PER_THREAD 200000
+#define MT_BLOCKS_PER_THREAD 16
+#define MT_DEFAULT_MAX_THREADS 8
+
+// Режим производитель/потребитель: блоки освобождает не тот поток, что выделил
+#define PC_OPS_PER_THREAD 200000
+#define PC_RING_SIZE 256
+#define PC_POOL_BLOCKS (1 << 16)
+#define MAG_SIZE 32
+#define MAG_DEPOT_MAGAZINES 256
+
+// Per-CPU пул: потоки не закреплены за CPU и свободно мигрируют
+#define PERCPU_OPS_PER_THREAD 1000000
+#define PERCPU_BLOCKS_PER_THREAD 8
+
+// Slab: смешанные размеры сообщений 32..4096 байт
+#define SLAB_STEPS 1000000
+#define SLAB_LIVE_OBJECTS 4096
+#define SLAB_BYTES_PER_CLASS (4 * 1024 * 1024)
+
+// TLSF: та же смешанная нагрузка, что и у slab; арена с запасом на фрагментацию
+#define TLSF_ARENA_BYTES (2 * SLAB_LIVE_OBJECTS * 4096)
+
+// Пакетный режим: циклов на каждый размер пачки
+#define BULK_CYCLES 100000
+#define BULK_MAX_BATCH 64
+
+// Учет и проверки: операций alloc+free на каждый вариант пула
+#define CHECKED_OPS 10000000
+#define CHECKED_HELD 16
+#define CHECKED_RUNS 5
+
+// Растущий пул: всплески нагрузки больше начального размера пула
+#define ELASTIC_BURSTS 200
+#define ELASTIC_MAX_BURST 8192
+#define ELASTIC_PAUSE_NS 1000000L
+
+// Дескрипторы: набор из 1M объектов, случайный доступ по указателю и по дескриптору
+#define HANDLE_OBJECTS (1 << 20)
+#define HANDLE_OBJECT_SIZE 32
+#define HANDLE_ACCESSES 4000000
+
+// TLB: случайный обход пула 1M x 128 байт (128 МБ)
+#define TLB_BLOCK_COUNT (1 << 20)
+#define TLB_ACCESSES 4000000
+
+// Массивы указателей — статические: 8 МБ на стеке не помещаются в лимит по умолчанию
+static void* ptrs[BENCH_ITERATIONS];
+static void* handle_ptrs[HANDLE_OBJECTS];
+static ObjHandle handles[HANDLE_OBJECTS];
+
+// Источник меток для замеров отдельных операций (TSC или CLOCK_MONOTONIC).
+// Все секции показывают задержки операций и сырыми, и за вычетом
+// стоимости самого замера
+static RtClock bench_clock;
+
 long long timespec_diff_ns(struct timespec start, struct timespec end) {
     return (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
 }
 
+// Задержка операции между двумя метками rt_clock за вычетом накладных расходов
+static inline long long op_latency_ns(uint64_t start, uint64_t end) {
+    return rt_clock_corrected_ns(&bench_clock, start, end);
+}
+
+// Максимум и среднее по сырым и исправленным замерам
+typedef struct {
+    long long max_raw, max_corrected;
+    long long sum_raw, sum_corrected;
+    long long count;
+} OpLatency;
+
+// Возвращает исправленную задержку (для перцентилей)
+static long long op_latency_add(OpLatency* lat, uint64_t start, uint64_t end) {
+    long long raw = rt_clock_raw_ns(&bench_clock, start, end);
+    long long corrected = op_latency_ns(start, end);
+    if (raw > lat->max_raw) lat->max_raw = raw;
+    if (corrected > lat->max_corrected) lat->max_corrected = corrected;
+    lat->sum_raw += raw;
+    lat->sum_corrected += corrected;
+    lat->count++;
+    return corrected;
+}
+
+// Сводка по потокам
+static void op_latency_merge(OpLatency* dst, const OpLatency* src) {
+    if (src->max_raw > dst->max_raw) dst->max_raw = src->max_raw;
+    if (src->max_corrected > dst->max_corrected) dst->max_corrected = src->max_corrected;
+    dst->sum_raw += src->sum_raw;
+    dst->sum_corrected += src->sum_corrected;
+    dst->count += src->count;
+}
+
+static void op_latency_print(const char* name, const OpLatency* lat) {
+    long long count = lat->count > 0 ? lat->count : 1;
+    printf("%s latency: raw max %lld ns, avg %.1f ns; corrected max %lld ns, avg %.1f ns\n",
+           name, lat->max_raw, (double)lat->sum_raw / count, lat->max_corrected,
+           (double)lat->sum_corrected / count);
+}
+
 void benchmark_malloc() {
     printf("Benchmarking malloc/free...\n");
-    struct timespec start, end;
-    long long max_latency = 0;
-    void* ptrs[BENCH_ITERATIONS];
+    OpLatency lat = {0};
 
     for (int i = 0; i < BENCH_ITERATIONS; ++i) {
-        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t start = rt_clock_start(&bench_clock);
         ptrs[i] = malloc(BLOCK_SIZE);
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        long long latency = timespec_diff_ns(start, end);
-        if (latency > max_latency) max_latency = latency;
+        uint64_t end = rt_clock_end(&bench_clock);
+        op_latency_add(&lat, start, end);
     }
 
     for (int i = 0; i < BENCH_ITERATIONS; ++i) {
         free(ptrs[i]);
     }
 
-    printf("malloc/free max latency: %lld ns\n", max_latency);
+    op_latency_print("malloc", &lat);
 }
 
 void benchmark_mempool() {
     printf("Benchmarking memory pool...\n");
-    struct timespec start, end;
-    long long max_latency = 0;
-    void* ptrs[BENCH_ITERATIONS];
+    OpLatency lat = {0};
 
     // Создать пул с достаточным количеством блоков
     MemoryPool* pool = pool_create(BLOCK_SIZE, BENCH_ITERATIONS);
@@ -46,11 +154,10 @@ void benchmark_mempool() {
 
     // Провести бенчмарк для pool_alloc
     for (int i = 0; i < BENCH_ITERATIONS; ++i) {
-        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t start = rt_clock_start(&bench_clock);
         ptrs[i] = pool_alloc(pool);
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        long long latency = timespec_diff_ns(start, end);
-        if (latency > max_latency) max_latency = latency;
+        uint64_t end = rt_clock_end(&bench_clock);
+        op_latency_add(&lat, start, end);
     }
 
     // Освободить блоки
@@ -58,21 +165,943 @@ void benchmark_mempool() {
         pool_free(pool, ptrs[i]);
     }
 
-    printf("pool_alloc max latency: %lld ns\n", max_latency);
+    op_latency_print("pool_alloc", &lat);
 
     // Уничтожить пул
     pool_destroy(pool);
 }
 
-int main() {
-    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
-        perror("mlockall failed. Try with sudo");
-        return 1;
+typedef struct {
+    MemoryPool* pool;
+    pthread_barrier_t* start_barrier;
+    OpLatency lat;
+    long long failures;
+} MtWorker;
+
+static void* mt_worker(void* arg) {
+    MtWorker* w = (MtWorker*)arg;
+    void* held[MT_BLOCKS_PER_THREAD];
+
+    pthread_barrier_wait(w->start_barrier);
+
+    // Каждая итерация: выделить пачку блоков, затем вернуть ее в пул
+    for (int op = 0; op < MT_OPS_PER_THREAD; op += MT_BLOCKS_PER_THREAD) {
+        for (int j = 0; j < MT_BLOCKS_PER_THREAD; ++j) {
+            uint64_t start = rt_clock_start(&bench_clock);
+            held[j] = pool_alloc(w->pool);
+            uint64_t end = rt_clock_end(&bench_clock);
+            op_latency_add(&w->lat, start, end);
+            if (!held[j]) w->failures++;
+        }
+        for (int j = 0; j < MT_BLOCKS_PER_THREAD; ++j) {
+            pool_free(w->pool, held[j]);
+        }
+    }
+    return NULL;
+}
+
+void benchmark_mempool_threads(int max_threads) {
+    printf("Benchmarking concurrent memory pool (1..%d threads)...\n", max_threads);
+    printf("Threads\tThroughput (Mops/s)\tMax raw/corrected (ns)\tFailures\n");
+
+    for (int n = 1; n <= max_threads; ++n) {
+        MemoryPool* pool = pool_create_concurrent(BLOCK_SIZE, (size_t)n * MT_BLOCKS_PER_THREAD);
+        if (!pool) {
+            printf("Failed to create concurrent memory pool\n");
+            return;
+        }
+
+        pthread_t threads[n];
+        MtWorker workers[n];
+        pthread_barrier_t barrier;
+        pthread_barrier_init(&barrier, NULL, (unsigned)n + 1);
+
+        for (int t = 0; t < n; ++t) {
+            workers[t] = (MtWorker){.pool = pool, .start_barrier = &barrier};
+            pthread_create(&threads[t], NULL, mt_worker, &workers[t]);
+        }
+
+        struct timespec start, end;
+        pthread_barrier_wait(&barrier);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        OpLatency lat = {0};
+        long long failures = 0;
+        for (int t = 0; t < n; ++t) {
+            pthread_join(threads[t], NULL);
+            op_latency_merge(&lat, &workers[t].lat);
+            failures += workers[t].failures;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        // Считаем обе операции: pool_alloc и pool_free
+        double total_ops = 2.0 * n * MT_OPS_PER_THREAD;
+        double mops = total_ops / (double)timespec_diff_ns(start, end) * 1000.0;
+        printf("%d\t%.2f\t\t\t%lld/%lld\t\t%lld\n", n, mops, lat.max_raw, lat.max_corrected, failures);
+
+        pthread_barrier_destroy(&barrier);
+        pool_destroy(pool);
+    }
+}
+
+// Аллокатор, который сравнивается в многопоточных режимах
+typedef struct {
+    const char* name;
+    void* (*alloc)(void* ctx);
+    void (*free)(void* ctx, void* block);
+    void* ctx;
+} BenchAllocator;
+
+static void* concurrent_pool_alloc(void* ctx) { return pool_alloc((MemoryPool*)ctx); }
+static void concurrent_pool_free(void* ctx, void* block) { pool_free((MemoryPool*)ctx, block); }
+static void* magazine_alloc(void* ctx) { return mag_alloc((MagazineCache*)ctx); }
+static void magazine_free(void* ctx, void* block) { mag_free((MagazineCache*)ctx, block); }
+
+// Однонаправленное кольцо (SPSC) для передачи блоков соседнему потоку
+typedef struct {
+    _Atomic size_t head;
+    _Atomic size_t tail;
+    void* slots[PC_RING_SIZE];
+} PcRing;
+
+static int pc_ring_push(PcRing* ring, void* block) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail - head == PC_RING_SIZE) return 0;
+    ring->slots[tail % PC_RING_SIZE] = block;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+static void* pc_ring_pop(PcRing* ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head == tail) return NULL;
+    void* block = ring->slots[head % PC_RING_SIZE];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return block;
+}
+
+typedef struct {
+    const BenchAllocator* allocator;
+    PcRing* out;  // сюда поток отдает выделенные блоки
+    PcRing* in;   // отсюда забирает чужие блоки и освобождает их
+    pthread_barrier_t* barrier;
+    OpLatency lat;
+    long long failures;
+} PcWorker;
+
+static void pc_free_timed(PcWorker* w, void* block) {
+    uint64_t start = rt_clock_start(&bench_clock);
+    w->allocator->free(w->allocator->ctx, block);
+    uint64_t end = rt_clock_end(&bench_clock);
+    op_latency_add(&w->lat, start, end);
+}
+
+static void* pc_worker(void* arg) {
+    PcWorker* w = (PcWorker*)arg;
+
+    pthread_barrier_wait(w->barrier);
+
+    for (int op = 0; op < PC_OPS_PER_THREAD; ++op) {
+        uint64_t start = rt_clock_start(&bench_clock);
+        void* block = w->allocator->alloc(w->allocator->ctx);
+        uint64_t end = rt_clock_end(&bench_clock);
+        op_latency_add(&w->lat, start, end);
+
+        if (!block) {
+            w->failures++;
+        } else if (!pc_ring_push(w->out, block)) {
+            // Потребитель не успевает: освободить блок самому
+            pc_free_timed(w, block);
+        }
+
+        void* foreign;
+        while ((foreign = pc_ring_pop(w->in)) != NULL) {
+            pc_free_timed(w, foreign);
+        }
+    }
+
+    // Дождаться, пока все производители закончат, и забрать остаток
+    pthread_barrier_wait(w->barrier);
+    void* foreign;
+    while ((foreign = pc_ring_pop(w->in)) != NULL) {
+        pc_free_timed(w, foreign);
+    }
+    return NULL;
+}
+
+static void run_producer_consumer(const BenchAllocator* allocator, int n) {
+    pthread_t threads[n];
+    PcWorker workers[n];
+    PcRing* rings = (PcRing*)calloc((size_t)n, sizeof(PcRing));
+    pthread_barrier_t barrier;
+    if (!rings) {
+        printf("Failed to allocate rings\n");
+        return;
+    }
+    pthread_barrier_init(&barrier, NULL, (unsigned)n + 1);
+
+    // Кольцевая топология: поток t отдает блоки потоку (t + 1) % n
+    for (int t = 0; t < n; ++t) {
+        workers[t] = (PcWorker){.allocator = allocator,
+                                .out = &rings[t],
+                                .in = &rings[(t + n - 1) % n],
+                                .barrier = &barrier};
+        pthread_create(&threads[t], NULL, pc_worker, &workers[t]);
+    }
+
+    struct timespec start, end;
+    pthread_barrier_wait(&barrier);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_barrier_wait(&barrier);
+    OpLatency lat = {0};
+    long long failures = 0;
+    for (int t = 0; t < n; ++t) {
+        pthread_join(threads[t], NULL);
+        op_latency_merge(&lat, &workers[t].lat);
+        failures += workers[t].failures;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double total_ops = 2.0 * n * PC_OPS_PER_THREAD;
+    double mops = total_ops / (double)timespec_diff_ns(start, end) * 1000.0;
+    printf("%s\t\t%d\t%.2f\t\t\t%lld/%lld\t\t%lld\n", allocator->name, n, mops, lat.max_raw,
+           lat.max_corrected, failures);
+
+    pthread_barrier_destroy(&barrier);
+    free(rings);
+}
+
+void benchmark_magazine(int max_threads) {
+    printf("Benchmarking magazine cache vs concurrent pool (producer/consumer)...\n");
+    printf("Allocator\tThreads\tThroughput (Mops/s)\tMax raw/corrected (ns)\tFailures\n");
+
+    for (int n = 1; n <= max_threads; n *= 2) {
+        MemoryPool* pool = pool_create_concurrent(BLOCK_SIZE, PC_POOL_BLOCKS);
+        if (!pool) {
+            printf("Failed to create concurrent memory pool\n");
+            return;
+        }
+        BenchAllocator plain = {"pool", concurrent_pool_alloc, concurrent_pool_free, pool};
+        run_producer_consumer(&plain, n);
+        pool_destroy(pool);
+
+        pool = pool_create(BLOCK_SIZE, PC_POOL_BLOCKS);
+        MagazineCache* cache = pool ? mag_create(pool, MAG_SIZE, MAG_DEPOT_MAGAZINES) : NULL;
+        if (!cache) {
+            printf("Failed to create magazine cache\n");
+            pool_destroy(pool);
+            return;
+        }
+        BenchAllocator magazines = {"magazine", magazine_alloc, magazine_free, cache};
+        run_producer_consumer(&magazines, n);
+        mag_destroy(cache);
+        pool_destroy(pool);
+    }
+}
+
+// Обычный пул под мьютексом — базовый вариант для сравнения
+typedef struct {
+    MemoryPool* pool;
+    pthread_mutex_t lock;
+} LockedPool;
+
+static void* locked_pool_alloc(void* ctx) {
+    LockedPool* lp = (LockedPool*)ctx;
+    pthread_mutex_lock(&lp->lock);
+    void* block = pool_alloc(lp->pool);
+    pthread_mutex_unlock(&lp->lock);
+    return block;
+}
+
+static void locked_pool_free(void* ctx, void* block) {
+    LockedPool* lp = (LockedPool*)ctx;
+    pthread_mutex_lock(&lp->lock);
+    pool_free(lp->pool, block);
+    pthread_mutex_unlock(&lp->lock);
+}
+
+typedef struct {
+    const BenchAllocator* allocator;
+    pthread_barrier_t* barrier;
+    long long failures;
+} PercpuWorker;
+
+// Время всего цикла, а не каждой операции: clock_gettime дороже
+// быстрого пути per-CPU пула
+static void* percpu_worker(void* arg) {
+    PercpuWorker* w = (PercpuWorker*)arg;
+    const BenchAllocator* a = w->allocator;
+    void* held[PERCPU_BLOCKS_PER_THREAD];
+
+    pthread_barrier_wait(w->barrier);
+    for (int op = 0; op < PERCPU_OPS_PER_THREAD; op += PERCPU_BLOCKS_PER_THREAD) {
+        for (int j = 0; j < PERCPU_BLOCKS_PER_THREAD; ++j) {
+            held[j] = a->alloc(a->ctx);
+            if (!held[j]) w->failures++;
+        }
+        for (int j = 0; j < PERCPU_BLOCKS_PER_THREAD; ++j) {
+            if (held[j]) a->free(a->ctx, held[j]);
+        }
+    }
+    return NULL;
+}
+
+static void run_percpu(const BenchAllocator* allocator, int n) {
+    pthread_t threads[n];
+    PercpuWorker workers[n];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, (unsigned)n + 1);
+
+    for (int t = 0; t < n; ++t) {
+        workers[t] = (PercpuWorker){.allocator = allocator, .barrier = &barrier};
+        pthread_create(&threads[t], NULL, percpu_worker, &workers[t]);
+    }
+
+    struct timespec start, end;
+    pthread_barrier_wait(&barrier);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long long failures = 0;
+    for (int t = 0; t < n; ++t) {
+        pthread_join(threads[t], NULL);
+        failures += workers[t].failures;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pthread_barrier_destroy(&barrier);
+
+    double total_ops = 2.0 * n * PERCPU_OPS_PER_THREAD;
+    long long elapsed = timespec_diff_ns(start, end);
+    printf("%-9s\t%d\t%.2f\t\t\t%.1f\t\t%lld\n", allocator->name, n,
+           total_ops / (double)elapsed * 1000.0, (double)elapsed * n / total_ops, failures);
+}
+
+void benchmark_percpu(int max_threads) {
+    printf("Benchmarking rseq per-CPU pool vs mutex pool vs CAS free list (unpinned threads)...\n");
+    printf("Allocator\tThreads\tThroughput (Mops/s)\tns/op per thread\tFailures\n");
+
+    for (int n = 1; n <= max_threads; n *= 2) {
+        size_t blocks = (size_t)n * PERCPU_BLOCKS_PER_THREAD * 4;
+        LockedPool locked = {.pool = pool_create(BLOCK_SIZE, blocks)};
+        MemoryPool* cas = pool_create_concurrent(BLOCK_SIZE, blocks);
+        MemoryPool* percpu = pool_create_ex(BLOCK_SIZE, blocks, POOL_PERCPU);
+        if (!locked.pool || !cas || !percpu) {
+            printf("Failed to create memory pools\n");
+            pool_destroy(locked.pool);
+            pool_destroy(cas);
+            pool_destroy(percpu);
+            return;
+        }
+        pthread_mutex_init(&locked.lock, NULL);
+
+        BenchAllocator allocators[] = {
+            {"mutex", locked_pool_alloc, locked_pool_free, &locked},
+            {"cas", concurrent_pool_alloc, concurrent_pool_free, cas},
+            {"percpu", concurrent_pool_alloc, concurrent_pool_free, percpu},
+        };
+        for (size_t i = 0; i < sizeof(allocators) / sizeof(allocators[0]); ++i) {
+            run_percpu(&allocators[i], n);
+        }
+
+        pthread_mutex_destroy(&locked.lock);
+        pool_destroy(locked.pool);
+        pool_destroy(cas);
+        pool_destroy(percpu);
+    }
+}
+
+// xorshift32: дешевый детерминированный генератор для рабочих нагрузок
+static uint32_t bench_rand(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Распределение размеров: в основном мелкие сообщения, изредка крупные
+static size_t mixed_message_size(uint32_t* rng) {
+    uint32_t bucket = bench_rand(rng) % 100;
+    uint32_t r = bench_rand(rng);
+    if (bucket < 50) return 32 + r % 97;     // 50%: 32..128
+    if (bucket < 80) return 129 + r % 384;   // 30%: 129..512
+    if (bucket < 95) return 513 + r % 1536;  // 15%: 513..2048
+    return 2049 + r % 2048;                  //  5%: 2049..4096
+}
+
+typedef struct {
+    void* ptr;
+    size_t size;
+} SlabObject;
+
+static SlabObject slab_objects[SLAB_LIVE_OBJECTS];
+
+// Держит SLAB_LIVE_OBJECTS живых объектов и на каждом шаге заменяет
+// случайный из них новым объектом случайного размера
+static void run_mixed_workload(const char* name, Slab* slab) {
+    OpLatency alloc_lat = {0}, free_lat = {0};
+    long long failures = 0;
+    size_t requested = 0, reserved = 0;
+    uint32_t rng = 2463534242u;
+
+    memset(slab_objects, 0, sizeof(slab_objects));
+    for (int step = 0; step < SLAB_STEPS; ++step) {
+        SlabObject* obj = &slab_objects[bench_rand(&rng) % SLAB_LIVE_OBJECTS];
+        if (obj->ptr) {
+            uint64_t start = rt_clock_start(&bench_clock);
+            if (slab) slab_free(slab, obj->ptr); else free(obj->ptr);
+            uint64_t end = rt_clock_end(&bench_clock);
+            op_latency_add(&free_lat, start, end);
+        }
+
+        obj->size = mixed_message_size(&rng);
+        uint64_t start = rt_clock_start(&bench_clock);
+        obj->ptr = slab ? slab_alloc(slab, obj->size) : malloc(obj->size);
+        uint64_t end = rt_clock_end(&bench_clock);
+        op_latency_add(&alloc_lat, start, end);
+        if (!obj->ptr) failures++;
+    }
+
+    // Внутренняя фрагментация на итоговом рабочем наборе
+    for (int i = 0; i < SLAB_LIVE_OBJECTS; ++i) {
+        if (!slab_objects[i].ptr) continue;
+        requested += slab_objects[i].size;
+        if (slab) reserved += slab_block_size(slab, slab_objects[i].ptr);
+        if (slab) slab_free(slab, slab_objects[i].ptr); else free(slab_objects[i].ptr);
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s: alloc", name);
+    op_latency_print(label, &alloc_lat);
+    snprintf(label, sizeof(label), "%s: free", name);
+    op_latency_print(label, &free_lat);
+    printf("%s: failures %lld\n", name, failures);
+    if (slab) {
+        printf("%s: live set %zu bytes requested, %zu bytes reserved (%.1f%% overhead)\n",
+               name, requested, reserved, 100.0 * (double)(reserved - requested) / (double)requested);
+    }
+}
+
+void benchmark_slab(int max_threads) {
+    (void)max_threads;
+    printf("Benchmarking slab allocator with mixed message sizes (32..4096 bytes)...\n");
+
+    run_mixed_workload("malloc", NULL);
+
+    Slab* slab = slab_create(32, 4096, SLAB_BYTES_PER_CLASS, 0);
+    if (!slab) {
+        printf("Failed to create slab\n");
+        return;
+    }
+    run_mixed_workload("slab", slab);
+    slab_destroy(slab);
+}
+
+// Аллокатор блоков произвольного размера для сравнения хвостов задержек
+typedef struct {
+    const char* name;
+    void* (*alloc)(void* ctx, size_t size);
+    void (*free)(void* ctx, void* block);
+    void* ctx;
+} VarAllocator;
+
+static void* var_malloc(void* ctx, size_t size) { (void)ctx; return malloc(size); }
+static void var_free(void* ctx, void* block) { (void)ctx; free(block); }
+static void* var_tlsf_malloc(void* ctx, size_t size) { return tlsf_malloc((Tlsf*)ctx, size); }
+static void var_tlsf_free(void* ctx, void* block) { tlsf_free((Tlsf*)ctx, block); }
+// MemoryPool покрывает переменные размеры только блоками максимального размера
+static void* var_pool_alloc(void* ctx, size_t size) { (void)size; return pool_alloc((MemoryPool*)ctx); }
+static void var_pool_free(void* ctx, void* block) { pool_free((MemoryPool*)ctx, block); }
+
+static long long tail_alloc_ns[SLAB_STEPS];
+static long long tail_free_ns[SLAB_STEPS];
+
+static int compare_ll(const void* a, const void* b) {
+    long long va = *(const long long*)a;
+    long long vb = *(const long long*)b;
+    return (va > vb) - (va < vb);
+}
+
+// Сортирует выборку и возвращает значение перцентиля per_10000 / 100 %
+static long long sorted_percentile(long long* samples, int count, int per_10000) {
+    qsort(samples, (size_t)count, sizeof(long long), compare_ll);
+    return samples[(long long)count * per_10000 / 10000];
+}
+
+static void run_tail_workload(const VarAllocator* allocator) {
+    int allocs = 0, frees = 0;
+    long long failures = 0;
+    OpLatency alloc_lat = {0}, free_lat = {0};
+    uint32_t rng = 2463534242u;
+
+    memset(slab_objects, 0, sizeof(slab_objects));
+    for (int step = 0; step < SLAB_STEPS; ++step) {
+        SlabObject* obj = &slab_objects[bench_rand(&rng) % SLAB_LIVE_OBJECTS];
+        if (obj->ptr) {
+            uint64_t start = rt_clock_start(&bench_clock);
+            allocator->free(allocator->ctx, obj->ptr);
+            uint64_t end = rt_clock_end(&bench_clock);
+            tail_free_ns[frees++] = op_latency_add(&free_lat, start, end);
+        }
+
+        obj->size = mixed_message_size(&rng);
+        uint64_t start = rt_clock_start(&bench_clock);
+        obj->ptr = allocator->alloc(allocator->ctx, obj->size);
+        uint64_t end = rt_clock_end(&bench_clock);
+        tail_alloc_ns[allocs++] = op_latency_add(&alloc_lat, start, end);
+        if (!obj->ptr) failures++;
+    }
+    for (int i = 0; i < SLAB_LIVE_OBJECTS; ++i) {
+        if (slab_objects[i].ptr) allocator->free(allocator->ctx, slab_objects[i].ptr);
+    }
+
+    long long alloc_p50 = sorted_percentile(tail_alloc_ns, allocs, 5000);
+    long long alloc_p9999 = sorted_percentile(tail_alloc_ns, allocs, 9999);
+    long long free_p50 = sorted_percentile(tail_free_ns, frees, 5000);
+    long long free_p9999 = sorted_percentile(tail_free_ns, frees, 9999);
+    printf("%-6s\t%lld\t%lld\t\t%lld/%lld\t%lld\t%lld\t\t%lld/%lld\t%lld\n", allocator->name,
+           alloc_p50, alloc_p9999, alloc_lat.max_raw, alloc_lat.max_corrected, free_p50, free_p9999,
+           free_lat.max_raw, free_lat.max_corrected, failures);
+}
+
+void benchmark_tlsf(int max_threads) {
+    (void)max_threads;
+    printf("Benchmarking variable-size allocation tails (32..4096 bytes, %d live objects, ns)...\n",
+           SLAB_LIVE_OBJECTS);
+
+    void* arena = mmap(NULL, TLSF_ARENA_BYTES, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    Tlsf* tlsf = arena != MAP_FAILED ? tlsf_create(arena, TLSF_ARENA_BYTES) : NULL;
+    MemoryPool* pool = pool_create_ex(4096, SLAB_LIVE_OBJECTS, POOL_POPULATE);
+    if (!tlsf || !pool) {
+        printf("Failed to create TLSF arena or memory pool\n");
+        if (arena != MAP_FAILED) munmap(arena, TLSF_ARENA_BYTES);
+        pool_destroy(pool);
+        return;
+    }
+    mlock(arena, TLSF_ARENA_BYTES);
+
+    const VarAllocator allocators[] = {
+        {"malloc", var_malloc, var_free, NULL},
+        {"pool", var_pool_alloc, var_pool_free, pool},
+        {"tlsf", var_tlsf_malloc, var_tlsf_free, tlsf},
+    };
+    // Перцентили — исправленные задержки, max — сырая/исправленная
+    printf("Alloc \talloc p50\tp99.99\t\tmax raw/corr\tfree p50\tp99.99\t\tmax raw/corr\tfailures\n");
+    for (size_t i = 0; i < sizeof(allocators) / sizeof(allocators[0]); ++i) {
+        run_tail_workload(&allocators[i]);
+    }
+
+    pool_destroy(pool);
+    munmap(arena, TLSF_ARENA_BYTES);
+}
+
+// Счетчик промахов dTLB на чтение для текущего потока; -1, если недоступен
+static int open_dtlb_miss_counter(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static const char* backing_name(PoolBacking backing) {
+    switch (backing) {
+    case POOL_BACKING_EXTERNAL: return "external";
+    case POOL_BACKING_MALLOC: return "malloc 4K";
+    case POOL_BACKING_PAGES: return "mmap 4K";
+    case POOL_BACKING_THP: return "THP";
+    case POOL_BACKING_HUGETLB: return "hugetlb";
+    }
+    return "?";
+}
+
+// Связать все блоки пула в один цикл в случайном порядке и пройти по нему:
+// каждое обращение зависит от предыдущего и попадает на случайную страницу
+static void run_tlb_walk(const char* name, unsigned flags) {
+    MemoryPool* pool = pool_create_ex(BLOCK_SIZE, TLB_BLOCK_COUNT, flags);
+    void** blocks = (void**)malloc(TLB_BLOCK_COUNT * sizeof(void*));
+    if (!pool || !blocks) {
+        printf("%-16s\tfailed to create pool\n", name);
+        pool_destroy(pool);
+        free(blocks);
+        return;
+    }
+
+    for (size_t i = 0; i < TLB_BLOCK_COUNT; ++i) {
+        blocks[i] = pool_alloc(pool);
+    }
+    uint32_t rng = 88172645u;
+    for (size_t i = TLB_BLOCK_COUNT - 1; i > 0; --i) {
+        size_t j = bench_rand(&rng) % (i + 1);
+        void* tmp = blocks[i];
+        blocks[i] = blocks[j];
+        blocks[j] = tmp;
+    }
+    for (size_t i = 0; i < TLB_BLOCK_COUNT; ++i) {
+        *(void**)blocks[i] = blocks[(i + 1) % TLB_BLOCK_COUNT];
+    }
+    void* volatile cursor = blocks[0];
+    free(blocks);
+
+    int fd = open_dtlb_miss_counter();
+    struct timespec start, end;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    void* p = cursor;
+    for (int i = 0; i < TLB_ACCESSES; ++i) {
+        p = *(void**)p;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    cursor = p;
+
+    long long misses = -1;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &misses, sizeof(misses)) != (ssize_t)sizeof(misses)) misses = -1;
+        close(fd);
+    }
+
+    double ns_per_access = (double)timespec_diff_ns(start, end) / TLB_ACCESSES;
+    if (misses >= 0) {
+        printf("%-16s\t%-10s\t%.1f\t\t%.3f\n", name, backing_name(pool_backing(pool)),
+               ns_per_access, (double)misses / TLB_ACCESSES);
+    } else {
+        printf("%-16s\t%-10s\t%.1f\t\tn/a\n", name, backing_name(pool_backing(pool)), ns_per_access);
+    }
+
+    // Блоки связаны в цикл, отдельный pool_free для них не нужен
+    pool_destroy(pool);
+}
+
+void benchmark_tlb(int max_threads) {
+    (void)max_threads;
+    printf("Benchmarking random block walk over %d x %d-byte pool...\n", TLB_BLOCK_COUNT, BLOCK_SIZE);
+    printf("Requested\t\tBacking\t\tns/access\tdTLB misses/access\n");
+
+    run_tlb_walk("malloc", 0);
+    run_tlb_walk("4K+populate", POOL_POPULATE);
+    run_tlb_walk("THP+populate", POOL_THP | POOL_POPULATE);
+    run_tlb_walk("hugetlb+populate", POOL_HUGETLB | POOL_POPULATE);
+}
+
+// Один цикл обработки пакетов: взять batch блоков и вернуть их.
+// Выделение и освобождение всей пачки засекаются отдельно.
+static void bulk_cycle(MemoryPool* pool, size_t batch, int use_bulk,
+                       OpLatency* alloc_lat, OpLatency* free_lat) {
+    void* blocks[BULK_MAX_BATCH];
+
+    uint64_t start = rt_clock_start(&bench_clock);
+    size_t got;
+    if (use_bulk) {
+        got = pool_alloc_bulk(pool, blocks, batch);
+    } else {
+        for (got = 0; got < batch; ++got) {
+            blocks[got] = pool_alloc(pool);
+            if (!blocks[got]) break;
+        }
+    }
+    uint64_t end = rt_clock_end(&bench_clock);
+    op_latency_add(alloc_lat, start, end);
+
+    start = rt_clock_start(&bench_clock);
+    if (use_bulk) {
+        pool_free_bulk(pool, blocks, got);
+    } else {
+        for (size_t i = 0; i < got; ++i) pool_free(pool, blocks[i]);
+    }
+    end = rt_clock_end(&bench_clock);
+    op_latency_add(free_lat, start, end);
+}
+
+static void run_bulk(const char* name, unsigned flags, size_t batch) {
+    MemoryPool* pool = pool_create_ex(BLOCK_SIZE, 4 * BULK_MAX_BATCH, flags);
+    if (!pool) {
+        printf("Failed to create memory pool\n");
+        return;
+    }
+
+    for (int use_bulk = 0; use_bulk <= 1; ++use_bulk) {
+        OpLatency alloc_lat = {0}, free_lat = {0};
+        for (int cycle = 0; cycle < BULK_CYCLES; ++cycle) {
+            bulk_cycle(pool, batch, use_bulk, &alloc_lat, &free_lat);
+        }
+        double blocks = (double)BULK_CYCLES * (double)batch;
+        printf("%-10s\t%zu\t%s\t%.2f/%.2f\t\t%.2f/%.2f\t\t%lld/%lld\n", name, batch,
+               use_bulk ? "bulk  " : "single", (double)alloc_lat.sum_raw / blocks,
+               (double)alloc_lat.sum_corrected / blocks, (double)free_lat.sum_raw / blocks,
+               (double)free_lat.sum_corrected / blocks, alloc_lat.max_raw, alloc_lat.max_corrected);
+    }
+    pool_destroy(pool);
+}
+
+void benchmark_bulk(int max_threads) {
+    (void)max_threads;
+    printf("Benchmarking batched pool_alloc_bulk/pool_free_bulk...\n");
+    printf("Pool      \tBatch\tAPI\talloc raw/corrected\tfree raw/corrected\tmax batch alloc raw/corrected\n");
+    printf("          \t\t\t(ns/block)\t\t(ns/block)\t\t(ns)\n");
+    static const size_t batches[] = {1, 8, 32, 64};
+    for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); ++i) {
+        run_bulk("plain", 0, batches[i]);
+        run_bulk("concurrent", POOL_CONCURRENT, batches[i]);
+    }
+}
+
+// Средняя стоимость пары pool_alloc + pool_free, нс. Засекается весь цикл
+// целиком: clock_gettime на каждую операцию стоил бы больше самой проверки.
+static double run_checked_loop(unsigned flags) {
+    MemoryPool* pool = pool_create_ex(BLOCK_SIZE, CHECKED_HELD, flags);
+    if (!pool) return -1.0;
+    void* held[CHECKED_HELD];
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int op = 0; op < CHECKED_OPS; op += CHECKED_HELD) {
+        for (int j = 0; j < CHECKED_HELD; ++j) held[j] = pool_alloc(pool);
+        for (int j = 0; j < CHECKED_HELD; ++j) pool_free(pool, held[j]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    pool_destroy(pool);
+    return (double)timespec_diff_ns(start, end) / CHECKED_OPS;
+}
+
+void benchmark_checked(int max_threads) {
+    (void)max_threads;
+    printf("Benchmarking POOL_CHECKED overhead...\n");
+    printf("Pool      \tunchecked ns/op\tchecked ns/op\toverhead\n");
+
+    static const struct {
+        const char* name;
+        unsigned flags;
+    } variants[] = {{"plain", 0}, {"concurrent", POOL_CONCURRENT}};
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); ++i) {
+        // Лучший из нескольких чередующихся прогонов: разница в пару нс
+        // иначе тонет в шуме планировщика
+        double unchecked = -1.0, checked = -1.0;
+        for (int run = 0; run < CHECKED_RUNS; ++run) {
+            double u = run_checked_loop(variants[i].flags);
+            double c = run_checked_loop(variants[i].flags | POOL_CHECKED);
+            if (unchecked < 0 || u < unchecked) unchecked = u;
+            if (checked < 0 || c < checked) checked = c;
+        }
+        printf("%-10s\t%.2f\t\t%.2f\t\t%+.1f%%\n", variants[i].name, unchecked, checked,
+               100.0 * (checked - unchecked) / unchecked);
+    }
+
+    // Ошибки, которые без проверок молча испортили бы список свободных блоков
+    MemoryPool* pool = pool_create_ex(BLOCK_SIZE, 4, POOL_CHECKED);
+    if (!pool) {
+        printf("Failed to create checked memory pool\n");
+        return;
+    }
+    void* a = pool_alloc(pool);
+    void* b = pool_alloc(pool);
+    char foreign[BLOCK_SIZE];
+    pool_free(pool, a);
+    pool_free(pool, a);                   // двойное освобождение
+    pool_free(pool, foreign);             // чужой указатель
+    pool_free(pool, (char*)b + 1);        // указатель внутрь блока
+    for (int i = 0; i < 5; ++i) pool_alloc(pool); // последний вызов не найдет блока
+
+    PoolStats stats;
+    pool_get_stats(pool, &stats);
+    printf("misuse demo: capacity %zu, live %zu, high-water %zu, alloc failures %lu, "
+           "double frees %lu, foreign frees %lu\n",
+           stats.capacity, stats.live, stats.high_water, stats.alloc_failures,
+           stats.double_frees, stats.foreign_frees);
+    pool_destroy(pool);
+}
+
+typedef struct {
+    uint64_t id;
+    uint64_t value;
+    char payload[HANDLE_OBJECT_SIZE - 2 * sizeof(uint64_t)];
+} HandleObject;
+
+static void handle_object_init(void* object, void* ctx) {
+    HandleObject* obj = (HandleObject*)object;
+    obj->id = (*(uint64_t*)ctx)++;
+    obj->value = obj->id * 3;
+}
+
+void benchmark_handles(int max_threads) {
+    (void)max_threads;
+    printf("Benchmarking generation-checked handles vs raw pointers (%d objects)...\n", HANDLE_OBJECTS);
+
+    uint64_t next_id = 0;
+    ObjectPool* objects = obj_pool_create(sizeof(HandleObject), HANDLE_OBJECTS, POOL_POPULATE,
+                                          handle_object_init, NULL, &next_id);
+    if (!objects) {
+        printf("Failed to create object pool\n");
+        return;
+    }
+    for (int i = 0; i < HANDLE_OBJECTS; ++i) {
+        handles[i] = obj_acquire(objects);
+        handle_ptrs[i] = obj_resolve(objects, handles[i]);
+    }
+
+    // Одинаковая случайная последовательность для обоих вариантов
+    struct timespec start, end;
+    uint64_t sum_ptr = 0, sum_handle = 0;
+    uint32_t rng = 2463534242u;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < HANDLE_ACCESSES; ++i) {
+        sum_ptr += ((HandleObject*)handle_ptrs[bench_rand(&rng) % HANDLE_OBJECTS])->value;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long long ptr_ns = timespec_diff_ns(start, end);
+
+    rng = 2463534242u;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < HANDLE_ACCESSES; ++i) {
+        HandleObject* obj = (HandleObject*)obj_resolve(objects, handles[bench_rand(&rng) % HANDLE_OBJECTS]);
+        sum_handle += obj->value;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long long handle_ns = timespec_diff_ns(start, end);
+
+    printf("Reference\tbytes/ref\treference set (MB)\tns/access\n");
+    printf("pointer  \t%zu\t\t%.1f\t\t\t%.2f\n", sizeof(void*),
+           (double)(HANDLE_OBJECTS * sizeof(void*)) / (1 << 20), (double)ptr_ns / HANDLE_ACCESSES);
+    printf("handle   \t%zu\t\t%.1f (+%.1f generations)\t%.2f\n", sizeof(ObjHandle),
+           (double)(HANDLE_OBJECTS * sizeof(ObjHandle)) / (1 << 20),
+           (double)(HANDLE_OBJECTS * sizeof(uint16_t)) / (1 << 20), (double)handle_ns / HANDLE_ACCESSES);
+    if (sum_ptr != sum_handle) printf("checksum mismatch: %llu vs %llu\n",
+                                      (unsigned long long)sum_ptr, (unsigned long long)sum_handle);
+
+    // Устаревший дескриптор после освобождения разрешается в NULL, а не в чужой объект
+    ObjHandle stale = handles[0];
+    obj_release(objects, stale);
+    ObjHandle reused = obj_acquire(objects);
+    printf("stale handle resolves to %s, second release returns %d, slot reused: %s\n",
+           obj_resolve(objects, stale) ? "object" : "NULL", obj_release(objects, stale),
+           (reused & OBJ_INDEX_MASK) == (stale & OBJ_INDEX_MASK) ? "yes" : "no");
+
+    obj_pool_destroy(objects);
+}
+
+static void* elastic_burst[ELASTIC_MAX_BURST];
+
+void benchmark_elastic(int max_threads) {
+    (void)max_threads;
+    printf("Benchmarking elastic pool under bursts of up to %d blocks...\n", ELASTIC_MAX_BURST);
+
+    PoolElasticConfig config = {
+        .initial_blocks = 1024,
+        .chunk_blocks = 1024,
+        .max_blocks = 16 * ELASTIC_MAX_BURST,
+        .low_watermark = 512,
+        .max_wait_ns = 1000000L,
+    };
+    MemoryPool* pool = pool_create_elastic(BLOCK_SIZE, &config);
+    if (!pool) {
+        printf("Failed to create elastic memory pool\n");
+        return;
+    }
+
+    struct timespec pause = {0, ELASTIC_PAUSE_NS};
+    OpLatency lat = {0};
+    uint32_t rng = 1234567u;
+
+    for (int burst = 0; burst < ELASTIC_BURSTS; ++burst) {
+        int n = 1 + (int)(bench_rand(&rng) % ELASTIC_MAX_BURST);
+        int got = 0;
+        for (; got < n; ++got) {
+            uint64_t start = rt_clock_start(&bench_clock);
+            elastic_burst[got] = pool_alloc(pool);
+            uint64_t end = rt_clock_end(&bench_clock);
+            op_latency_add(&lat, start, end);
+            if (!elastic_burst[got]) break;
+        }
+        pool_free_bulk(pool, elastic_burst, (size_t)got);
+        // Пауза между циклами дает фоновому потоку время на пополнение
+        nanosleep(&pause, NULL);
     }
 
+    PoolElasticStats stats;
+    pool_get_elastic_stats(pool, &stats);
+    op_latency_print("pool_alloc", &lat);
+    printf("capacity %zu blocks (started with %zu), refills %lu, lowest free count %ld\n",
+           stats.capacity, config.initial_blocks, stats.refills, stats.min_free_blocks);
+    printf("allocations that waited %lu, failed %lu\n", stats.waited_allocs, stats.failed_allocs);
+
+    pool_destroy(pool);
+}
+
+static void benchmark_single(int max_threads) {
+    (void)max_threads;
     benchmark_malloc();
     printf("\n");
     benchmark_mempool();
+}
+
+static const struct {
+    const char* name;
+    void (*run)(int max_threads);
+} sections[] = {
+    {"single", benchmark_single},
+    {"mt", benchmark_mempool_threads},
+    {"magazine", benchmark_magazine},
+    {"percpu", benchmark_percpu},
+    {"slab", benchmark_slab},
+    {"tlsf", benchmark_tlsf},
+    {"bulk", benchmark_bulk},
+    {"elastic", benchmark_elastic},
+    {"checked", benchmark_checked},
+    {"handles", benchmark_handles},
+    {"tlb", benchmark_tlb},
+};
+
+#define SECTION_COUNT (sizeof(sections) / sizeof(sections[0]))
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [all", prog);
+    for (size_t i = 0; i < SECTION_COUNT; ++i) {
+        fprintf(stderr, "|%s", sections[i].name);
+    }
+    fprintf(stderr, "] [max_threads]\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* mode = argc > 1 ? argv[1] : "all";
+    int max_threads = argc > 2 ? atoi(argv[2]) : MT_DEFAULT_MAX_THREADS;
+    if (max_threads < 1) max_threads = 1;
+
+    int run_all = strcmp(mode, "all") == 0;
+    int found = run_all;
+    for (size_t i = 0; i < SECTION_COUNT; ++i) {
+        if (strcmp(mode, sections[i].name) == 0) found = 1;
+    }
+    if (!found) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    RtMemConfig mem_config = {.stack_reserve = 256 * 1024};
+    if (rt_mem_prepare(&mem_config, NULL) != 0) {
+        perror("mlockall failed. Try with sudo");
+        return 1;
+    }
+    rt_clock_init(&bench_clock, 0);
+    rt_clock_print(&bench_clock);
+    printf("\n");
+
+    int first = 1;
+    for (size_t i = 0; i < SECTION_COUNT; ++i) {
+        if (!run_all && strcmp(mode, sections[i].name) != 0) continue;
+        if (!first) printf("\n");
+        sections[i].run(max_threads);
+        first = 0;
+    }
 
     return 0;
 }
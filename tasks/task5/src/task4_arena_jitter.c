@@ -0,0 +1,212 @@
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <time.h>
+#include "arena.h"
+#include "mempool.h"
+
+// Периодический цикл по образцу task2/src/sched_fifo_jitter.c
+#define PERIOD_NS 1000000LL
+#define DEFAULT_CYCLES 2000
+
+// Рабочая нагрузка одного цикла: временные буферы, которые умирают в конце цикла
+#define FRAME_SMALL_BUFFERS 32
+#define FRAME_SMALL_MIN 64
+#define FRAME_SMALL_MAX 4096
+#define FRAME_LARGE_SIZE (256 * 1024) // больше порога mmap в glibc malloc
+#define ARENA_CAPACITY (1024 * 1024)
+
+typedef enum { ALLOC_MALLOC, ALLOC_POOL, ALLOC_ARENA } AllocKind;
+
+typedef struct {
+    AllocKind kind;
+    MemoryPool* small_pool;
+    MemoryPool* large_pool;
+    Arena* arena;
+} FrameAllocator;
+
+typedef struct {
+    long long min, max, p99;
+    double avg;
+} Summary;
+
+static long long samples_wake[100000];
+static long long samples_work[100000];
+
+static inline long long timespec_to_ns(const struct timespec* ts) {
+    return (long long)ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+static uint32_t frame_rand(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static int compare_ll(const void* a, const void* b) {
+    long long va = *(const long long*)a;
+    long long vb = *(const long long*)b;
+    return (va > vb) - (va < vb);
+}
+
+static Summary summarize(long long* samples, int count) {
+    Summary s;
+    long long sum = 0;
+    qsort(samples, (size_t)count, sizeof(long long), compare_ll);
+    for (int i = 0; i < count; ++i) sum += samples[i];
+    s.min = samples[0];
+    s.max = samples[count - 1];
+    s.p99 = samples[(count * 99) / 100];
+    s.avg = (double)sum / count;
+    return s;
+}
+
+static void* frame_alloc(FrameAllocator* fa, size_t size) {
+    switch (fa->kind) {
+    case ALLOC_MALLOC:
+        return malloc(size);
+    case ALLOC_POOL:
+        return pool_alloc(size > FRAME_SMALL_MAX ? fa->large_pool : fa->small_pool);
+    case ALLOC_ARENA:
+        return arena_alloc(fa->arena, size);
+    }
+    return NULL;
+}
+
+// Для арены освобождение отдельного объекта не нужно
+static void frame_free(FrameAllocator* fa, void* ptr, size_t size) {
+    switch (fa->kind) {
+    case ALLOC_MALLOC:
+        free(ptr);
+        break;
+    case ALLOC_POOL:
+        pool_free(size > FRAME_SMALL_MAX ? fa->large_pool : fa->small_pool, ptr);
+        break;
+    case ALLOC_ARENA:
+        break;
+    }
+}
+
+// Один цикл управления: буферы под входные данные, вложенная область
+// с большим временным буфером, затем "обработка" малых буферов
+static void frame_work(FrameAllocator* fa, uint32_t* rng) {
+    void* buffers[FRAME_SMALL_BUFFERS];
+    size_t sizes[FRAME_SMALL_BUFFERS];
+
+    for (int i = 0; i < FRAME_SMALL_BUFFERS; ++i) {
+        sizes[i] = FRAME_SMALL_MIN + frame_rand(rng) % (FRAME_SMALL_MAX - FRAME_SMALL_MIN + 1);
+        buffers[i] = frame_alloc(fa, sizes[i]);
+        if (buffers[i]) memset(buffers[i], i, sizes[i]);
+    }
+
+    ArenaMark mark = fa->arena ? arena_mark(fa->arena) : 0;
+    char* scratch = (char*)frame_alloc(fa, FRAME_LARGE_SIZE);
+    if (scratch) {
+        memset(scratch, 0x5a, FRAME_LARGE_SIZE);
+        if (buffers[0]) ((char*)buffers[0])[0] = scratch[FRAME_LARGE_SIZE - 1];
+        frame_free(fa, scratch, FRAME_LARGE_SIZE);
+    }
+    if (fa->arena) arena_restore(fa->arena, mark);
+
+    for (int i = FRAME_SMALL_BUFFERS - 1; i >= 0; --i) {
+        if (buffers[i]) frame_free(fa, buffers[i], sizes[i]);
+    }
+    if (fa->arena) arena_reset(fa->arena);
+}
+
+static int run_periodic(const char* name, FrameAllocator* fa, int cycles) {
+    struct timespec next, now, done;
+    struct rusage usage_before, usage_after;
+    uint32_t rng = 88172645u;
+
+    // Первый цикл вне замера: прогрев кэшей и ленивой инициализации malloc
+    frame_work(fa, &rng);
+
+    getrusage(RUSAGE_SELF, &usage_before);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    long long next_ns = timespec_to_ns(&next) + PERIOD_NS;
+
+    for (int i = 0; i < cycles; ++i) {
+        next.tv_sec = (time_t)(next_ns / 1000000000LL);
+        next.tv_nsec = (long)(next_ns % 1000000000LL);
+        int rc;
+        do {
+            rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        } while (rc == EINTR);
+        if (rc != 0) {
+            fprintf(stderr, "clock_nanosleep: %s\n", strerror(rc));
+            return -1;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        frame_work(fa, &rng);
+        clock_gettime(CLOCK_MONOTONIC, &done);
+
+        samples_wake[i] = timespec_to_ns(&now) - next_ns;
+        samples_work[i] = timespec_to_ns(&done) - timespec_to_ns(&now);
+        next_ns += PERIOD_NS;
+    }
+    getrusage(RUSAGE_SELF, &usage_after);
+
+    Summary wake = summarize(samples_wake, cycles);
+    Summary work = summarize(samples_work, cycles);
+    printf("%-7s\twake\t%lld\t%.0f\t%lld\t%lld\n", name, wake.min, wake.avg, wake.p99, wake.max);
+    printf("%-7s\twork\t%lld\t%.0f\t%lld\t%lld\t(minor faults %ld)\n", name, work.min, work.avg,
+           work.p99, work.max, usage_after.ru_minflt - usage_before.ru_minflt);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int cycles = argc > 1 ? atoi(argv[1]) : DEFAULT_CYCLES;
+    if (cycles <= 0 || cycles > (int)(sizeof(samples_wake) / sizeof(samples_wake[0]))) {
+        fprintf(stderr, "Usage: %s [cycles (1..%zu)]\n", argv[0],
+                sizeof(samples_wake) / sizeof(samples_wake[0]));
+        return 1;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    printf("Task 4: Per-cycle allocations in a periodic loop (malloc vs MemoryPool vs arena)\n");
+
+    struct sched_param sp = {.sched_priority = 50};
+    if (sched_setscheduler(0, SCHED_FIFO, &sp) != 0) {
+        perror("WARNING: sched_setscheduler failed; continuing with default scheduler");
+    }
+    // Без MCL_FUTURE: иначе malloc на каждом цикле блокировал бы и прогревал
+    // новые mmap-страницы, а задача — показать именно поведение malloc
+    if (mlockall(MCL_CURRENT) != 0) {
+        perror("WARNING: mlockall failed");
+    }
+
+    FrameAllocator fa_malloc = {.kind = ALLOC_MALLOC};
+    FrameAllocator fa_pool = {
+        .kind = ALLOC_POOL,
+        .small_pool = pool_create_ex(FRAME_SMALL_MAX, FRAME_SMALL_BUFFERS, POOL_POPULATE),
+        .large_pool = pool_create_ex(FRAME_LARGE_SIZE, 1, POOL_POPULATE),
+    };
+    FrameAllocator fa_arena = {.kind = ALLOC_ARENA, .arena = arena_create(ARENA_CAPACITY)};
+    if (!fa_pool.small_pool || !fa_pool.large_pool || !fa_arena.arena) {
+        printf("Failed to create allocators\n");
+        return 1;
+    }
+
+    printf("%d cycles, period %lld us, %d buffers of %d..%d bytes + %d KB scratch per cycle\n",
+           cycles, PERIOD_NS / 1000, FRAME_SMALL_BUFFERS, FRAME_SMALL_MIN, FRAME_SMALL_MAX,
+           FRAME_LARGE_SIZE / 1024);
+    printf("Alloc\tPhase\tmin(ns)\tavg(ns)\tp99(ns)\tmax(ns)\n");
+    if (run_periodic("malloc", &fa_malloc, cycles) != 0) return 1;
+    if (run_periodic("pool", &fa_pool, cycles) != 0) return 1;
+    if (run_periodic("arena", &fa_arena, cycles) != 0) return 1;
+    printf("arena high-water %zu bytes, failed allocations %lu\n",
+           arena_high_water(fa_arena.arena), arena_failures(fa_arena.arena));
+
+    pool_destroy(fa_pool.small_pool);
+    pool_destroy(fa_pool.large_pool);
+    arena_destroy(fa_arena.arena);
+    return 0;
+}
@@ -0,0 +1,310 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include "probe.h"
+#include "rt_prefault.h"
+
+// Способы подготовки одного и того же анонимного региона к работе без faults.
+// Сравниваются время подготовки, число faults при подготовке и при
+// последующем проходе по региону (он повторяет доступ из цикла реального времени)
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23 // Linux 5.14+
+#endif
+#ifndef MLOCK_ONFAULT
+#define MLOCK_ONFAULT 0x01
+#endif
+
+#define PAGE_SIZE 4096
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+#define DEFAULT_MAX_MB 4096
+#define DEFAULT_PARALLEL_MB 1024
+#define MB (1024UL * 1024)
+
+typedef enum {
+    PREFAULT_TOUCH,      // цикл записи по байту в каждую страницу
+    PREFAULT_POPULATE,   // mmap(MAP_POPULATE)
+    PREFAULT_MADVISE,    // madvise(MADV_POPULATE_WRITE)
+    PREFAULT_MLOCK,      // mlock() без ручного прогрева
+    PREFAULT_ONFAULT,    // mlock2(MLOCK_ONFAULT) — региональный аналог MCL_ONFAULT
+    PREFAULT_THP,        // madvise(MADV_HUGEPAGE) + цикл записи по 2 МБ
+    PREFAULT_METHOD_COUNT
+} PrefaultMethod;
+
+static const char* method_names[PREFAULT_METHOD_COUNT] = {
+    "touch", "MAP_POPULATE", "POPULATE_WRITE", "mlock", "MCL_ONFAULT", "THP+touch",
+};
+
+typedef struct {
+    int ok;
+    double prep_ms;
+    uint64_t prep_faults;
+    double access_ms;
+    uint64_t access_faults;
+    unsigned long huge_kb;
+} PrefaultResult;
+
+static const size_t default_sizes_mb[] = {64, 256, 1024, 2048, 4096};
+static const int parallel_threads[] = {1, 2, 4, 8};
+
+static inline long long timespec_to_ns(const struct timespec* ts) {
+    return (long long)ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return timespec_to_ns(&ts);
+}
+
+// Возвращает значение поля из /proc/meminfo-подобного файла в КБ или 0
+static unsigned long read_kb_field(const char* path, const char* field) {
+    FILE* f = fopen(path, "r");
+    if (!f) return 0;
+    char line[256];
+    unsigned long value = 0;
+    size_t len = strlen(field);
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, field, len) == 0 && line[len] == ':') {
+            value = strtoul(line + len + 1, NULL, 10);
+            break;
+        }
+    }
+    fclose(f);
+    return value;
+}
+
+// Запись по байту с шагом stride; volatile не дает компилятору выбросить цикл
+static void touch_region(char* region, size_t size, size_t stride) {
+    volatile char* p = region;
+    for (size_t offset = 0; offset < size; offset += stride) {
+        p[offset] = 1;
+    }
+}
+
+// Отображает регион, для THP — выровненный по 2 МБ, чтобы все его части
+// могли получить большие страницы. Настоящее начало отображения и его
+// длина возвращаются через base/length для munmap
+static char* map_region(PrefaultMethod method, size_t size, void** base, size_t* length) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (method == PREFAULT_POPULATE) flags |= MAP_POPULATE;
+    *length = method == PREFAULT_THP ? size + HUGE_PAGE_SIZE : size;
+
+    *base = mmap(NULL, *length, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (*base == MAP_FAILED) return NULL;
+    if (method != PREFAULT_THP) return *base;
+
+    uintptr_t aligned = ((uintptr_t)*base + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    if (madvise((void*)aligned, size, MADV_HUGEPAGE) != 0) {
+        munmap(*base, *length);
+        return NULL;
+    }
+    return (char*)aligned;
+}
+
+static int prefault_region(PrefaultMethod method, char* region, size_t size) {
+    switch (method) {
+    case PREFAULT_TOUCH:
+        touch_region(region, size, PAGE_SIZE);
+        return 0;
+    case PREFAULT_POPULATE:
+        return 0; // вся работа сделана в mmap
+    case PREFAULT_MADVISE:
+        return madvise(region, size, MADV_POPULATE_WRITE);
+    case PREFAULT_MLOCK:
+        return mlock(region, size);
+    case PREFAULT_ONFAULT:
+        return mlock2(region, size, MLOCK_ONFAULT);
+    case PREFAULT_THP:
+        // Первый fault в выровненном окне выделяет сразу 2 МБ; если большой
+        // страницы не нашлось, остальные 4К-страницы окна дотронет проход доступа
+        touch_region(region, size, HUGE_PAGE_SIZE);
+        return 0;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+}
+
+static PrefaultResult run_method(Probe* probe, PrefaultMethod method, size_t size) {
+    PrefaultResult result = {0};
+    ProbeSample before, after, delta;
+    void* base;
+    size_t length;
+
+    // mmap входит в замер: для MAP_POPULATE именно там и происходит прогрев
+    probe_read(probe, &before);
+    long long start = now_ns();
+    char* region = map_region(method, size, &base, &length);
+    if (!region) {
+        fprintf(stderr, "%s: mmap failed: %s\n", method_names[method], strerror(errno));
+        return result;
+    }
+    if (prefault_region(method, region, size) != 0) {
+        fprintf(stderr, "%s: %s\n", method_names[method], strerror(errno));
+        munmap(base, length);
+        return result;
+    }
+    long long end = now_ns();
+    probe_read(probe, &after);
+    probe_delta(&before, &after, &delta);
+    result.prep_ms = (end - start) / 1e6;
+    result.prep_faults = delta.values[PROBE_PAGE_FAULTS];
+    result.huge_kb = read_kb_field("/proc/self/smaps_rollup", "AnonHugePages");
+
+    // Проход как в цикле реального времени: запись в каждую 4К-страницу
+    probe_read(probe, &before);
+    start = now_ns();
+    touch_region(region, size, PAGE_SIZE);
+    end = now_ns();
+    probe_read(probe, &after);
+    probe_delta(&before, &after, &delta);
+    result.access_ms = (end - start) / 1e6;
+    result.access_faults = delta.values[PROBE_PAGE_FAULTS];
+
+    munmap(base, length); // снимает и mlock
+    result.ok = 1;
+    return result;
+}
+
+// Время от mmap до готового к работе региона; faults — у вызывающего потока
+static void print_startup(const char* name, int threads, long long startup_ns, long long ready_ns,
+                          uint64_t faults, long long serial_ns) {
+    printf("%-12s %8d %12.1f %12.1f %10lu %8.2fx\n", name, threads, startup_ns / 1e6, ready_ns / 1e6,
+           (unsigned long)faults, (double)serial_ns / ready_ns);
+}
+
+static int run_parallel(Probe* probe, size_t size_mb) {
+    size_t size = size_mb * MB;
+    ProbeSample before, after, delta;
+    int cpus[RT_PREFAULT_MAX_THREADS];
+    int cpu_count = rt_prefault_housekeeping_cpus(cpus, RT_PREFAULT_MAX_THREADS);
+    printf("Parallel prefault of %zu MB, mlock2(MLOCK_ONFAULT), %d housekeeping CPU(s)\n\n", size_mb,
+           cpu_count);
+    printf("%-12s %8s %12s %12s %10s %9s\n", "Mode", "threads", "startup ms", "ready ms", "faults",
+           "speedup");
+
+    // Эталон: последовательный цикл записи, как в task2_mlock
+    void* region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED || mlock2(region, size, MLOCK_ONFAULT) != 0) {
+        perror("serial: mmap/mlock2 failed");
+        return 1;
+    }
+    probe_read(probe, &before);
+    long long start = now_ns();
+    touch_region(region, size, PAGE_SIZE);
+    long long serial_ns = now_ns() - start;
+    probe_read(probe, &after);
+    probe_delta(&before, &after, &delta);
+    munmap(region, size);
+    print_startup("serial", 1, serial_ns, serial_ns, delta.values[PROBE_PAGE_FAULTS], serial_ns);
+
+    for (size_t t = 0; t < sizeof(parallel_threads) / sizeof(parallel_threads[0]); ++t) {
+        for (int lazy = 0; lazy <= 1; ++lazy) {
+            region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (region == MAP_FAILED) {
+                perror("mmap failed");
+                return 1;
+            }
+            RtPrefaultConfig config = {.threads = parallel_threads[t], .lock = 1, .numa_node = -1};
+            RtPrefaultStats stats;
+            probe_read(probe, &before);
+            start = now_ns();
+            // Ленивый режим: инициализация продолжается сразу, RT-часть ждет барьера
+            RtPrefaultJob* job = rt_prefault_start(region, size, &config);
+            long long startup_ns = now_ns() - start;
+            if (!job || (!lazy && rt_prefault_wait(job) != 0)) {
+                perror("rt_prefault failed");
+                return 1;
+            }
+            if (!lazy) startup_ns = now_ns() - start;
+            rt_prefault_wait(job);
+            long long ready_ns = now_ns() - start;
+            rt_prefault_finish(job, &stats);
+            touch_region(region, size, PAGE_SIZE);
+            probe_read(probe, &after);
+            probe_delta(&before, &after, &delta);
+            munmap(region, size);
+            print_startup(lazy ? "lazy" : "parallel", stats.threads, startup_ns, ready_ns,
+                          delta.values[PROBE_PAGE_FAULTS], serial_ns);
+        }
+    }
+    return 0;
+}
+
+// Одна строка таблицы на каждый метод для региона size_mb
+static void run_size(Probe* probe, size_t size_mb, unsigned long available_mb) {
+    if (available_mb && size_mb > available_mb / 2) {
+        printf("%-8zu skipped: more than half of MemAvailable\n", size_mb);
+        return;
+    }
+    for (int m = 0; m < PREFAULT_METHOD_COUNT; ++m) {
+        PrefaultResult r = run_method(probe, (PrefaultMethod)m, size_mb * MB);
+        if (!r.ok) {
+            printf("%-8zu %-15s %10s\n", size_mb, method_names[m], "n/a");
+            continue;
+        }
+        printf("%-8zu %-15s %10.1f %12lu %10.1f %12lu %8lu %s\n", size_mb, method_names[m],
+               r.prep_ms, (unsigned long)r.prep_faults, r.access_ms,
+               (unsigned long)r.access_faults, r.huge_kb / 1024,
+               r.access_faults ? "yes" : "no");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int parallel = argc > 1 && strcmp(argv[1], "--parallel") == 0;
+    const char* size_arg = argc > 1 + parallel ? argv[1 + parallel] : NULL;
+    size_t max_mb = size_arg ? strtoul(size_arg, NULL, 10) : parallel ? DEFAULT_PARALLEL_MB : DEFAULT_MAX_MB;
+    if (max_mb < 1) {
+        fprintf(stderr, "Usage: %s [max region size in MB, default %d]\n"
+                        "       %s --parallel [region size in MB, default %d]\n",
+                argv[0], DEFAULT_MAX_MB, argv[0], DEFAULT_PARALLEL_MB);
+        return 1;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    printf("Task 5: Prefault strategies (touch vs MAP_POPULATE vs MADV_POPULATE_WRITE vs mlock vs MCL_ONFAULT vs THP)\n");
+
+    Probe* probe = probe_open();
+    if (!probe) {
+        perror("probe_open failed");
+        return 1;
+    }
+    // Faults считаются только те, что поток получил как исключение процессора.
+    // Страницы, заполненные ядром внутри mmap/madvise/mlock, в них не попадают
+    printf("Fault counter: %s\n", probe_uses_perf(probe) ? "perf page-faults" : "getrusage minflt+majflt");
+
+    FILE* thp = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (thp) {
+        char mode[128] = "";
+        if (fgets(mode, sizeof(mode), thp)) printf("THP: %s", mode);
+        fclose(thp);
+    }
+
+    // Регион не должен вытеснять остальную систему: берем не больше половины доступной памяти
+    unsigned long available_mb = read_kb_field("/proc/meminfo", "MemAvailable") / 1024;
+    printf("MemAvailable %lu MB, max region %zu MB\n\n", available_mb, max_mb);
+    if (parallel) {
+        if (available_mb && max_mb > available_mb / 2) max_mb = available_mb / 2;
+        int rc = run_parallel(probe, max_mb);
+        probe_close(probe);
+        return rc;
+    }
+    printf("%-8s %-15s %10s %12s %10s %12s %8s %s\n", "Size MB", "Method", "prep ms", "prep faults",
+           "access ms", "acc faults", "THP MB", "later faults");
+
+    // Шкала размеров меньше max_mb, последней строкой — сам max_mb, так что
+    // даже max_mb меньше первого размера шкалы дает один замер
+    size_t size_count = sizeof(default_sizes_mb) / sizeof(default_sizes_mb[0]);
+    for (size_t s = 0; s < size_count && default_sizes_mb[s] < max_mb; ++s) {
+        run_size(probe, default_sizes_mb[s], available_mb);
+    }
+    run_size(probe, max_mb, available_mb);
+
+    probe_close(probe);
+    return 0;
+}
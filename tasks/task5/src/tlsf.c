@@ -0,0 +1,347 @@
+#include "tlsf.h"
+#include <stdint.h>
+
+// Параметры сетки классов (64-битная платформа)
+#define ALIGN_SIZE_LOG2 3
+#define ALIGN_SIZE ((size_t)1 << ALIGN_SIZE_LOG2)
+#define SL_INDEX_COUNT_LOG2 5
+#define SL_INDEX_COUNT (1 << SL_INDEX_COUNT_LOG2)
+#define FL_INDEX_MAX 32
+#define FL_INDEX_SHIFT (SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2)
+#define FL_INDEX_COUNT (FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+#define SMALL_BLOCK_SIZE ((size_t)1 << FL_INDEX_SHIFT)
+
+// Младшие биты поля size (размеры кратны 8)
+#define BLOCK_FREE_BIT ((size_t)1)
+#define BLOCK_PREV_FREE_BIT ((size_t)2)
+#define BLOCK_FLAGS (BLOCK_FREE_BIT | BLOCK_PREV_FREE_BIT)
+
+// Заголовок блока. prev_phys лежит в последнем слове предыдущего блока
+// и действителен, только если тот свободен; next_free/prev_free занимают
+// полезную часть свободного блока. Накладные расходы занятого блока —
+// одно поле size.
+typedef struct TlsfBlock {
+    struct TlsfBlock* prev_phys;
+    size_t size;
+    struct TlsfBlock* next_free;
+    struct TlsfBlock* prev_free;
+} TlsfBlock;
+
+#define BLOCK_OVERHEAD sizeof(size_t)
+#define BLOCK_START_OFFSET (offsetof(TlsfBlock, size) + sizeof(size_t))
+#define BLOCK_SIZE_MIN (sizeof(TlsfBlock) - sizeof(TlsfBlock*))
+#define BLOCK_SIZE_MAX ((size_t)1 << FL_INDEX_MAX)
+
+struct Tlsf {
+    TlsfBlock block_null;   // пустой список указывает сюда, а не на NULL
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[FL_INDEX_COUNT];
+    TlsfBlock* blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+    size_t free_bytes;
+};
+
+static inline int fls_size(size_t x) {
+    return (int)(sizeof(unsigned long) * 8) - 1 - __builtin_clzl(x);
+}
+
+static inline int ffs_u32(uint32_t x) {
+    return x ? __builtin_ctz(x) : -1;
+}
+
+static inline size_t align_up(size_t x, size_t align) {
+    return (x + align - 1) & ~(align - 1);
+}
+
+static inline size_t block_size(const TlsfBlock* block) {
+    return block->size & ~BLOCK_FLAGS;
+}
+
+static inline void block_set_size(TlsfBlock* block, size_t size) {
+    block->size = size | (block->size & BLOCK_FLAGS);
+}
+
+static inline int block_is_last(const TlsfBlock* block) {
+    return block_size(block) == 0;
+}
+
+static inline int block_is_free(const TlsfBlock* block) {
+    return (block->size & BLOCK_FREE_BIT) != 0;
+}
+
+static inline int block_is_prev_free(const TlsfBlock* block) {
+    return (block->size & BLOCK_PREV_FREE_BIT) != 0;
+}
+
+static inline void* block_to_ptr(const TlsfBlock* block) {
+    return (char*)block + BLOCK_START_OFFSET;
+}
+
+static inline TlsfBlock* block_from_ptr(const void* ptr) {
+    return (TlsfBlock*)((char*)ptr - BLOCK_START_OFFSET);
+}
+
+static inline TlsfBlock* block_next(const TlsfBlock* block) {
+    return (TlsfBlock*)((char*)block_to_ptr(block) + block_size(block) - BLOCK_OVERHEAD);
+}
+
+// Сообщить следующему блоку адрес текущего (для слияния при его освобождении)
+static inline TlsfBlock* block_link_next(TlsfBlock* block) {
+    TlsfBlock* next = block_next(block);
+    next->prev_phys = block;
+    return next;
+}
+
+static inline void block_mark_free(TlsfBlock* block) {
+    TlsfBlock* next = block_link_next(block);
+    next->size |= BLOCK_PREV_FREE_BIT;
+    block->size |= BLOCK_FREE_BIT;
+}
+
+static inline void block_mark_used(TlsfBlock* block) {
+    TlsfBlock* next = block_next(block);
+    next->size &= ~BLOCK_PREV_FREE_BIT;
+    block->size &= ~BLOCK_FREE_BIT;
+}
+
+// Класс (fl, sl), в который попадает блок размера size
+static inline void mapping_insert(size_t size, int* fl, int* sl) {
+    if (size < SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = (int)(size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+    } else {
+        int f = fls_size(size);
+        *sl = (int)(size >> (f - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+        *fl = f - (FL_INDEX_SHIFT - 1);
+    }
+}
+
+// Класс, любой блок которого не меньше size: размер округляется вверх
+// до границы следующего класса, поэтому поиск не перебирает список
+static inline void mapping_search(size_t size, int* fl, int* sl) {
+    if (size >= SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (fls_size(size) - SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static TlsfBlock* search_suitable_block(Tlsf* tlsf, int* fl, int* sl) {
+    uint32_t sl_map = tlsf->sl_bitmap[*fl] & (~0u << *sl);
+    if (!sl_map) {
+        uint32_t fl_map = *fl + 1 < 32 ? tlsf->fl_bitmap & (~0u << (*fl + 1)) : 0;
+        if (!fl_map) return NULL;
+        *fl = ffs_u32(fl_map);
+        sl_map = tlsf->sl_bitmap[*fl];
+    }
+    *sl = ffs_u32(sl_map);
+    return tlsf->blocks[*fl][*sl];
+}
+
+static void remove_free_block(Tlsf* tlsf, TlsfBlock* block, int fl, int sl) {
+    TlsfBlock* prev = block->prev_free;
+    TlsfBlock* next = block->next_free;
+    next->prev_free = prev;
+    prev->next_free = next;
+
+    if (tlsf->blocks[fl][sl] == block) {
+        tlsf->blocks[fl][sl] = next;
+        if (next == &tlsf->block_null) {
+            tlsf->sl_bitmap[fl] &= ~(1u << sl);
+            if (!tlsf->sl_bitmap[fl]) tlsf->fl_bitmap &= ~(1u << fl);
+        }
+    }
+    tlsf->free_bytes -= block_size(block);
+}
+
+static void insert_free_block(Tlsf* tlsf, TlsfBlock* block, int fl, int sl) {
+    TlsfBlock* current = tlsf->blocks[fl][sl];
+    block->next_free = current;
+    block->prev_free = &tlsf->block_null;
+    current->prev_free = block;
+    tlsf->blocks[fl][sl] = block;
+    tlsf->fl_bitmap |= 1u << fl;
+    tlsf->sl_bitmap[fl] |= 1u << sl;
+    tlsf->free_bytes += block_size(block);
+}
+
+static void block_remove(Tlsf* tlsf, TlsfBlock* block) {
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    remove_free_block(tlsf, block, fl, sl);
+}
+
+static void block_insert(Tlsf* tlsf, TlsfBlock* block) {
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    insert_free_block(tlsf, block, fl, sl);
+}
+
+static int block_can_split(const TlsfBlock* block, size_t size) {
+    return block_size(block) >= sizeof(TlsfBlock) + size;
+}
+
+// Отрезать от блока хвост после первых size байт; хвост становится свободным
+static TlsfBlock* block_split(TlsfBlock* block, size_t size) {
+    TlsfBlock* remaining = (TlsfBlock*)((char*)block_to_ptr(block) + size - BLOCK_OVERHEAD);
+    size_t remain_size = block_size(block) - (size + BLOCK_OVERHEAD);
+    block_set_size(remaining, remain_size);
+    block_set_size(block, size);
+    block_mark_free(remaining);
+    return remaining;
+}
+
+// Присоединить block к предыдущему соседу prev
+static TlsfBlock* block_absorb(TlsfBlock* prev, TlsfBlock* block) {
+    prev->size += block_size(block) + BLOCK_OVERHEAD;
+    block_link_next(prev);
+    return prev;
+}
+
+static TlsfBlock* block_merge_prev(Tlsf* tlsf, TlsfBlock* block) {
+    if (block_is_prev_free(block)) {
+        TlsfBlock* prev = block->prev_phys;
+        block_remove(tlsf, prev);
+        block = block_absorb(prev, block);
+    }
+    return block;
+}
+
+static TlsfBlock* block_merge_next(Tlsf* tlsf, TlsfBlock* block) {
+    TlsfBlock* next = block_next(block);
+    if (block_is_free(next)) {
+        block_remove(tlsf, next);
+        block = block_absorb(block, next);
+    }
+    return block;
+}
+
+// Вернуть в списки неиспользованный хвост свободного блока
+static void block_trim_free(Tlsf* tlsf, TlsfBlock* block, size_t size) {
+    if (block_can_split(block, size)) {
+        TlsfBlock* remaining = block_split(block, size);
+        block_link_next(block);
+        remaining->size |= BLOCK_PREV_FREE_BIT;
+        block_insert(tlsf, remaining);
+    }
+}
+
+// Отделить начало блока (для выравнивания) и вернуть его в списки
+static TlsfBlock* block_trim_free_leading(Tlsf* tlsf, TlsfBlock* block, size_t size) {
+    TlsfBlock* remaining = block;
+    if (block_can_split(block, size)) {
+        remaining = block_split(block, size - BLOCK_OVERHEAD);
+        remaining->size |= BLOCK_PREV_FREE_BIT;
+        block_link_next(block);
+        block_insert(tlsf, block);
+    }
+    return remaining;
+}
+
+static TlsfBlock* block_locate_free(Tlsf* tlsf, size_t size) {
+    int fl, sl;
+    mapping_search(size, &fl, &sl);
+    if (fl >= FL_INDEX_COUNT) return NULL;
+
+    TlsfBlock* block = search_suitable_block(tlsf, &fl, &sl);
+    if (!block || block == &tlsf->block_null) return NULL;
+    remove_free_block(tlsf, block, fl, sl);
+    return block;
+}
+
+static void* block_prepare_used(Tlsf* tlsf, TlsfBlock* block, size_t size) {
+    block_trim_free(tlsf, block, size);
+    block_mark_used(block);
+    return block_to_ptr(block);
+}
+
+// Размер запроса с учетом выравнивания и минимального блока; 0 — не выделять
+static size_t adjust_request_size(size_t size, size_t align) {
+    if (size == 0 || size >= BLOCK_SIZE_MAX) return 0;
+    size_t adjusted = align_up(size, align);
+    if (adjusted >= BLOCK_SIZE_MAX) return 0;
+    return adjusted > BLOCK_SIZE_MIN ? adjusted : BLOCK_SIZE_MIN;
+}
+
+Tlsf* tlsf_create(void* memory, size_t bytes) {
+    if (!memory || ((uintptr_t)memory % ALIGN_SIZE) != 0) return NULL;
+
+    size_t control_size = align_up(sizeof(Tlsf), ALIGN_SIZE);
+    if (bytes < control_size + sizeof(TlsfBlock) + 2 * BLOCK_OVERHEAD) return NULL;
+    // Служебные слова: size первого блока и нулевой блок-ограничитель в конце
+    size_t pool_bytes = (bytes - control_size - 2 * BLOCK_OVERHEAD) & ~(ALIGN_SIZE - 1);
+    if (pool_bytes < BLOCK_SIZE_MIN || pool_bytes >= BLOCK_SIZE_MAX) return NULL;
+
+    Tlsf* tlsf = (Tlsf*)memory;
+    tlsf->block_null.next_free = &tlsf->block_null;
+    tlsf->block_null.prev_free = &tlsf->block_null;
+    tlsf->fl_bitmap = 0;
+    tlsf->free_bytes = 0;
+    for (int i = 0; i < FL_INDEX_COUNT; ++i) {
+        tlsf->sl_bitmap[i] = 0;
+        for (int j = 0; j < SL_INDEX_COUNT; ++j) {
+            tlsf->blocks[i][j] = &tlsf->block_null;
+        }
+    }
+
+    // prev_phys первого блока пересекается с концом управляющей структуры,
+    // но никогда не читается: у первого блока нет предыдущего
+    TlsfBlock* block = (TlsfBlock*)((char*)memory + control_size - BLOCK_OVERHEAD);
+    block->size = pool_bytes;
+    block->size |= BLOCK_FREE_BIT;
+    block_insert(tlsf, block);
+
+    TlsfBlock* sentinel = block_link_next(block);
+    sentinel->size = BLOCK_PREV_FREE_BIT;
+    return tlsf;
+}
+
+void* tlsf_malloc(Tlsf* tlsf, size_t size) {
+    size_t adjusted = adjust_request_size(size, ALIGN_SIZE);
+    if (!adjusted) return NULL;
+    TlsfBlock* block = block_locate_free(tlsf, adjusted);
+    return block ? block_prepare_used(tlsf, block, adjusted) : NULL;
+}
+
+void* tlsf_memalign(Tlsf* tlsf, size_t align, size_t size) {
+    if (align <= ALIGN_SIZE) return tlsf_malloc(tlsf, size);
+    if ((align & (align - 1)) != 0) return NULL;
+
+    size_t adjusted = adjust_request_size(size, ALIGN_SIZE);
+    if (!adjusted) return NULL;
+    // Запас на выравнивание: перед выровненным адресом должен поместиться
+    // свободный блок, иначе отрезанное начало некуда вернуть
+    const size_t gap_minimum = sizeof(TlsfBlock);
+    size_t with_gap = adjust_request_size(adjusted + align + gap_minimum, align);
+    if (!with_gap) return NULL;
+
+    TlsfBlock* block = block_locate_free(tlsf, with_gap);
+    if (!block) return NULL;
+
+    uintptr_t ptr = (uintptr_t)block_to_ptr(block);
+    uintptr_t aligned = align_up(ptr, align);
+    size_t gap = (size_t)(aligned - ptr);
+    if (gap && gap < gap_minimum) {
+        size_t gap_remain = gap_minimum - gap;
+        size_t offset = gap_remain > align ? gap_remain : align;
+        aligned = align_up(aligned + offset, align);
+        gap = (size_t)(aligned - ptr);
+    }
+    if (gap) block = block_trim_free_leading(tlsf, block, gap);
+    return block_prepare_used(tlsf, block, adjusted);
+}
+
+void tlsf_free(Tlsf* tlsf, void* ptr) {
+    if (!ptr) return;
+    TlsfBlock* block = block_from_ptr(ptr);
+    block_mark_free(block);
+    block = block_merge_prev(tlsf, block);
+    block = block_merge_next(tlsf, block);
+    block_insert(tlsf, block);
+}
+
+size_t tlsf_block_size(const void* ptr) {
+    return block_size(block_from_ptr(ptr));
+}
+
+size_t tlsf_free_bytes(const Tlsf* tlsf) {
+    return tlsf->free_bytes;
+}
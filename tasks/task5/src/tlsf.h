@@ -0,0 +1,75 @@
+#ifndef TLSF_H
+#define TLSF_H
+
+#include <stddef.h>
+
+/*
+ * TLSF (Two-Level Segregated Fit) — аллокатор блоков произвольного размера
+ * с ограниченным временем tlsf_malloc/tlsf_free, не зависящим от числа
+ * блоков.
+ *
+ * Свободные блоки разложены по спискам двухуровневой сетки классов:
+ * первый уровень — степень двойки размера, второй делит ее на 32 равные
+ * части. Битовые карты непустых списков позволяют найти подходящий
+ * список двумя инструкциями поиска бита. Соседние свободные блоки
+ * сливаются при освобождении, поэтому фрагментация ограничена.
+ *
+ * Аллокатор не вызывает malloc и mmap: управляющая структура и все блоки
+ * лежат в области вызывающего кода, которую тот заранее блокирует (mlock)
+ * и прогревает. Функции не потокобезопасны.
+ */
+
+typedef struct Tlsf Tlsf;
+
+/**
+ * @brief Размечает область под аллокатор.
+ * 
+ * @param memory Начало области, выровненное на 8 байт.
+ * @param bytes Размер области (часть уходит под управляющую структуру).
+ * @return Указатель на аллокатор (совпадает с memory) или NULL, если
+ *         область слишком мала, велика или не выровнена.
+ */
+Tlsf* tlsf_create(void* memory, size_t bytes);
+
+/**
+ * @brief Выделяет size байт с выравниванием 8 байт.
+ * 
+ * @param tlsf Указатель на аллокатор.
+ * @param size Размер в байтах.
+ * @return Указатель на память или NULL, если подходящего блока нет.
+ */
+void* tlsf_malloc(Tlsf* tlsf, size_t size);
+
+/**
+ * @brief Выделяет size байт с выравниванием align.
+ * 
+ * @param tlsf Указатель на аллокатор.
+ * @param align Выравнивание, степень двойки.
+ * @param size Размер в байтах.
+ * @return Указатель на память или NULL, если подходящего блока нет.
+ */
+void* tlsf_memalign(Tlsf* tlsf, size_t align, size_t size);
+
+/**
+ * @brief Освобождает блок, сливая его со свободными соседями.
+ * 
+ * @param tlsf Указатель на аллокатор.
+ * @param ptr Указатель из tlsf_malloc()/tlsf_memalign() или NULL.
+ */
+void tlsf_free(Tlsf* tlsf, void* ptr);
+
+/**
+ * @brief Возвращает полезный размер выделенного блока.
+ * 
+ * @param ptr Указатель из tlsf_malloc()/tlsf_memalign().
+ */
+size_t tlsf_block_size(const void* ptr);
+
+/**
+ * @brief Возвращает суммарный размер свободных блоков.
+ * 
+ * @param tlsf Указатель на аллокатор.
+ */
+size_t tlsf_free_bytes(const Tlsf* tlsf);
+
+#endif // TLSF_H
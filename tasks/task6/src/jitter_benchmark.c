@@ -5,12 +5,14 @@
 #include <time.h>
 #include <sched.h>
 #include <math.h>
+#include "rt_clock.h"
+#include "rt_flight.h"
+#include "rt_hist.h"
 
 #define NUM_ITERATIONS 1000
-
-long long timespec_diff_ns(struct timespec start, struct timespec end) {
-    return (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
-}
+#define HIST_MAX_NS 1000000000LL // итерации дольше 1 с попадают в последнюю корзину
+#define FLIGHT_SIZE 100           // итераций в окне самописца
+#define FLIGHT_FILE "jitter_flight.txt"
 
 void work_function() {
     double result = 0.0;
@@ -25,6 +27,8 @@ int main(int argc, char *argv[]) {
         target_cpu = atoi(argv[1]);
         printf("Target CPU specified: %d\n", target_cpu);
     }
+    // Порог выброса в мкс: самописец хранит последние итерации перед ним
+    long long threshold_us = argc > 2 ? atoll(argv[2]) : 0;
 
     /* --- ЗАДАНИЕ 2: УСТАНОВКА CPU AFFINITY --- */
     if (target_cpu != -1) {
@@ -51,36 +55,65 @@ int main(int argc, char *argv[]) {
     }
     printf("Scheduler policy set to SCHED_FIFO with priority %d\n", sp.sched_priority);
 
-    long long latencies[NUM_ITERATIONS];
-    long long min_latency = -1, max_latency = 0, total_latency = 0;
+    // Метки TSC (или CLOCK_MONOTONIC, если TSC непригоден); стоимость
+    // самой пары меток вычитается во второй гистограмме
+    RtClock clock;
+    rt_clock_init(&clock, 0);
+    rt_clock_print(&clock);
+
+    RtHist* hist_raw = rt_hist_create(HIST_MAX_NS, RT_HIST_DEFAULT_PRECISION);
+    RtHist* hist = rt_hist_create(HIST_MAX_NS, RT_HIST_DEFAULT_PRECISION);
+    if (!hist_raw || !hist) {
+        fprintf(stderr, "rt_hist_create failed\n");
+        return 1;
+    }
+
+    RtTrace trace;
+    RtFlight* flight = NULL;
+    if (threshold_us > 0) {
+        if (rt_trace_open(&trace, 0) != 0) printf("tracefs trace_marker not available\n");
+        RtFlightConfig flight_config = {.capacity = FLIGHT_SIZE, .threshold_ns = threshold_us * 1000,
+                                        .name = "jitter_benchmark", .trace = &trace};
+        flight = rt_flight_create(&flight_config);
+        if (!flight) {
+            fprintf(stderr, "rt_flight_create failed\n");
+            return 1;
+        }
+        printf("Flight recorder: last %d iterations before the first one over %lld us\n", FLIGHT_SIZE,
+               threshold_us);
+    }
 
     printf("Starting benchmark...\n");
     for (int i = 0; i < NUM_ITERATIONS; ++i) {
-        struct timespec start, end;
-        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t start = rt_clock_start(&clock);
         
         work_function();
         
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        latencies[i] = timespec_diff_ns(start, end);
-
-        if (min_latency == -1 || latencies[i] < min_latency) {
-            min_latency = latencies[i];
-        }
-        if (latencies[i] > max_latency) {
-            max_latency = latencies[i];
-        }
-        total_latency += latencies[i];
+        uint64_t end = rt_clock_end(&clock);
+        int64_t elapsed = rt_clock_corrected_ns(&clock, start, end);
+        rt_hist_record(hist_raw, rt_clock_raw_ns(&clock, start, end));
+        rt_hist_record(hist, elapsed);
+        // Вне замера: самописец сам делает системный вызов
+        if (flight) rt_flight_record(flight, (uint64_t)i, (int64_t)rt_clock_monotonic_ns(), elapsed);
     }
 
-    double avg_latency = (double)total_latency / NUM_ITERATIONS;
-    long long jitter = max_latency - min_latency;
-
     printf("\n--- Benchmark Results ---\n");
-    printf("Min latency:    %lld ns\n", min_latency);
-    printf("Max latency:    %lld ns\n", max_latency);
-    printf("Avg latency:    %.2f ns\n", avg_latency);
-    printf("Jitter (max-min): %lld ns\n", jitter);
+    rt_hist_print(hist_raw, "Raw (including timer overhead):", "ns");
+    rt_hist_print(hist, "Overhead-corrected:", "ns");
+    printf("Jitter (max-min): %lld ns\n", (long long)(rt_hist_max(hist) - rt_hist_min(hist)));
+    if (flight) {
+        RtFlightRecord spike;
+        if (rt_flight_trigger(flight, &spike) == 0 && rt_flight_dump(flight, FLIGHT_FILE) == 0) {
+            printf("Spike %lld us at iteration %llu, window written to %s\n", (long long)(spike.latency_ns / 1000),
+                   (unsigned long long)spike.cycle, FLIGHT_FILE);
+        } else {
+            printf("No iteration over %lld us\n", threshold_us);
+        }
+        rt_flight_destroy(flight);
+        rt_trace_close(&trace);
+    }
+    rt_hist_destroy(hist_raw);
+    rt_hist_destroy(hist);
 
     return 0;
 }